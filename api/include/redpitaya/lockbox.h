@@ -29,6 +29,14 @@ extern "C" {
 #include <stdbool.h>
 
 #define ADC_BUFFER_SIZE             (16*1024)
+#define PSD_MAX_BINS                (ADC_BUFFER_SIZE/2 + 1)
+#define BODE_MAX_POINTS             1024
+
+/* Default DDR buffers of the AXI (streaming) acquisition. The memory must be
+ * reserved for the FPGA, e.g. by a reserved-memory node in the device tree. */
+#define ADC_AXI_DDR_START_CH1       0x01000000
+#define ADC_AXI_DDR_START_CH2       0x01800000
+#define ADC_AXI_DDR_SIZE            0x00800000
 
 /** @name Error codes
  *  Various error codes returned by the API.
@@ -87,6 +95,14 @@ extern "C" {
 #define RP_EOCF   24
 /** Incompatible config file version */
 #define RP_EICV   25
+/** Preset does not exist */
+#define RP_EPNF   26
+/** Config file is corrupted */
+#define RP_ECCF   27
+/** No data available */
+#define RP_ENDA   28
+/** Operation timed out */
+#define RP_ETMO   29
 
 #define SPECTR_OUT_SIG_LEN (2*1024)
 
@@ -237,6 +253,15 @@ typedef enum {
 } rp_acq_trig_state_t;
 
 
+/**
+ * Type representing the register-map backend used by the library.
+ */
+typedef enum {
+    RP_BACKEND_UIO, //!< FPGA registers mapped from /dev/uio/api (hardware)
+    RP_BACKEND_SIM  //!< Software register-map simulator, no hardware required
+} rp_backend_t;
+
+
 /**
  * Type representing the four PID controllers
  */
@@ -247,6 +272,36 @@ typedef enum {
     RP_PID_22  //!< Input B to Output B
 } rp_pid_t;
 
+/**
+ * Type representing the error signal of a PID controller
+ */
+typedef enum {
+    RP_PID_INPUT_DIRECT, //!< Input of the PID
+    RP_PID_INPUT_IQ_I,   //!< In-phase output of the IQ demodulator of the input
+    RP_PID_INPUT_IQ_Q    //!< Quadrature output of the IQ demodulator of the input
+} rp_pid_input_t;
+
+/**
+ * Type representing the reference oscillator of an IQ demodulator
+ */
+typedef enum {
+    RP_IQ_REF_NCO,   //!< Internal oscillator, set with rp_PIDSetIQFrequency
+    RP_IQ_REF_GEN_A, //!< Phase of signal generator A
+    RP_IQ_REF_GEN_B  //!< Phase of signal generator B
+} rp_iq_ref_t;
+
+/**
+ * Setpoint and gains of one PID, set together with rp_PIDSetParams
+ */
+typedef struct {
+    float setpoint; //!< Setpoint in V
+    float kp;       //!< P gain
+    float ki;       //!< I gain in 1/s
+    float kd;       //!< D gain in s
+    float kii;      //!< II gain (second integrator) in 1/s
+    float kg;       //!< Global gain
+} rp_pid_params_t;
+
 /**
  * Calibration parameters, stored in the EEPROM device
  */
@@ -267,10 +322,18 @@ typedef struct {
 } rp_calib_params_t;
 
 /**
- * Lockbox parameters for saving to and restoring from disk.
+ * Lockbox parameters for saving to and restoring from disk. The version is that
+ * of the configuration file format; files of older versions are still loaded.
  */
-#define LOCKBOX_CONFIG_VERSION 2
+#define LOCKBOX_CONFIG_VERSION 3
 #define CONFIG_FILE_PATH "/home/redpitaya/pid_settings.conf"
+
+/**
+ * Directory of the presets saved by rp_PresetStore, and maximum length of
+ * their names (including the terminating null character).
+ */
+#define PRESET_DIR_PATH "/home/redpitaya/presets"
+#define PRESET_NAME_LEN 32
 typedef struct {
     int config_version;
     float pid_setpoint[4];
@@ -300,8 +363,49 @@ typedef struct {
     float gen_offset[2];
     float gen_freq[2];
     rp_waveform_t gen_waveform[2];
+    rp_pid_input_t pid_input[4];
+    float iq_frequency[2];
+    float iq_phase[2];
+    float iq_bandwidth[2];
+    float iq_gain[2];
+    rp_iq_ref_t iq_reference[2];
 } rp_lockbox_params_t;
 
+/**
+ * Complete state of the lockbox, filled by rp_GetLockboxSnapshot
+ */
+typedef struct {
+    rp_lockbox_params_t params; //!< Configuration, as saved by rp_SaveLockboxConfig
+    bool pid_lock_status[4];    //!< Lock status of each PID
+    float in_voltage[2];        //!< Fast input voltages in V
+    float out_voltage[2];       //!< Fast output voltages in V
+    float ain_voltage[4];       //!< Voltages of the analog inputs AIN0-AIN3 in V
+} rp_lockbox_snapshot_t;
+
+/**
+ * Lock statistics of one PID, filled by rp_PIDGetLockStats. Times are in s;
+ * timestamps count from the start of the FPGA in steps of its clock period.
+ */
+typedef struct {
+    bool locked;            //!< Lock status when the statistics were read
+    uint32_t unlock_count;  //!< Number of transitions from locked to unlocked
+    double unlocked_time;   //!< Total time spent unlocked
+    double longest_outage;  //!< Longest time spent unlocked at once, including the current outage
+    double last_unlock;     //!< Timestamp of the last unlock, 0 if there was none
+    double last_relock;     //!< Timestamp of the last relock, 0 if there was none
+    double timestamp;       //!< Timestamp of the reading
+} rp_pid_lock_stats_t;
+
+/**
+ * One frequency of a transfer function measured by rp_BodeStart
+ */
+typedef struct {
+    float frequency;    //!< Excitation frequency in Hz
+    float amplitude[2]; //!< Amplitudes of the response on inputs A and B in V
+    float magnitude;    //!< Magnitude of the transfer function from input A to input B
+    float phase;        //!< Phase of the transfer function from input A to input B in degrees
+} rp_bode_point_t;
+
 
 /** @name General
  */
@@ -310,11 +414,24 @@ typedef struct {
 
 /**
  * Initializes the library. It must be called first, before any other library method.
+ * The simulator backend is used instead of the hardware if the environment variable
+ * LOCKBOX_BACKEND is set to "sim".
  * @return If the function is successful, the return value is RP_OK.
  * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
  */
 int rp_Init();
 
+/**
+ * Initializes the library with an explicitly selected register-map backend.
+ * With RP_BACKEND_SIM, the FPGA register map is emulated in memory (optionally in the
+ * POSIX shared memory object named by LOCKBOX_SIM_SHM), which allows running the
+ * library without /dev/uio/api.
+ * @param backend Register-map backend.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_InitWithBackend(rp_backend_t backend);
+
 int rp_CalibInit();
 
 /**
@@ -815,6 +932,18 @@ int rp_AcqGetTriggerSrc(rp_acq_trig_src_t* source);
  */
 int rp_AcqGetTriggerState(rp_acq_trig_state_t* state);
 
+/**
+ * Waits until the acquisition is done, i.e. the trigger occurred and the samples after the trigger
+ * have been written, upon which the FPGA disables the trigger source. The wait is driven by the
+ * acquisition done interrupt of the FPGA (/dev/uio/acq_trig) and falls back to polling the trigger
+ * source if the interrupt is not available. Returns immediately if the trigger source is disabled.
+ * @param timeout_ms Maximum time to wait in ms.
+ * @return If the function is successful, the return value is RP_OK. RP_ETMO is returned if the
+ * acquisition is not done within the timeout.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqWaitTrigger(uint32_t timeout_ms);
+
 /**
  * Sets the number of decimated data after trigger written into memory.
  * @param decimated_data_num Number of decimated data. It must not be higher than the ADC buffer size.
@@ -1086,6 +1215,196 @@ int rp_AcqGetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int rp_AcqGetBufSize(uint32_t* size);
 
+/**
+ * Sets the DDR ring buffer the AXI writer of the channel streams into.
+ * If not called, ADC_AXI_DDR_START_CH1/CH2 with ADC_AXI_DDR_SIZE are used.
+ * @param channel Channel A or B.
+ * @param address Physical start address of the buffer, page aligned.
+ * @param size Buffer size in bytes, multiple of 8.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiSetBuffer(rp_channel_t channel, uint32_t address, uint32_t size);
+
+/**
+ * Returns a read-only view of the DDR ring buffer of the channel. The samples are
+ * signed raw ADC counts; no data is copied.
+ * @param channel Channel A or B.
+ * @param buffer Returns a pointer to the first sample of the ring.
+ * @param samples Returns the ring size in samples.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiGetBuffer(rp_channel_t channel, const int16_t** buffer, uint32_t* samples);
+
+/**
+ * Enables or disables streaming of the channel into DDR. Streaming starts with the next
+ * rp_AcqStart() and runs gap-free as long as the acquisition is not triggered.
+ * @param channel Channel A or B.
+ * @param enable True to enable streaming.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiEnable(rp_channel_t channel, bool enable);
+
+/**
+ * Returns whether streaming of the channel into DDR is enabled.
+ * @param channel Channel A or B.
+ * @param enabled Returns true if the AXI writer of the channel is enabled.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiIsEnabled(rp_channel_t channel, bool* enabled);
+
+/**
+ * Returns the current write position of the AXI writer in the DDR ring, in samples.
+ * @param channel Channel A or B.
+ * @param pos Returns the write pointer.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiGetWritePointer(rp_channel_t channel, uint32_t* pos);
+
+/**
+ * Returns the samples written since the last consumed sample. If unread data was
+ * overwritten since the last call, the overflow counter is incremented and pos is
+ * moved to the oldest sample still in the ring.
+ * @param channel Channel A or B.
+ * @param pos Returns the ring position of the first unread sample.
+ * @param size Returns the number of unread samples.
+ * @param overflows Returns the number of overflows since streaming was enabled (may be NULL).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiGetNewData(rp_channel_t channel, uint32_t* pos, uint32_t* size, uint32_t* overflows);
+
+/**
+ * Marks samples as read, advancing the read pointer of the channel.
+ * @param channel Channel A or B.
+ * @param size Number of samples consumed.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiConsume(rp_channel_t channel, uint32_t size);
+
+/**
+ * Copies samples of the DDR ring buffer in raw ADC counts.
+ * @param channel Channel A or B.
+ * @param pos Ring position of the first sample.
+ * @param size Number of samples to copy. Returns the number of copied samples.
+ * @param buffer The output buffer.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiGetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
+
+/**
+ * Copies samples of the DDR ring buffer converted to volts.
+ * @param channel Channel A or B.
+ * @param pos Ring position of the first sample.
+ * @param size Number of samples to copy. Returns the number of copied samples.
+ * @param buffer The output buffer.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_AcqAxiGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
+
+/**
+ * Starts computing the noise spectral density of an input channel in the
+ * background (Welch's method). Acquisitions are taken continuously with the
+ * current decimation and gain; the scope must not be used otherwise until
+ * rp_PsdStop() is called. Each acquisition is split into segments, which are
+ * detrended and Hann windowed, and the spectra of the given number of segments
+ * are averaged. A running computation is restarted with the new settings.
+ * @param channel Channel A or B.
+ * @param segment_length Samples per segment, a power of two from 64 to ADC_BUFFER_SIZE.
+ * @param overlap Fraction of a segment that overlaps the next one, 0 <= overlap < 1.
+ * @param averages Number of segments averaged into one spectrum.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_PsdStart(rp_channel_t channel, uint32_t segment_length, float overlap, uint32_t averages);
+
+/**
+ * Stops computing the noise spectral density and stops the scope. The last
+ * spectrum stays available.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_PsdStop();
+
+/**
+ * Returns whether the noise spectral density is being computed.
+ * @param running Returns true while the computation is running.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_PsdIsRunning(bool* running);
+
+/**
+ * Copies the last averaged noise spectral density (one-sided, in V/sqrt(Hz)).
+ * Bin k is at the frequency k * bin_width, from DC to half the sampling rate.
+ * @param buffer The output buffer, at least segment_length / 2 + 1 (at most PSD_MAX_BINS) values.
+ * @param size Size of the buffer. Returns the number of bins.
+ * @param bin_width Returns the frequency spacing of the bins in Hz (may be NULL).
+ * @param count Returns the number of spectra completed since rp_PsdStart() (may be NULL).
+ * @return If the function is successful, the return value is RP_OK. RP_ENDA is
+ * returned if no spectrum has been completed yet.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_PsdGetSpectrum(float* buffer, uint32_t* size, float* bin_width, uint32_t* count);
+
+/**
+ * Starts measuring a transfer function in the background (swept sine). The
+ * signal generator of the excitation output is set to a sine with the given
+ * amplitude, which is added to the PID output, and stepped through points
+ * logarithmically spaced frequencies. At every frequency both inputs are
+ * demodulated at the excitation frequency, giving their amplitudes and the
+ * transfer function from input A to input B. For a loop gain measurement,
+ * input A measures the signal before and input B after the point where the
+ * excitation is injected. The scope must not be used otherwise until the
+ * measurement has finished; the generator, decimation and averaging settings
+ * are restored afterwards. A running measurement is restarted with the new
+ * settings.
+ * @param excitation Output channel A or B whose generator is used.
+ * @param amplitude Excitation amplitude in V.
+ * @param start_frequency First frequency in Hz, 1 Hz to 31.25 MHz.
+ * @param stop_frequency Last frequency in Hz, 1 Hz to 31.25 MHz.
+ * @param points Number of frequencies, 1 to BODE_MAX_POINTS.
+ * @param settle_time Time in s to wait after changing the frequency, at most 10 s.
+ * @param cycles Minimum number of excitation periods to integrate over, 1 to ADC_BUFFER_SIZE / 4.
+ * More periods are used where the buffer holds them.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_BodeStart(rp_channel_t excitation, float amplitude, float start_frequency, float stop_frequency,
+                 uint32_t points, float settle_time, uint32_t cycles);
+
+/**
+ * Stops the transfer function measurement. The frequencies measured so far
+ * stay available.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_BodeStop();
+
+/**
+ * Returns whether the transfer function measurement is running.
+ * @param running Returns true until all frequencies are measured.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_BodeIsRunning(bool* running);
+
+/**
+ * Copies the frequencies measured so far, in the order of the sweep.
+ * @param points The output buffer, at most BODE_MAX_POINTS points.
+ * @param size Size of the buffer. Returns the number of measured points.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that indicate an error.
+ */
+int rp_BodeGetData(rp_bode_point_t* points, uint32_t* size);
+
 
 ///@}
 /** @name Generate
@@ -1446,6 +1765,29 @@ int rp_PIDGetKii(rp_pid_t pid, float *kii);
 int rp_PIDSetKg(rp_pid_t pid, float kg);
 int rp_PIDGetKg(rp_pid_t pid, float *kg);
 
+/*
+ * Set the setpoint and all gains of the specified PID at once. All values are
+ * converted and checked before any register is written, and the new values
+ * take effect in the same clock cycle, so the controller never runs with a
+ * mix of old and new gains.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @param params The setpoint and gains to set (see rp_pid_params_t).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetParams(rp_pid_t pid, const rp_pid_params_t *params);
+
+/*
+ * Get the setpoint and all gains of the specified PID.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @param params Pointer where the setpoint and gains will be returned.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDGetParams(rp_pid_t pid, rp_pid_params_t *params);
+
 /*
  * Enable or disable the integrator reset of the specified PID.
  * @param pid The PID to use (see rp_pid_t documentation for details).
@@ -1585,6 +1927,28 @@ int rp_PIDGetEnable(rp_pid_t pid, bool *enabled);
  */
 int rp_PIDGetLockStatus(rp_pid_t pid, bool *lock_status);
 
+/**
+ * Get the lock statistics of the specified PID. They are counted by the FPGA
+ * from the lock status (see rp_PIDGetLockStatus) at every clock cycle, so that
+ * no outage is missed between two readings. The statistics of all PIDs are
+ * copied at the same time by each call.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @param stats Pointer where the statistics will be returned.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDGetLockStats(rp_pid_t pid, rp_pid_lock_stats_t *stats);
+
+/**
+ * Reset the lock statistics of the specified PID to zero.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDResetLockStats(rp_pid_t pid);
+
 /*
  * Set the relock stepsize of the specified PID using the ADC calibration values
  * stored in EEPROM.
@@ -1681,6 +2045,91 @@ int rp_PIDGetExtResetEnable(rp_pid_t pid, bool *enabled);
 int rp_PIDSetExtResetInput(rp_pid_t pid, rp_dpin_t pin);
 int rp_PIDGetExtResetInput(rp_pid_t pid, rp_dpin_t *pin);
 
+/*
+ * Select the error signal of the specified PID: its input, or the I or Q
+ * output of the IQ demodulator of that input. The direct input adds no latency.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @param input Error signal (see rp_pid_input_t documentation for details).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetInput(rp_pid_t pid, rp_pid_input_t input);
+
+/*
+ * Get the error signal of the specified PID.
+ * @param pid The PID to use (see rp_pid_t documentation for details).
+ * @param input Pointer where the error signal will be returned.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDGetInput(rp_pid_t pid, rp_pid_input_t *input);
+
+/*
+ * Set the frequency of the internal reference oscillator of the IQ demodulator
+ * of the specified input. The resolution is 125 MHz / 2^32.
+ * @param channel The input channel (see rp_channel_t documentation for details).
+ * @param frequency Frequency in Hz, 0 - 62.5 MHz.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetIQFrequency(rp_channel_t channel, float frequency);
+int rp_PIDGetIQFrequency(rp_channel_t channel, float *frequency);
+
+/*
+ * Set the phase of the reference of the IQ demodulator of the specified input.
+ * An input A*sin(reference + a) gives I = A*cos(a - phase) and
+ * Q = A*sin(a - phase).
+ * @param channel The input channel (see rp_channel_t documentation for details).
+ * @param phase Phase in degrees.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetIQPhase(rp_channel_t channel, float phase);
+int rp_PIDGetIQPhase(rp_channel_t channel, float *phase);
+
+/*
+ * Set the corner frequency of the two first order low-pass filters of the IQ
+ * demodulator of the specified input. It is rounded to 125 MHz / (2*pi * 2^n)
+ * with n = 0 - 24, i.e. down to about 1.2 Hz.
+ * @param channel The input channel (see rp_channel_t documentation for details).
+ * @param bandwidth Corner frequency in Hz.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetIQBandwidth(rp_channel_t channel, float bandwidth);
+int rp_PIDGetIQBandwidth(rp_channel_t channel, float *bandwidth);
+
+/*
+ * Set the gain of the I and Q outputs of the IQ demodulator of the specified
+ * input. It is rounded to a power of two from 1 to 16384; the outputs saturate
+ * at full scale.
+ * @param channel The input channel (see rp_channel_t documentation for details).
+ * @param gain Gain.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetIQGain(rp_channel_t channel, float gain);
+int rp_PIDGetIQGain(rp_channel_t channel, float *gain);
+
+/*
+ * Select the reference of the IQ demodulator of the specified input: its
+ * internal oscillator or the phase of a signal generator channel, which must
+ * then output one of the built-in waveforms.
+ * @param channel The input channel (see rp_channel_t documentation for details).
+ * @param reference Reference (see rp_iq_ref_t documentation for details).
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PIDSetIQReference(rp_channel_t channel, rp_iq_ref_t reference);
+int rp_PIDGetIQReference(rp_channel_t channel, rp_iq_ref_t *reference);
+
 /*
  * Set the minimum DAC output voltage of the specified channel using the
  * calibration values stored in EEPROM.
@@ -1738,13 +2187,57 @@ int rp_LimitGetMax(rp_channel_t channel, float *value);
 int rp_SaveLockboxConfig();
 
 /*
- * Load the lockbox configuration from CONFIG_FILE_PATH.
+ * Load the lockbox configuration from CONFIG_FILE_PATH. Settings that are not
+ * contained in the file keep their current values.
  * @return If the function is successful, the return value is RP_OK.
  * If the function is unsuccessful, the return value is any of RP_E* values that
  * indicate an error.
  */
 int rp_LoadLockboxConfig();
 
+/*
+ * Get the complete configuration together with the lock status and the
+ * input and output voltages in a single call.
+ * @param snapshot Pointer where the state will be returned.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_GetLockboxSnapshot(rp_lockbox_snapshot_t *snapshot);
+
+/*
+ * Store the current PID and output limit configuration as a named preset,
+ * in memory and as PRESET_DIR_PATH/<name>.preset. The preset holds the
+ * register values themselves, so applying it needs no conversions.
+ * An existing preset with the same name is replaced.
+ * @param name Name of the preset, up to PRESET_NAME_LEN - 1 letters, digits,
+ * '-' or '_'.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PresetStore(const char *name);
+
+/*
+ * Apply a preset stored with rp_PresetStore. All registers are written in
+ * one burst; the setpoints and gains of all four PIDs change in the same
+ * clock cycle. The signal generators are not part of a preset.
+ * @param name Name of the preset.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PresetApply(const char *name);
+
+/*
+ * Delete a preset from memory and from PRESET_DIR_PATH.
+ * @param name Name of the preset.
+ * @return If the function is successful, the return value is RP_OK.
+ * If the function is unsuccessful, the return value is any of RP_E* values that
+ * indicate an error.
+ */
+int rp_PresetDelete(const char *name);
+
 float rp_CmnCnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
 
 #ifdef __cplusplus
@@ -14,7 +14,10 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "common.h"
 #include "calib.h"
@@ -61,6 +64,22 @@ static const uint32_t GAIN_HI_FILT_BB = 0x2F38B;
 static const uint32_t GAIN_HI_FILT_PP = 0x2666;
 static const uint32_t GAIN_HI_FILT_KK = 0xd9999a;
 
+/* @brief State of the AXI (DDR) streaming acquisition of one channel */
+typedef struct {
+    uint32_t address;           // Physical start address of the DDR ring
+    uint32_t samples;           // Ring size in samples
+    int16_t* data;              // Mapped view of the ring
+    uint32_t read_pos;          // Oldest unread sample
+    uint32_t last_wp;           // Write pointer seen at the last poll
+    uint32_t overflows;         // Number of times unread data was overwritten
+    struct timespec last_poll;  // Time of the last poll
+} axi_stream_t;
+
+static axi_stream_t axi_stream[2] = {
+    { .address = ADC_AXI_DDR_START_CH1, .samples = 0, .data = NULL },
+    { .address = ADC_AXI_DDR_START_CH2, .samples = 0, .data = NULL },
+};
+
 #define GET_OFFSET_CH1(gain, calib) (gain == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs)
 #define GET_OFFSET_CH2(gain, calib) (gain == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs)
 #define GET_OFFSET(channel, gain, calib) (channel == RP_CH_1 ? GET_OFFSET_CH1(gain, calib) : GET_OFFSET_CH2(gain, calib) )
@@ -362,6 +381,38 @@ int acq_GetTriggerState(rp_acq_trig_state_t* state)
     return RP_OK;
 }
 
+/**
+ * Waits until the trigger source is disabled by the FPGA at the end of an
+ * acquisition. The interrupt is armed before the trigger source is checked, so
+ * an acquisition finishing in between ends the wait immediately. Without the
+ * interrupt, the trigger source is polled every ACQ_POLL_US.
+ */
+int acq_WaitTrigger(uint32_t timeout_ms)
+{
+    struct timespec start, now;
+    rp_acq_trig_src_t source;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true) {
+        bool irq = (cmn_ArmIrq() == RP_OK);
+        ECHECK(acq_GetTriggerSrc(&source));
+        if (source == RP_TRIG_SRC_DISABLED) {
+            return RP_OK;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t elapsed = (int64_t) (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed >= timeout_ms) {
+            return RP_ETMO;
+        }
+
+        uint32_t remaining = timeout_ms - (uint32_t) elapsed;
+        if (!irq || cmn_WaitIrq(remaining) != RP_OK) {
+            usleep(MIN(remaining * 1000ULL, ACQ_POLL_US));
+        }
+    }
+}
+
 int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue)
 {
     int32_t trig_dly;
@@ -585,19 +636,71 @@ static uint32_t getSizeFromStartEndPos(uint32_t start_pos, uint32_t end_pos)
     return end_pos - start_pos + 1;
 }
 
+/**
+ * Returns the parameters for converting the counts of the given channel to volts.
+ */
+static void getConversionParams(rp_channel_t channel, float* gainV, uint32_t* calibScale, int32_t* dc_offs)
+{
+    rp_pinState_t gain;
+    acq_GetGainV(channel, gainV);
+    acq_GetGain(channel, &gain);
+
+    rp_calib_params_t calib = calib_GetParams();
+    *dc_offs = GET_OFFSET(channel, gain, calib);
+    *calibScale = calib_GetFrontEndScale(channel, gain);
+}
+
 uint32_t acq_GetNormalizedDataPos(uint32_t pos)
 {
     return (pos % ADC_BUFFER_SIZE);
 }
 
-int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+/**
+ * Copies one contiguous span of the sample buffer. Aligned pairs of samples are
+ * read with single 64-bit loads to halve the number of bus transactions.
+ */
+static void copySpan(const volatile uint32_t* src, uint32_t* dst, uint32_t size)
 {
+    uint32_t i = 0;
 
-    *size = MIN(*size, ADC_BUFFER_SIZE);
+    if ((size > 0) && ((uintptr_t) src & 0x7)) {
+        dst[i] = src[i];
+        i++;
+    }
+    for (; i + 1 < size; i += 2) {
+        uint64_t pair = *(const volatile uint64_t*) &src[i];
+        memcpy(&dst[i], &pair, sizeof(pair));
+    }
+    if (i < size) {
+        dst[i] = src[i];
+    }
+}
 
-    uint32_t cnts;
+/**
+ * Copies size samples (raw 32-bit buffer words) of the ring buffer, starting at
+ * pos, into buffer. The ring is read in at most two contiguous spans, so no
+ * wrap-around arithmetic is done per sample.
+ */
+int acq_CopyRing(rp_channel_t channel, uint32_t pos, uint32_t size, uint32_t* buffer)
+{
+    if (size > ADC_BUFFER_SIZE) {
+        return RP_BTS;
+    }
 
     const volatile uint32_t* raw_buffer = getRawBuffer(channel);
+    pos = acq_GetNormalizedDataPos(pos);
+
+    uint32_t first = MIN(size, ADC_BUFFER_SIZE - pos);
+    copySpan(&raw_buffer[pos], buffer, first);
+    copySpan(raw_buffer, &buffer[first], size - first);
+
+    return RP_OK;
+}
+
+int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+{
+
+    *size = MIN(*size, ADC_BUFFER_SIZE);
 
     rp_pinState_t gain;
     acq_GetGain(channel, &gain);
@@ -605,10 +708,11 @@ int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t*
     rp_calib_params_t calib = calib_GetParams();
     int32_t dc_offs = GET_OFFSET(channel, gain, calib);
 
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
+    uint32_t cnts[*size];
+    acq_CopyRing(channel, pos, *size, cnts);
 
-        buffer[i] = cmn_CalibCnts(ADC_BITS, cnts, dc_offs);
+    for (uint32_t i = 0; i < (*size); ++i) {
+        buffer[i] = cmn_CalibCnts(ADC_BITS, cnts[i] & ADC_BITS_MAK, dc_offs);
     }
 
     return RP_OK;
@@ -619,12 +723,15 @@ int acq_GetDataRawV2(uint32_t pos, uint32_t* size, uint16_t* buffer, uint16_t* b
 {
 
     *size = MIN(*size, ADC_BUFFER_SIZE);
-    const volatile uint32_t* raw_buffer = getRawBuffer(RP_CH_1);
-    const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
+
+    uint32_t cnts1[*size];
+    uint32_t cnts2[*size];
+    acq_CopyRing(RP_CH_1, pos, *size, cnts1);
+    acq_CopyRing(RP_CH_2, pos, *size, cnts2);
 
     for (uint32_t i = 0; i < (*size); ++i) {
-        buffer[i] = (raw_buffer[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
-        buffer2[i] = (raw_buffer2[(pos + i) % ADC_BUFFER_SIZE]) & ADC_BITS_MAK;
+        buffer[i] = cnts1[i] & ADC_BITS_MAK;
+        buffer2[i] = cnts2[i] & ADC_BITS_MAK;
     }
 
     return RP_OK;
@@ -677,21 +784,14 @@ int acq_GetDataV(rp_channel_t channel,  uint32_t pos, uint32_t* size, float* buf
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
     float gainV;
-    rp_pinState_t gain;
-    acq_GetGainV(channel, &gainV);
-    acq_GetGain(channel, &gain);
+    uint32_t calibScale;
+    int32_t dc_offs;
+    getConversionParams(channel, &gainV, &calibScale, &dc_offs);
 
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs = GET_OFFSET(channel, gain, calib);
-    uint32_t calibScale = calib_GetFrontEndScale(channel, gain);
+    uint32_t cnts[*size];
+    acq_CopyRing(channel, pos, *size, cnts);
 
-    const volatile uint32_t* raw_buffer = getRawBuffer(channel);
-
-    uint32_t cnts;
-    for (uint32_t i = 0; i < (*size); ++i) {
-        cnts = raw_buffer[(pos + i) % ADC_BUFFER_SIZE];
-        buffer[i] = cmn_CnvCntToV(ADC_BITS, cnts, gainV, calibScale, dc_offs, 0.0);
-    }
+    cmn_CnvCntToVBulk(ADC_BITS, cnts, buffer, *size, gainV, calibScale, dc_offs, 0.0);
 
     return RP_OK;
 }
@@ -701,40 +801,18 @@ int acq_GetDataV2(uint32_t pos, uint32_t* size, float* buffer1, float* buffer2)
     *size = MIN(*size, ADC_BUFFER_SIZE);
 
     float gainV1, gainV2;
-    rp_pinState_t gain1, gain2;
-    acq_GetGainV(RP_CH_1, &gainV1);
-    acq_GetGain(RP_CH_1, &gain1);
-    acq_GetGainV(RP_CH_2, &gainV2);
-    acq_GetGain(RP_CH_2, &gain2);
-
-    rp_calib_params_t calib = calib_GetParams();
-    int32_t dc_offs1 = gain1 == RP_HIGH ? calib.fe_ch1_hi_offs : calib.fe_ch1_lo_offs;
-    uint32_t calibScale1 = calib_GetFrontEndScale(RP_CH_1, gain1);
-
-    int32_t dc_offs2 = gain2 == RP_HIGH ? calib.fe_ch2_hi_offs : calib.fe_ch2_lo_offs;
-    uint32_t calibScale2 = calib_GetFrontEndScale(RP_CH_2, gain2);
-
-    const volatile uint32_t* raw_buffer1 = getRawBuffer(RP_CH_1);
-    const volatile uint32_t* raw_buffer2 = getRawBuffer(RP_CH_2);
+    uint32_t calibScale1, calibScale2;
+    int32_t dc_offs1, dc_offs2;
+    getConversionParams(RP_CH_1, &gainV1, &calibScale1, &dc_offs1);
+    getConversionParams(RP_CH_2, &gainV2, &calibScale2, &dc_offs2);
 
     uint32_t cnts1[*size];
     uint32_t cnts2[*size];
-    uint32_t* ptr1 = cnts1;
-    uint32_t* ptr2 = cnts2;
-
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *ptr1++ = raw_buffer1[pos];
-        *ptr2++ = raw_buffer2[pos];
-        pos = (pos + 1) % ADC_BUFFER_SIZE;
-    }
+    acq_CopyRing(RP_CH_1, pos, *size, cnts1);
+    acq_CopyRing(RP_CH_2, pos, *size, cnts2);
 
-    ptr1 = cnts1;
-    ptr2 = cnts2;
-
-    for (uint32_t i = 0; i < (*size); ++i) {
-        *buffer1++ = cmn_CnvCntToV(ADC_BITS, *ptr1++, gainV1, calibScale1, dc_offs1, 0.0);
-        *buffer2++ = cmn_CnvCntToV(ADC_BITS, *ptr2++, gainV2, calibScale2, dc_offs2, 0.0);
-    }
+    cmn_CnvCntToVBulk(ADC_BITS, cnts1, buffer1, *size, gainV1, calibScale1, dc_offs1, 0.0);
+    cmn_CnvCntToVBulk(ADC_BITS, cnts2, buffer2, *size, gainV2, calibScale2, dc_offs2, 0.0);
 
     return RP_OK;
 }
@@ -780,6 +858,276 @@ int acq_GetBufferSize(uint32_t *size) {
     return RP_OK;
 }
 
+/**
+ * Acquires a buffer of samples that were all written after this call: the scope
+ * is reset and armed, triggered once the pre-trigger counter shows that the
+ * whole buffer has been written and then waited for until it has written the
+ * samples after the trigger, which resets the trigger source. Arming waits for
+ * the reset to be taken, so that the counter of the previous acquisition is
+ * never mistaken for the new one. Returns early with *done false when *running
+ * is cleared by another thread.
+ */
+int acq_AcquireBuffer(const volatile bool* running, bool* done)
+{
+    bool reset;
+    uint32_t counter = 0;
+    int result;
+
+    *done = false;
+    ECHECK(osc_ResetWriteStateMachine());
+    ECHECK(osc_GetResetWriteStateMachine(&reset));
+    while (reset) {
+        if (!*running) {
+            return RP_OK;
+        }
+        usleep(ACQ_POLL_US);
+        ECHECK(osc_GetResetWriteStateMachine(&reset));
+    }
+
+    ECHECK(acq_Start());
+    while (counter < ADC_BUFFER_SIZE) {
+        if (!*running) {
+            return RP_OK;
+        }
+        usleep(ACQ_POLL_US);
+        ECHECK(acq_GetPreTriggerCounter(&counter));
+    }
+
+    ECHECK(acq_SetTriggerSrc(RP_TRIG_SRC_NOW));
+    while ((result = acq_WaitTrigger(ACQ_WAIT_MS)) == RP_ETMO) {
+        if (!*running) {
+            return RP_OK;
+        }
+    }
+    ECHECK(result);
+    *done = true;
+    return RP_OK;
+}
+
+/**
+ * AXI (DDR) streaming acquisition
+ *
+ * While the scope is armed and no trigger occurs, the AXI writers of the scope
+ * continuously write the decimated samples of each enabled channel as int16 into
+ * a ring in DDR. The ring is mapped into the process, so consumers can read it
+ * without copying; the read pointer is tracked here.
+ */
+static axi_stream_t* getAxiStream(rp_channel_t channel)
+{
+    if ((channel != RP_CH_1) && (channel != RP_CH_2)) {
+        return NULL;
+    }
+
+    axi_stream_t* stream = &axi_stream[channel];
+    if (!stream->data) {
+        // Lazily map the default buffer
+        if (acq_axi_SetBuffer(channel, stream->address, ADC_AXI_DDR_SIZE) != RP_OK) {
+            return NULL;
+        }
+    }
+    return stream;
+}
+
+static uint32_t getAxiElapsedSamples(axi_stream_t* stream)
+{
+    struct timespec now;
+    uint32_t decimation;
+    bool armed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t ns = (int64_t) (now.tv_sec - stream->last_poll.tv_sec) * 1000000000LL
+               + (now.tv_nsec - stream->last_poll.tv_nsec);
+    stream->last_poll = now;
+
+    osc_GetWriteDataIntoMemory(&armed);
+    if (!armed) {
+        return 0;
+    }
+
+    acq_GetDecimationFactor(&decimation);
+    uint64_t elapsed = (uint64_t) ns / (ADC_SAMPLE_PERIOD * decimation);
+    return (uint32_t) MIN(elapsed, UINT32_MAX);
+}
+
+int acq_axi_SetBuffer(rp_channel_t channel, uint32_t address, uint32_t size)
+{
+    if ((channel != RP_CH_1) && (channel != RP_CH_2)) {
+        return RP_EPN;
+    }
+    if ((address % sysconf(_SC_PAGESIZE)) || (size == 0) || (size % 8)) {
+        return RP_EOOR;
+    }
+
+    axi_stream_t* stream = &axi_stream[channel];
+    if (stream->data) {
+        cmn_UnmapDDR(stream->samples * sizeof(int16_t), (void**) &stream->data);
+    }
+
+    ECHECK(cmn_MapDDR(size, address, (void**) &stream->data));
+    stream->address = address;
+    stream->samples = size / sizeof(int16_t);
+    stream->read_pos = stream->last_wp = 0;
+    stream->overflows = 0;
+
+    // The stop address is the last 64-bit word of the ring
+    return osc_axi_SetBufferAddress(channel, address, address + size - 8);
+}
+
+int acq_axi_GetBuffer(rp_channel_t channel, const int16_t** buffer, uint32_t* samples)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+    *buffer = stream->data;
+    *samples = stream->samples;
+    return RP_OK;
+}
+
+int acq_axi_Enable(rp_channel_t channel, bool enable)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    ECHECK(osc_axi_Enable(channel, enable));
+    if (enable) {
+        // Start reading at the current write position
+        acq_axi_GetWritePointer(channel, &stream->read_pos);
+        stream->last_wp = stream->read_pos;
+        stream->overflows = 0;
+        clock_gettime(CLOCK_MONOTONIC, &stream->last_poll);
+    }
+    return RP_OK;
+}
+
+int acq_axi_IsEnabled(rp_channel_t channel, bool* enabled)
+{
+    return osc_axi_IsEnabled(channel, enabled);
+}
+
+int acq_axi_GetWritePointer(rp_channel_t channel, uint32_t* pos)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    uint32_t address;
+    ECHECK(osc_axi_GetWritePointer(channel, &address));
+    if ((address < stream->address) || (address >= stream->address + stream->samples * sizeof(int16_t) + 8)) {
+        // Writer not started yet
+        *pos = 0;
+        return RP_OK;
+    }
+    *pos = ((address - stream->address) / sizeof(int16_t)) % stream->samples;
+    return RP_OK;
+}
+
+/**
+ * Returns the position and number of samples written since the last consumed
+ * sample. If the writer has lapped the reader since the last call (estimated
+ * from the elapsed time and the sampling rate), the overflow counter is
+ * incremented and reading restarts at the oldest sample still in the ring.
+ */
+int acq_axi_GetNewData(rp_channel_t channel, uint32_t* pos, uint32_t* size, uint32_t* overflows)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    uint32_t n = stream->samples;
+    uint32_t wp;
+    ECHECK(acq_axi_GetWritePointer(channel, &wp));
+
+    uint32_t unread = (stream->last_wp + n - stream->read_pos) % n;
+    uint32_t elapsed = getAxiElapsedSamples(stream);
+    // Keep one 64-bit word (4 samples) of margin to the word being written
+    if ((uint64_t) unread + elapsed >= n - 4) {
+        stream->overflows++;
+        stream->read_pos = (wp + 4) % n;
+    }
+    stream->last_wp = wp;
+
+    *pos = stream->read_pos;
+    *size = (wp + n - stream->read_pos) % n;
+    if (overflows) {
+        *overflows = stream->overflows;
+    }
+    return RP_OK;
+}
+
+int acq_axi_Consume(rp_channel_t channel, uint32_t size)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    uint32_t n = stream->samples;
+    uint32_t unread = (stream->last_wp + n - stream->read_pos) % n;
+    stream->read_pos = (stream->read_pos + MIN(size, unread)) % n;
+    return RP_OK;
+}
+
+int acq_axi_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    uint32_t n = stream->samples;
+    *size = MIN(*size, n);
+    pos %= n;
+
+    uint32_t first = MIN(*size, n - pos);
+    memcpy(buffer, &stream->data[pos], first * sizeof(int16_t));
+    memcpy(&buffer[first], stream->data, (*size - first) * sizeof(int16_t));
+    return RP_OK;
+}
+
+int acq_axi_GetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer)
+{
+    axi_stream_t* stream = getAxiStream(channel);
+    if (!stream) {
+        return RP_EMMD;
+    }
+
+    float gainV;
+    uint32_t calibScale;
+    int32_t dc_offs;
+    getConversionParams(channel, &gainV, &calibScale, &dc_offs);
+
+    uint32_t n = stream->samples;
+    *size = MIN(*size, n);
+
+    // Convert in blocks of the BRAM buffer size to bound the stack usage
+    uint32_t cnts[ADC_BUFFER_SIZE];
+    for (uint32_t done = 0; done < *size; ) {
+        uint32_t p = (pos + done) % n;
+        uint32_t chunk = MIN(MIN(*size - done, n - p), ADC_BUFFER_SIZE);
+        for (uint32_t i = 0; i < chunk; ++i) {
+            cnts[i] = (uint16_t) stream->data[p + i];
+        }
+        cmn_CnvCntToVBulk(ADC_BITS, cnts, &buffer[done], chunk, gainV, calibScale, dc_offs, 0.0);
+        done += chunk;
+    }
+    return RP_OK;
+}
+
+int acq_axi_Release()
+{
+    for (int ch = 0; ch < 2; ch++) {
+        if (axi_stream[ch].data) {
+            cmn_UnmapDDR(axi_stream[ch].samples * sizeof(int16_t), (void**) &axi_stream[ch].data);
+        }
+    }
+    return RP_OK;
+}
+
 /**
  * Sets default configuration
  * @return
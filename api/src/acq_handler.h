@@ -19,6 +19,9 @@
 #include <stdbool.h>
 #include "redpitaya/lockbox.h"
 
+#define ACQ_POLL_US         1000        // Poll interval while waiting for the scope
+#define ACQ_WAIT_MS         100         // Interval to check for cancellation while waiting for a trigger
+
 int acq_SetArmKeep(bool enable);
 int acq_SetGain(rp_channel_t channel, rp_pinState_t state);
 int acq_GetGain(rp_channel_t channel, rp_pinState_t* state);
@@ -34,6 +37,7 @@ int acq_GetAveraging(bool* enable);
 int acq_SetTriggerSrc(rp_acq_trig_src_t source);
 int acq_GetTriggerSrc(rp_acq_trig_src_t* source);
 int acq_GetTriggerState(rp_acq_trig_state_t* state);
+int acq_WaitTrigger(uint32_t timeout_ms);
 int acq_SetTriggerDelay(int32_t decimated_data_num, bool updateMaxValue);
 int acq_GetTriggerDelay(int32_t* decimated_data_num);
 int acq_SetTriggerDelayNs(int64_t time_ns, bool updateMaxValue);
@@ -54,6 +58,7 @@ int acq_Stop();
 int acq_Reset();
 
 uint32_t acq_GetNormalizedDataPos(uint32_t pos);
+int acq_CopyRing(rp_channel_t channel, uint32_t pos, uint32_t size, uint32_t* buffer);
 int acq_GetDataPosRaw(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, int16_t* buffer, uint32_t *buffer_size);
 int acq_GetDataPosV(rp_channel_t channel, uint32_t start_pos, uint32_t end_pos, float* buffer, uint32_t *buffer_size);
 int acq_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
@@ -66,6 +71,18 @@ int acq_GetOldestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 int acq_GetLatestDataV(rp_channel_t channel, uint32_t* size, float* buffer);
 
 int acq_GetBufferSize(uint32_t *size);
+int acq_AcquireBuffer(const volatile bool* running, bool* done);
+
+int acq_axi_SetBuffer(rp_channel_t channel, uint32_t address, uint32_t size);
+int acq_axi_GetBuffer(rp_channel_t channel, const int16_t** buffer, uint32_t* samples);
+int acq_axi_Enable(rp_channel_t channel, bool enable);
+int acq_axi_IsEnabled(rp_channel_t channel, bool* enabled);
+int acq_axi_GetWritePointer(rp_channel_t channel, uint32_t* pos);
+int acq_axi_GetNewData(rp_channel_t channel, uint32_t* pos, uint32_t* size, uint32_t* overflows);
+int acq_axi_Consume(rp_channel_t channel, uint32_t size);
+int acq_axi_GetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer);
+int acq_axi_GetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer);
+int acq_axi_Release();
 
 int acq_SetDefault();
 
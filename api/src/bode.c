@@ -0,0 +1,275 @@
+/**
+ * @brief Red Pitaya library transfer function analyzer implementation
+ *
+ * For every frequency the decimation is chosen as the lowest one whose buffer
+ * still holds the requested number of excitation periods, so that the sweep
+ * time is dominated by the measurement itself. After the settle time a buffer
+ * of fresh samples (see acq_AcquireBuffer) is taken with the scope averaging
+ * enabled. The generator frequency is quantized to its phase increment and
+ * demodulation uses that exact frequency over the largest whole number of
+ * periods in the buffer, so that the offset and the harmonics of the response
+ * do not leak into the result.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "redpitaya/lockbox.h"
+#include "common.h"
+#include "acq_handler.h"
+#include "gen_handler.h"
+#include "generate.h"
+#include "bode.h"
+
+// Decimation factors of RP_DEC_1 .. RP_DEC_65536
+static const uint32_t DECIMATION_FACTOR[] = { 1, 8, 64, 1024, 8192, 65536 };
+#define DECIMATION_COUNT    (sizeof(DECIMATION_FACTOR) / sizeof(DECIMATION_FACTOR[0]))
+
+static pthread_t bode_thread;
+static bool bode_started = false;
+static volatile bool bode_running = false;
+
+// Settings of the running sweep
+static rp_channel_t bode_excitation;
+static double bode_start_frequency;
+static double bode_stop_frequency;
+static uint32_t bode_points;
+static float bode_settle_time;
+static uint32_t bode_cycles;
+
+// Settings restored after the sweep
+static bool saved_enabled;
+static float saved_amplitude;
+static float saved_frequency;
+static rp_waveform_t saved_waveform;
+static rp_acq_decimation_t saved_decimation;
+static bool saved_averaging;
+
+static float bode_signal[2][ADC_BUFFER_SIZE];
+
+// Measured points
+static pthread_mutex_t bode_mutex = PTHREAD_MUTEX_INITIALIZER;
+static rp_bode_point_t bode_data[BODE_MAX_POINTS];
+static uint32_t bode_count = 0;
+
+
+/* Frequency the generator actually produces, given its phase increment resolution */
+static double generatorFrequency(double frequency)
+{
+    const double resolution = DAC_FREQUENCY / (65536.0 * BUFFER_LENGTH);
+    return round(frequency / resolution) * resolution;
+}
+
+static rp_acq_decimation_t chooseDecimation(double frequency)
+{
+    for (uint32_t i = 0; i < DECIMATION_COUNT - 1; i++) {
+        double duration = (double) ADC_BUFFER_SIZE * DECIMATION_FACTOR[i] / DAC_FREQUENCY;
+        if (duration * frequency >= bode_cycles) {
+            return (rp_acq_decimation_t) i;
+        }
+    }
+    return (rp_acq_decimation_t) (DECIMATION_COUNT - 1);
+}
+
+/* Complex amplitude of the component at the normalized angular frequency omega */
+static double complex demodulate(const float *data, uint32_t length, double omega)
+{
+    const double complex step = cexp(-I * omega);
+    double complex phasor = 1;
+    double complex sum = 0;
+    double mean = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        mean += data[i];
+    }
+    mean /= length;
+    for (uint32_t i = 0; i < length; i++) {
+        sum += (data[i] - mean) * phasor;
+        phasor *= step;
+    }
+    return 2 * sum / length;
+}
+
+static bool settle()
+{
+    for (uint32_t i = 0; i * ACQ_POLL_US < bode_settle_time * 1e6; i++) {
+        if (!bode_running) {
+            return false;
+        }
+        usleep(ACQ_POLL_US);
+    }
+    return bode_running;
+}
+
+static int measure(uint32_t index, rp_bode_point_t *point, bool *done)
+{
+    double frequency = bode_start_frequency;
+    float sampling_rate;
+    uint32_t size = ADC_BUFFER_SIZE;
+
+    if (bode_points > 1) {
+        frequency *= pow(bode_stop_frequency / bode_start_frequency, (double) index / (bode_points - 1));
+    }
+    frequency = generatorFrequency(frequency);
+
+    *done = false;
+    ECHECK(gen_setFrequency(bode_excitation, frequency));
+    ECHECK(acq_SetDecimation(chooseDecimation(frequency)));
+    ECHECK(acq_GetSamplingRateHz(&sampling_rate));
+    if (!settle()) {
+        return RP_OK;
+    }
+
+    ECHECK(acq_AcquireBuffer(&bode_running, done));
+    if (!*done) {
+        return RP_OK;
+    }
+    ECHECK(acq_GetOldestDataV(RP_CH_1, &size, bode_signal[RP_CH_1]));
+    ECHECK(acq_GetOldestDataV(RP_CH_2, &size, bode_signal[RP_CH_2]));
+
+    // Integrate over whole periods
+    double periods = floor(size * frequency / sampling_rate);
+    uint32_t length = (uint32_t) (periods * sampling_rate / frequency);
+    double omega = 2 * M_PI * frequency / sampling_rate;
+    double complex a = demodulate(bode_signal[RP_CH_1], length, omega);
+    double complex b = demodulate(bode_signal[RP_CH_2], length, omega);
+
+    point->frequency = frequency;
+    point->amplitude[RP_CH_1] = cabs(a);
+    point->amplitude[RP_CH_2] = cabs(b);
+    point->magnitude = (a != 0) ? cabs(b / a) : 0;
+    point->phase = (a != 0) ? carg(b / a) * 180 / M_PI : 0;
+    return RP_OK;
+}
+
+static void restore()
+{
+    acq_Stop();
+    acq_SetDecimation(saved_decimation);
+    acq_SetAveraging(saved_averaging);
+    gen_setWaveform(bode_excitation, saved_waveform);
+    gen_setAmplitude(bode_excitation, saved_amplitude);
+    gen_setFrequency(bode_excitation, saved_frequency);
+    if (!saved_enabled) {
+        gen_Disable(bode_excitation);
+    }
+}
+
+static void *bodeThread(void *arg)
+{
+    for (uint32_t i = 0; i < bode_points; i++) {
+        rp_bode_point_t point;
+        bool done;
+        int result = measure(i, &point, &done);
+        if (result != RP_OK) {
+            fprintf(stderr, "Transfer function measurement stopped: %s\n", rp_GetError(result));
+            break;
+        }
+        if (!done) {
+            break;
+        }
+
+        pthread_mutex_lock(&bode_mutex);
+        bode_data[i] = point;
+        bode_count = i + 1;
+        pthread_mutex_unlock(&bode_mutex);
+    }
+    restore();
+    bode_running = false;
+    return NULL;
+}
+
+static int saveSettings(rp_channel_t channel)
+{
+    ECHECK(gen_IsEnable(channel, &saved_enabled));
+    ECHECK(gen_getAmplitude(channel, &saved_amplitude));
+    ECHECK(gen_getFrequency(channel, &saved_frequency));
+    ECHECK(gen_getWaveform(channel, &saved_waveform));
+    ECHECK(acq_GetDecimation(&saved_decimation));
+    return acq_GetAveraging(&saved_averaging);
+}
+
+int bode_Start(rp_channel_t excitation, float amplitude, float start_frequency, float stop_frequency,
+               uint32_t points, float settle_time, uint32_t cycles)
+{
+    if (excitation != RP_CH_1 && excitation != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (!(amplitude > 0 && amplitude <= AMPLITUDE_MAX)
+            || !(start_frequency >= BODE_MIN_FREQUENCY && start_frequency <= BODE_MAX_FREQUENCY)
+            || !(stop_frequency >= BODE_MIN_FREQUENCY && stop_frequency <= BODE_MAX_FREQUENCY)
+            || points == 0 || points > BODE_MAX_POINTS
+            || !(settle_time >= 0 && settle_time <= BODE_MAX_SETTLE)
+            || cycles == 0 || cycles > ADC_BUFFER_SIZE / 4) {
+        return RP_EOOR;
+    }
+
+    bode_Stop();
+    ECHECK(saveSettings(excitation));
+
+    bode_excitation = excitation;
+    bode_start_frequency = start_frequency;
+    bode_stop_frequency = stop_frequency;
+    bode_points = points;
+    bode_settle_time = settle_time;
+    bode_cycles = cycles;
+
+    pthread_mutex_lock(&bode_mutex);
+    bode_count = 0;
+    pthread_mutex_unlock(&bode_mutex);
+
+    ECHECK(acq_SetAveraging(true));
+    ECHECK(gen_setWaveform(excitation, RP_WAVEFORM_SINE));
+    ECHECK(gen_setAmplitude(excitation, amplitude));
+    ECHECK(gen_Enable(excitation));
+
+    bode_running = true;
+    if (pthread_create(&bode_thread, NULL, bodeThread, NULL) != 0) {
+        bode_running = false;
+        restore();
+        return RP_EUF;
+    }
+    bode_started = true;
+    return RP_OK;
+}
+
+int bode_Stop()
+{
+    if (!bode_started) {
+        return RP_OK;
+    }
+    bode_running = false;
+    pthread_join(bode_thread, NULL);
+    bode_started = false;
+    return RP_OK;
+}
+
+int bode_IsRunning(bool *running)
+{
+    *running = bode_running;
+    return RP_OK;
+}
+
+int bode_GetData(rp_bode_point_t *points, uint32_t *size)
+{
+    int result = RP_OK;
+
+    pthread_mutex_lock(&bode_mutex);
+    if (*size < bode_count) {
+        result = RP_BTS;
+    }
+    else {
+        memcpy(points, bode_data, bode_count * sizeof(rp_bode_point_t));
+        *size = bode_count;
+    }
+    pthread_mutex_unlock(&bode_mutex);
+    return result;
+}
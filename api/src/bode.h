@@ -0,0 +1,33 @@
+/**
+ * @brief Red Pitaya library transfer function analyzer interface
+ *
+ * A worker thread steps the signal generator of one output through
+ * logarithmically spaced frequencies. At every frequency both inputs are
+ * acquired with the scope and demodulated in software at the generator
+ * frequency (lock-in detection), which gives their amplitudes and the
+ * complex transfer function from input A to input B.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __BODE_H
+#define __BODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/lockbox.h"
+
+#define BODE_MIN_FREQUENCY  1.0         // Hz
+#define BODE_MAX_FREQUENCY  31.25e6     // Four samples per period without decimation
+#define BODE_MAX_SETTLE     10.0        // s
+
+int bode_Start(rp_channel_t excitation, float amplitude, float start_frequency, float stop_frequency,
+               uint32_t points, float settle_time, uint32_t cycles);
+int bode_Stop();
+int bode_IsRunning(bool *running);
+int bode_GetData(rp_bode_point_t *points, uint32_t *size);
+
+#endif //__BODE_H
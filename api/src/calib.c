@@ -20,6 +20,7 @@
 #include "calib.h"
 
 #define CALIB_MAGIC 0xAABBCCDD
+#define CALIB_WAIT_MS 1000     // Maximum time to wait for an acquisition
 
 int calib_ReadParams(rp_calib_params_t *calib_params);
 
@@ -433,7 +434,7 @@ int32_t calib_GetDataMedian(rp_channel_t channel, rp_pinState_t gain) {
     rp_AcqSetDecimation(RP_DEC_64);
     rp_AcqStart();
     rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-    usleep(1000000);
+    rp_AcqWaitTrigger(CALIB_WAIT_MS);
     rp_AcqStop();
 
     int16_t data[BUFFER_LENGTH];
@@ -455,7 +456,7 @@ float calib_GetDataMedianFloat(rp_channel_t channel, rp_pinState_t gain) {
     rp_AcqSetDecimation(RP_DEC_64);
     rp_AcqStart();
     rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-    usleep(1000000);
+    rp_AcqWaitTrigger(CALIB_WAIT_MS);
     int BUF_SIZE = BUFFER_LENGTH;
 
     rp_AcqStop();
@@ -479,7 +480,7 @@ int calib_GetDataMinMaxFloat(rp_channel_t channel, rp_pinState_t gain, float* mi
     rp_AcqSetDecimation(RP_DEC_64);
     rp_AcqStart();
     rp_AcqSetTriggerSrc(RP_TRIG_SRC_NOW);
-    usleep(1000000);
+    rp_AcqWaitTrigger(CALIB_WAIT_MS);
     int BUF_SIZE = BUFFER_LENGTH;
 
     rp_AcqStop();
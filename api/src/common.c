@@ -16,26 +16,73 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <poll.h>
 #include <sys/mman.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "common.h"
+#include "sim.h"
 
 static int fd = 0;
+static int irq_fd = -1;
+static rp_backend_t backend = RP_BACKEND_UIO;
+
+// Register blocks with a shadow copy
+typedef struct {
+    volatile uint32_t *regs;    // Mapped registers
+    uint32_t *value;            // Current register values
+    uint32_t *written;          // Values last written to the registers
+    size_t words;
+} cmn_shadow_t;
+
+static cmn_shadow_t shadows[CMN_SHADOW_MAX];
+
+int cmn_SetBackend(rp_backend_t new_backend)
+{
+    if ((new_backend != RP_BACKEND_UIO) && (new_backend != RP_BACKEND_SIM)) {
+        return RP_EOOR;
+    }
+    backend = new_backend;
+    return RP_OK;
+}
+
+rp_backend_t cmn_GetBackend()
+{
+    return backend;
+}
 
 int cmn_Init()
 {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Init();
+    }
+
     if (!fd) {
         if((fd = open("/dev/uio/api", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
         }
     }
+    // Optional, older FPGA images and device trees do not provide the interrupt
+    if (irq_fd < 0) {
+        irq_fd = open(CMN_IRQ_DEV, O_RDWR);
+    }
     return RP_OK;
 }
 
 int cmn_Release()
 {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Release();
+    }
+
+    if (irq_fd >= 0) {
+        close(irq_fd);
+        irq_fd = -1;
+    }
+
     if (fd) {
         if(close(fd) < 0) {
             return RP_ECMD;
@@ -47,6 +94,10 @@ int cmn_Release()
 
 int cmn_Map(size_t size, size_t offset, void** mapped)
 {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Map(size, offset, mapped);
+    }
+
     if(fd == -1) {
         return RP_EMMD;
     }
@@ -64,6 +115,10 @@ int cmn_Map(size_t size, size_t offset, void** mapped)
 
 int cmn_Unmap(size_t size, void** mapped)
 {
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Unmap(size, mapped);
+    }
+
     if(fd == -1) {
         return RP_EUMD;
     }
@@ -83,6 +138,231 @@ int cmn_Unmap(size_t size, void** mapped)
     return RP_OK;
 }
 
+/**
+ * Maps a region of physical memory (e.g. a DDR buffer reserved for the FPGA AXI
+ * writers) through /dev/mem. The address must be page aligned.
+ */
+int cmn_MapDDR(size_t size, size_t address, void** mapped)
+{
+    if (backend == RP_BACKEND_SIM) {
+        return sim_MapDDR(size, address, mapped);
+    }
+
+    int mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (mem_fd == -1) {
+        return RP_EOMD;
+    }
+
+    *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, address);
+    close(mem_fd);
+
+    if (*mapped == MAP_FAILED) {
+        *mapped = NULL;
+        return RP_EMMD;
+    }
+
+    return RP_OK;
+}
+
+int cmn_UnmapDDR(size_t size, void** mapped)
+{
+    if (backend == RP_BACKEND_SIM) {
+        return sim_Unmap(size, mapped);
+    }
+
+    if ((mapped == NULL) || (*mapped == NULL)) {
+        return RP_EUMD;
+    }
+
+    if (munmap(*mapped, size) < 0) {
+        return RP_EUMD;
+    }
+    *mapped = NULL;
+    return RP_OK;
+}
+
+/**
+ * Unmasks the scope acquisition done interrupt. An interrupt raised after this
+ * call ends the next cmn_WaitIrq(), so the condition waited for must be checked
+ * in between. Returns RP_EUF if no interrupt is available, in which case the
+ * caller has to poll.
+ */
+int cmn_ArmIrq()
+{
+    if (backend == RP_BACKEND_SIM) {
+        return sim_ArmIrq();
+    }
+
+    uint32_t unmask = 1;
+    if ((irq_fd < 0) || (write(irq_fd, &unmask, sizeof(unmask)) != sizeof(unmask))) {
+        return RP_EUF;
+    }
+    return RP_OK;
+}
+
+/**
+ * Waits at most timeout_ms for the interrupt armed by cmn_ArmIrq(). Returns
+ * RP_OK both when the interrupt occurred and on timeout.
+ */
+int cmn_WaitIrq(uint32_t timeout_ms)
+{
+    if (backend == RP_BACKEND_SIM) {
+        return sim_WaitIrq(timeout_ms);
+    }
+
+    if (irq_fd < 0) {
+        return RP_EUF;
+    }
+
+    struct pollfd pfd = { .fd = irq_fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, (int) MIN(timeout_ms, (uint32_t) INT32_MAX));
+    if (ready < 0) {
+        return RP_EUF;
+    }
+    if (ready > 0) {
+        // Consume the event count, the interrupt stays masked until re-armed
+        uint32_t count;
+        if (read(irq_fd, &count, sizeof(count)) != sizeof(count)) {
+            return RP_EUF;
+        }
+    }
+    return RP_OK;
+}
+
+/**
+ * Keeps a copy of a block of configuration registers in memory, so that they
+ * can be read without accessing the FPGA. The copy lives in POSIX shared
+ * memory and is shared by all processes using the library (e.g. the SCPI
+ * server and the web interface), which all write the registers through it.
+ * It is loaded from the registers every time a process attaches.
+ *
+ * Registers that are changed by the FPGA itself must still be read from the
+ * mapped registers directly.
+ * @param regs Mapped registers
+ * @param size Size of the block in bytes
+ * @param name Name of the block, used for the shared memory object
+ * @param shadow Pointer where the address of the copy is returned
+ */
+int cmn_ShadowAttach(volatile void *regs, size_t size, const char *name, void **shadow)
+{
+    cmn_shadow_t *s = NULL;
+    for (int i = 0; i < CMN_SHADOW_MAX; i++) {
+        if (shadows[i].regs == NULL) {
+            s = &shadows[i];
+            break;
+        }
+    }
+    if (s == NULL || regs == NULL) {
+        return RP_EMMD;
+    }
+
+    // The simulator only shares its registers between processes if asked to
+    char shm_name[64];
+    const char *prefix = CMN_SHADOW_SHM;
+    if (backend == RP_BACKEND_SIM) {
+        prefix = getenv(SIM_SHM_ENV);
+    }
+
+    size_t words = size / sizeof(uint32_t);
+    size_t shm_size = 2 * words * sizeof(uint32_t);
+    void *mem = MAP_FAILED;
+    if (prefix && *prefix) {
+        snprintf(shm_name, sizeof(shm_name), "%s-shadow-%s", prefix, name);
+        int shm_fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600);
+        if (shm_fd >= 0) {
+            if (ftruncate(shm_fd, shm_size) == 0) {
+                mem = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+            }
+            close(shm_fd);
+        }
+    }
+    if (mem == MAP_FAILED) {
+        // Not shared; still correct as long as this is the only process
+        mem = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            return RP_EMMD;
+        }
+    }
+
+    s->regs = regs;
+    s->value = mem;
+    s->written = s->value + words;
+    s->words = words;
+    for (size_t i = 0; i < words; i++) {
+        s->value[i] = s->written[i] = s->regs[i];
+    }
+    *shadow = s->value;
+    return RP_OK;
+}
+
+int cmn_ShadowDetach(void **shadow)
+{
+    for (int i = 0; i < CMN_SHADOW_MAX; i++) {
+        if (shadows[i].regs != NULL && shadows[i].value == *shadow) {
+            munmap(shadows[i].value, 2 * shadows[i].words * sizeof(uint32_t));
+            memset(&shadows[i], 0, sizeof(cmn_shadow_t));
+            *shadow = NULL;
+            return RP_OK;
+        }
+    }
+    return RP_EUMD;
+}
+
+/**
+ * Writes the words of a shadow copy that were changed since they were last
+ * written to the registers, in ascending address order.
+ */
+int cmn_ShadowFlush(void *shadow)
+{
+    for (int i = 0; i < CMN_SHADOW_MAX; i++) {
+        cmn_shadow_t *s = &shadows[i];
+        if (s->regs == NULL || s->value != shadow) {
+            continue;
+        }
+        for (size_t j = 0; j < s->words; j++) {
+            uint32_t value = s->value[j];
+            if (value != s->written[j]) {
+                s->written[j] = value;
+                SET_VALUE(s->regs[j], value);
+            }
+        }
+        return RP_OK;
+    }
+    return RP_EUMD;
+}
+
+/* Returns the shadow block containing a register, or NULL if it has none */
+static cmn_shadow_t *shadowOf(volatile uint32_t *field, size_t *index)
+{
+    for (int i = 0; i < CMN_SHADOW_MAX; i++) {
+        cmn_shadow_t *s = &shadows[i];
+        if (s->regs != NULL && field >= s->regs && field < s->regs + s->words) {
+            *index = field - s->regs;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* Reads a register from its shadow copy if it has one */
+static uint32_t readRegister(volatile uint32_t *field)
+{
+    size_t i;
+    cmn_shadow_t *s = shadowOf(field, &i);
+    return s ? s->value[i] : *field;
+}
+
+/* Writes a register and its shadow copy */
+static void writeRegister(volatile uint32_t *field, uint32_t value)
+{
+    size_t i;
+    cmn_shadow_t *s = shadowOf(field, &i);
+    if (s) {
+        s->value[i] = s->written[i] = value;
+    }
+    SET_VALUE(*field, value);
+}
+
 int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask, uint32_t bitsToSetShift)
 {
     VALIDATE_BITS(value, mask);
@@ -90,7 +370,7 @@ int cmn_SetShiftedValue(volatile uint32_t* field, uint32_t value, uint32_t mask,
     cmn_GetValue(field, &currentValue, 0xffffffff);
     currentValue &=  ~(mask << bitsToSetShift); // Clear all bits at specified location
     currentValue +=  (value << bitsToSetShift); // Set value at specified location
-    SET_VALUE(*field, currentValue);
+    writeRegister(field, currentValue);
     return RP_OK;
 }
 
@@ -101,7 +381,7 @@ int cmn_SetValue(volatile uint32_t* field, uint32_t value, uint32_t mask)
 
 int cmn_GetShiftedValue(volatile uint32_t* field, uint32_t* value, uint32_t mask, uint32_t bitsToSetShift)
 {
-    *value = (*field >> bitsToSetShift) & mask;
+    *value = (readRegister(field) >> bitsToSetShift) & mask;
     return RP_OK;
 }
 
@@ -113,14 +393,14 @@ int cmn_GetValue(volatile uint32_t* field, uint32_t* value, uint32_t mask)
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
-    SET_BITS(*field, bits);
+    writeRegister(field, readRegister(field) | bits);
     return RP_OK;
 }
 
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask)
 {
     VALIDATE_BITS(bits, mask);
-    UNSET_BITS(*field, bits);
+    writeRegister(field, readRegister(field) & ~bits);
     return RP_OK;
 }
 
@@ -278,6 +558,41 @@ float cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t
 float rp_cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off) {
 	return cmn_CnvCntToV(field_len, cnts, adc_max_v, calibScale, calib_dc_off, user_dc_off);
 }
+
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief Converts a block of ADC/DAC/Buffer counts to voltage [V]
+ *
+ * Same conversion as cmn_CnvCntToV(), but the calibration scale and offsets are
+ * folded into a single gain and offset once per call. The per-sample loop is
+ * branchless single-precision code (sign extension by shifts, clamping with
+ * MIN/MAX), so the compiler can keep it in registers and vectorize it.
+ *
+ * @param[in] field_len Number of field (ADC/DAC/Buffer) bits
+ * @param[in] cnts Captured Signal Values, expressed in ADC/DAC counts
+ * @param[out] voltages Signal Values, expressed in user units [V]
+ * @param[in] size Number of values to convert
+ * @param[in] adc_max_v Maximal ADC/DAC voltage, specified in [V]
+ * @param[in] calibScale Calibration scale factor, specified in [full scale] - EPROM calibration parameter storage format
+ * @param[in] calib_dc_off Calibrated DC offset, specified in ADC/DAC counts
+ * @param[in] user_dc_off User specified DC offset, specified in [V]
+ */
+void cmn_CnvCntToVBulk(uint32_t field_len, const uint32_t* cnts, float* voltages, uint32_t size,
+                       float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off)
+{
+    const uint32_t shift = 32 - field_len;
+    const int32_t cnt_min = -(1 << (field_len - 1));
+    const int32_t cnt_max = (1 << (field_len - 1));
+    const float scale = cmn_CalibFullScaleToVoltage(calibScale) * adc_max_v;
+    const float gain = adc_max_v / (float) (1 << (field_len - 1)) * scale;
+    const float offset = user_dc_off * scale;
+
+    for (uint32_t i = 0; i < size; ++i) {
+        int32_t m = ((int32_t) (cnts[i] << shift) >> shift) - calib_dc_off;
+        m = MAX(cnt_min, MIN(m, cnt_max));
+        voltages[i] = (float) m * gain + offset;
+    }
+}
 /**
  * @brief Converts voltage in [V] to ADC/DAC/Buffer counts
  *
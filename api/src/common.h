@@ -60,11 +60,30 @@ else { \
 
 #define FULL_SCALE_NORM     20.0    // V
 
+// Register shadow copies (see cmn_ShadowAttach)
+#define CMN_SHADOW_MAX      4
+#define CMN_SHADOW_SHM      "/lockbox"  // Shared memory name prefix
+
+// UIO device of the scope acquisition done interrupt (IRQ_F2P[0])
+#define CMN_IRQ_DEV         "/dev/uio/acq_trig"
+
+int cmn_SetBackend(rp_backend_t backend);
+rp_backend_t cmn_GetBackend();
+
 int cmn_Init();
 int cmn_Release();
 
 int cmn_Map(size_t size, size_t offset, void** mapped);
 int cmn_Unmap(size_t size, void** mapped);
+int cmn_MapDDR(size_t size, size_t address, void** mapped);
+int cmn_UnmapDDR(size_t size, void** mapped);
+
+int cmn_ArmIrq();
+int cmn_WaitIrq(uint32_t timeout_ms);
+
+int cmn_ShadowAttach(volatile void *regs, size_t size, const char *name, void **shadow);
+int cmn_ShadowDetach(void **shadow);
+int cmn_ShadowFlush(void *shadow);
 
 int cmn_SetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
 int cmn_UnsetBits(volatile uint32_t* field, uint32_t bits, uint32_t mask);
@@ -84,6 +103,8 @@ uint32_t cmn_CalibFullScaleFromVoltage(float voltageScale);
 int32_t cmn_CalibCnts(uint32_t field_len, uint32_t cnts, int calib_dc_off);
 float cmn_CnvCalibCntToV(uint32_t field_len, int32_t calib_cnts, float adc_max_v, float calibScale, float user_dc_off);
 float cmn_CnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
+void cmn_CnvCntToVBulk(uint32_t field_len, const uint32_t* cnts, float* voltages, uint32_t size,
+                       float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off);
 uint32_t cmn_CnvVToCnt(uint32_t field_len, float voltage, float adc_max_v, bool calibFS_LO, uint32_t calib_scale, int calib_dc_off, float user_dc_off);
 
 float rp_cmn_CalibFullScaleToVoltage(uint32_t fullScaleGain);
@@ -0,0 +1,418 @@
+/**
+ * @brief Red Pitaya library configuration file implementation
+ *
+ * Files are written to a temporary file that is renamed over the old one, so
+ * that an interrupted save leaves the previous configuration intact. They are
+ * read by mapping them into memory, which reads the whole file at once when
+ * the configuration is restored at startup.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "redpitaya/lockbox.h"
+#include "config.h"
+
+// Enumerations are stored as CONFIG_TYPE_INT
+_Static_assert(sizeof(rp_apin_t) == sizeof(int32_t), "rp_apin_t is not 32 bit");
+_Static_assert(sizeof(rp_dpin_t) == sizeof(int32_t), "rp_dpin_t is not 32 bit");
+_Static_assert(sizeof(rp_waveform_t) == sizeof(int32_t), "rp_waveform_t is not 32 bit");
+_Static_assert(sizeof(rp_pid_input_t) == sizeof(int32_t), "rp_pid_input_t is not 32 bit");
+_Static_assert(sizeof(rp_iq_ref_t) == sizeof(int32_t), "rp_iq_ref_t is not 32 bit");
+
+// Describes where the values of a tag are kept in rp_lockbox_params_t
+typedef struct {
+    uint8_t type;
+    uint8_t count;
+    size_t offset;
+} config_field_t;
+
+#define FIELD(tag, field_type, member) \
+    [tag] = { \
+        .type = field_type, \
+        .count = sizeof(((rp_lockbox_params_t *)0)->member) \
+                 / sizeof(((rp_lockbox_params_t *)0)->member[0]), \
+        .offset = offsetof(rp_lockbox_params_t, member) \
+    }
+
+static const config_field_t fields[CONFIG_TAG_END] = {
+    FIELD(CONFIG_PID_SETPOINT,              CONFIG_TYPE_FLOAT,  pid_setpoint),
+    FIELD(CONFIG_PID_KP,                    CONFIG_TYPE_FLOAT,  pid_kp),
+    FIELD(CONFIG_PID_KI,                    CONFIG_TYPE_FLOAT,  pid_ki),
+    FIELD(CONFIG_PID_KD,                    CONFIG_TYPE_FLOAT,  pid_kd),
+    FIELD(CONFIG_PID_KII,                   CONFIG_TYPE_FLOAT,  pid_kii),
+    FIELD(CONFIG_PID_KG,                    CONFIG_TYPE_FLOAT,  pid_kg),
+    FIELD(CONFIG_PID_INT_RESET,             CONFIG_TYPE_BOOL,   pid_int_reset),
+    FIELD(CONFIG_PID_INVERTED,              CONFIG_TYPE_BOOL,   pid_inverted),
+    FIELD(CONFIG_PID_RESET_WHEN_RAILED,     CONFIG_TYPE_BOOL,   pid_reset_when_railed),
+    FIELD(CONFIG_PID_HOLD,                  CONFIG_TYPE_BOOL,   pid_hold),
+    FIELD(CONFIG_PID_RELOCK_ENABLED,        CONFIG_TYPE_BOOL,   pid_relock_enabled),
+    FIELD(CONFIG_PID_ENABLED,               CONFIG_TYPE_BOOL,   pid_enabled),
+    FIELD(CONFIG_PID_RELOCK_STEPSIZE,       CONFIG_TYPE_FLOAT,  pid_relock_stepsize),
+    FIELD(CONFIG_PID_RELOCK_MINIMUM,        CONFIG_TYPE_FLOAT,  pid_relock_minimum),
+    FIELD(CONFIG_PID_RELOCK_MAXIMUM,        CONFIG_TYPE_FLOAT,  pid_relock_maximum),
+    FIELD(CONFIG_PID_RELOCK_INPUT,          CONFIG_TYPE_INT,    pid_relock_input),
+    FIELD(CONFIG_PID_LSO_ENABLED,           CONFIG_TYPE_BOOL,   pid_lso_enabled),
+    FIELD(CONFIG_PID_EXT_RESET_ENABLED,     CONFIG_TYPE_BOOL,   pid_ext_reset_enabled),
+    FIELD(CONFIG_PID_EXT_RESET_INPUT,       CONFIG_TYPE_INT,    pid_ext_reset_input),
+    FIELD(CONFIG_LIMIT_MIN,                 CONFIG_TYPE_FLOAT,  limit_min),
+    FIELD(CONFIG_LIMIT_MAX,                 CONFIG_TYPE_FLOAT,  limit_max),
+    FIELD(CONFIG_GEN_ENABLED,               CONFIG_TYPE_BOOL,   gen_enabled),
+    FIELD(CONFIG_GEN_POFFSET_ENABLED,       CONFIG_TYPE_BOOL,   gen_poffset_enabled),
+    FIELD(CONFIG_GEN_AMP,                   CONFIG_TYPE_FLOAT,  gen_amp),
+    FIELD(CONFIG_GEN_OFFSET,                CONFIG_TYPE_FLOAT,  gen_offset),
+    FIELD(CONFIG_GEN_FREQ,                  CONFIG_TYPE_FLOAT,  gen_freq),
+    FIELD(CONFIG_GEN_WAVEFORM,              CONFIG_TYPE_INT,    gen_waveform),
+    FIELD(CONFIG_PID_INPUT,                 CONFIG_TYPE_INT,    pid_input),
+    FIELD(CONFIG_IQ_FREQUENCY,              CONFIG_TYPE_FLOAT,  iq_frequency),
+    FIELD(CONFIG_IQ_PHASE,                  CONFIG_TYPE_FLOAT,  iq_phase),
+    FIELD(CONFIG_IQ_BANDWIDTH,              CONFIG_TYPE_FLOAT,  iq_bandwidth),
+    FIELD(CONFIG_IQ_GAIN,                   CONFIG_TYPE_FLOAT,  iq_gain),
+    FIELD(CONFIG_IQ_REFERENCE,              CONFIG_TYPE_INT,    iq_reference),
+};
+
+// Layout of the files of CONFIG_LEGACY_VERSION; must not be changed
+typedef struct {
+    int config_version;
+    float pid_setpoint[4];
+    float pid_kp[4];
+    float pid_ki[4];
+    float pid_kd[4];
+    float pid_kii[4];
+    float pid_kg[4];
+    bool pid_int_reset[4];
+    bool pid_inverted[4];
+    bool pid_reset_when_railed[4];
+    bool pid_hold[4];
+    bool pid_relock_enabled[4];
+    bool pid_enabled[4];
+    float pid_relock_stepsize[4];
+    float pid_relock_minimum[4];
+    float pid_relock_maximum[4];
+    int pid_relock_input[4];
+    bool pid_lso_enabled[4];
+    bool pid_ext_reset_enabled[4];
+    int pid_ext_reset_input[4];
+    float limit_min[2];
+    float limit_max[2];
+    bool gen_enabled[2];
+    bool gen_poffset_enabled[2];
+    float gen_amp[2];
+    float gen_offset[2];
+    float gen_freq[2];
+    int gen_waveform[2];
+} config_legacy_t;
+
+// Values found in a file, indexed by tag and channel
+typedef bool config_present_t[CONFIG_TAG_END][4];
+
+
+static uint32_t crc32(const void *data, size_t size)
+{
+    const uint8_t *bytes = data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static void *fieldValue(rp_lockbox_params_t *params, const config_field_t *field, int index)
+{
+    size_t size = field->type == CONFIG_TYPE_BOOL ? sizeof(bool) : sizeof(int32_t);
+    return (uint8_t *)params + field->offset + index * size;
+}
+
+void config_GetParams(rp_lockbox_params_t *params)
+{
+    params->config_version = LOCKBOX_CONFIG_VERSION;
+    for (int i=0; i<4; i++) {
+        rp_PIDGetSetpoint(i, &params->pid_setpoint[i]);
+        rp_PIDGetKp(i, &params->pid_kp[i]);
+        rp_PIDGetKi(i, &params->pid_ki[i]);
+        rp_PIDGetKd(i, &params->pid_kd[i]);
+        rp_PIDGetKii(i, &params->pid_kii[i]);
+        rp_PIDGetKg(i, &params->pid_kg[i]);
+        rp_PIDGetIntReset(i, &params->pid_int_reset[i]);
+        rp_PIDGetInverted(i, &params->pid_inverted[i]);
+        rp_PIDGetResetWhenRailed(i, &params->pid_reset_when_railed[i]);
+        rp_PIDGetHold(i, &params->pid_hold[i]);
+        rp_PIDGetRelock(i, &params->pid_relock_enabled[i]);
+        rp_PIDGetEnable(i, &params->pid_enabled[i]);
+        rp_PIDGetRelockStepsize(i, &params->pid_relock_stepsize[i]);
+        rp_PIDGetRelockMinimum(i, &params->pid_relock_minimum[i]);
+        rp_PIDGetRelockMaximum(i, &params->pid_relock_maximum[i]);
+        rp_PIDGetRelockInput(i, &params->pid_relock_input[i]);
+        rp_PIDGetLockStatusOutputEnable(i, &params->pid_lso_enabled[i]);
+        rp_PIDGetExtResetEnable(i, &params->pid_ext_reset_enabled[i]);
+        rp_PIDGetExtResetInput(i, &params->pid_ext_reset_input[i]);
+        rp_PIDGetInput(i, &params->pid_input[i]);
+    }
+    for (int i=0; i<2; i++) {
+        rp_LimitGetMin(i, &params->limit_min[i]);
+        rp_LimitGetMax(i, &params->limit_max[i]);
+        rp_GenOutIsEnabled(i, &params->gen_enabled[i]);
+        rp_GenPOffsetIsEnabled(i, &params->gen_poffset_enabled[i]);
+        rp_GenGetAmp(i, &params->gen_amp[i]);
+        rp_GenGetOffset(i, &params->gen_offset[i]);
+        rp_GenGetFreq(i, &params->gen_freq[i]);
+        rp_GenGetWaveform(i, &params->gen_waveform[i]);
+        rp_PIDGetIQFrequency(i, &params->iq_frequency[i]);
+        rp_PIDGetIQPhase(i, &params->iq_phase[i]);
+        rp_PIDGetIQBandwidth(i, &params->iq_bandwidth[i]);
+        rp_PIDGetIQGain(i, &params->iq_gain[i]);
+        rp_PIDGetIQReference(i, &params->iq_reference[i]);
+    }
+}
+
+int config_Save(const char *path)
+{
+    rp_lockbox_params_t params;
+    config_entry_t entries[sizeof(rp_lockbox_params_t)];
+    config_header_t header = { .magic = CONFIG_MAGIC, .version = LOCKBOX_CONFIG_VERSION };
+    char tmp_path[strlen(path) + 5];
+
+    config_GetParams(&params);
+    for (int tag = 1; tag < CONFIG_TAG_END; tag++) {
+        const config_field_t *field = &fields[tag];
+        for (int i = 0; i < field->count; i++) {
+            config_entry_t *entry = &entries[header.count++];
+            const void *value = fieldValue(&params, field, i);
+            *entry = (config_entry_t) { .tag = tag, .index = i, .type = field->type };
+            switch (field->type) {
+                case CONFIG_TYPE_FLOAT: entry->value.f = *(const float *)value; break;
+                case CONFIG_TYPE_BOOL:  entry->value.i = *(const bool *)value; break;
+                case CONFIG_TYPE_INT:   entry->value.i = *(const int32_t *)value; break;
+            }
+        }
+    }
+    header.crc = crc32(entries, header.count * sizeof(config_entry_t));
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL) {
+        return RP_EOCF;
+    }
+    size_t written = fwrite(&header, sizeof(header), 1, file);
+    written += fwrite(entries, sizeof(config_entry_t), header.count, file);
+    // The data must be on disk before the rename makes it the configuration
+    bool synced = fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (fclose(file) != 0 || !synced || written != 1u + header.count
+            || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return RP_EOCF;
+    }
+    return RP_OK;
+}
+
+static int parseEntries(const uint8_t *data, size_t size, rp_lockbox_params_t *params,
+                        config_present_t present)
+{
+    const config_header_t *header = (const config_header_t *)data;
+    if (header->version != LOCKBOX_CONFIG_VERSION) {
+        return RP_EICV;
+    }
+    const config_entry_t *entries = (const config_entry_t *)(header + 1);
+    if (size < sizeof(*header) + header->count * sizeof(config_entry_t)
+            || crc32(entries, header->count * sizeof(config_entry_t)) != header->crc) {
+        return RP_ECCF;
+    }
+
+    for (int k = 0; k < header->count; k++) {
+        const config_entry_t *entry = &entries[k];
+        if (entry->tag == 0 || entry->tag >= CONFIG_TAG_END) {
+            continue;   // Written by a newer version of the library
+        }
+        const config_field_t *field = &fields[entry->tag];
+        if (entry->type != field->type || entry->index >= field->count) {
+            continue;
+        }
+        void *value = fieldValue(params, field, entry->index);
+        switch (field->type) {
+            case CONFIG_TYPE_FLOAT: *(float *)value = entry->value.f; break;
+            case CONFIG_TYPE_BOOL:  *(bool *)value = entry->value.i != 0; break;
+            case CONFIG_TYPE_INT:   *(int32_t *)value = entry->value.i; break;
+        }
+        present[entry->tag][entry->index] = true;
+    }
+    return RP_OK;
+}
+
+#define MIGRATE(member) memcpy(params->member, legacy->member, sizeof(legacy->member))
+
+static void migrateLegacy(const config_legacy_t *legacy, rp_lockbox_params_t *params,
+                          config_present_t present)
+{
+    MIGRATE(pid_setpoint);
+    MIGRATE(pid_kp);
+    MIGRATE(pid_ki);
+    MIGRATE(pid_kd);
+    MIGRATE(pid_kii);
+    MIGRATE(pid_kg);
+    MIGRATE(pid_int_reset);
+    MIGRATE(pid_inverted);
+    MIGRATE(pid_reset_when_railed);
+    MIGRATE(pid_hold);
+    MIGRATE(pid_relock_enabled);
+    MIGRATE(pid_enabled);
+    MIGRATE(pid_relock_stepsize);
+    MIGRATE(pid_relock_minimum);
+    MIGRATE(pid_relock_maximum);
+    MIGRATE(pid_relock_input);
+    MIGRATE(pid_lso_enabled);
+    MIGRATE(pid_ext_reset_enabled);
+    MIGRATE(pid_ext_reset_input);
+    MIGRATE(limit_min);
+    MIGRATE(limit_max);
+    MIGRATE(gen_enabled);
+    MIGRATE(gen_poffset_enabled);
+    MIGRATE(gen_amp);
+    MIGRATE(gen_offset);
+    MIGRATE(gen_freq);
+    MIGRATE(gen_waveform);
+    memset(present, true, sizeof(config_present_t));
+}
+
+/* Applies the values found in the file, leaving all other settings unchanged */
+static void applyParams(const rp_lockbox_params_t *params, config_present_t present)
+{
+    #define HAS(tag) present[tag][i]
+    for (int i=0; i<4; i++) {
+        if (HAS(CONFIG_PID_SETPOINT) || HAS(CONFIG_PID_KP) || HAS(CONFIG_PID_KI)
+                || HAS(CONFIG_PID_KD) || HAS(CONFIG_PID_KII) || HAS(CONFIG_PID_KG)) {
+            rp_pid_params_t pid_params = {
+                .setpoint = params->pid_setpoint[i],
+                .kp = params->pid_kp[i],
+                .ki = params->pid_ki[i],
+                .kd = params->pid_kd[i],
+                .kii = params->pid_kii[i],
+                .kg = params->pid_kg[i],
+            };
+            rp_PIDSetParams(i, &pid_params);
+        }
+        if (HAS(CONFIG_PID_INT_RESET))
+            rp_PIDSetIntReset(i, params->pid_int_reset[i]);
+        if (HAS(CONFIG_PID_INVERTED))
+            rp_PIDSetInverted(i, params->pid_inverted[i]);
+        if (HAS(CONFIG_PID_RESET_WHEN_RAILED))
+            rp_PIDSetResetWhenRailed(i, params->pid_reset_when_railed[i]);
+        if (HAS(CONFIG_PID_HOLD))
+            rp_PIDSetHold(i, params->pid_hold[i]);
+        if (HAS(CONFIG_PID_RELOCK_ENABLED))
+            rp_PIDSetRelock(i, params->pid_relock_enabled[i]);
+        if (HAS(CONFIG_PID_ENABLED))
+            rp_PIDSetEnable(i, params->pid_enabled[i]);
+        if (HAS(CONFIG_PID_RELOCK_STEPSIZE))
+            rp_PIDSetRelockStepsize(i, params->pid_relock_stepsize[i]);
+        if (HAS(CONFIG_PID_RELOCK_MINIMUM))
+            rp_PIDSetRelockMinimum(i, params->pid_relock_minimum[i]);
+        if (HAS(CONFIG_PID_RELOCK_MAXIMUM))
+            rp_PIDSetRelockMaximum(i, params->pid_relock_maximum[i]);
+        if (HAS(CONFIG_PID_RELOCK_INPUT))
+            rp_PIDSetRelockInput(i, params->pid_relock_input[i]);
+        if (HAS(CONFIG_PID_LSO_ENABLED))
+            rp_PIDSetLockStatusOutputEnable(i, params->pid_lso_enabled[i]);
+        if (HAS(CONFIG_PID_EXT_RESET_ENABLED))
+            rp_PIDSetExtResetEnable(i, params->pid_ext_reset_enabled[i]);
+        if (HAS(CONFIG_PID_EXT_RESET_INPUT))
+            rp_PIDSetExtResetInput(i, params->pid_ext_reset_input[i]);
+        if (HAS(CONFIG_PID_INPUT))
+            rp_PIDSetInput(i, params->pid_input[i]);
+    }
+    for (int i=0; i<2; i++) {
+        if (HAS(CONFIG_LIMIT_MIN))
+            rp_LimitMin(i, params->limit_min[i]);
+        if (HAS(CONFIG_LIMIT_MAX))
+            rp_LimitMax(i, params->limit_max[i]);
+        if (HAS(CONFIG_GEN_ENABLED)) {
+            if (params->gen_enabled[i])
+                rp_GenOutEnable(i);
+            else
+                rp_GenOutDisable(i);
+        }
+        if (HAS(CONFIG_GEN_POFFSET_ENABLED)) {
+            if (params->gen_poffset_enabled[i])
+                rp_GenPOffsetEnable(i);
+            else
+                rp_GenPOffsetDisable(i);
+        }
+        if (HAS(CONFIG_GEN_AMP))
+            rp_GenAmp(i, params->gen_amp[i]);
+        if (HAS(CONFIG_GEN_OFFSET))
+            rp_GenOffset(i, params->gen_offset[i]);
+        if (HAS(CONFIG_GEN_FREQ))
+            rp_GenFreq(i, params->gen_freq[i]);
+        if (HAS(CONFIG_GEN_WAVEFORM))
+            rp_GenWaveform(i, params->gen_waveform[i]);
+        if (HAS(CONFIG_IQ_FREQUENCY))
+            rp_PIDSetIQFrequency(i, params->iq_frequency[i]);
+        if (HAS(CONFIG_IQ_PHASE))
+            rp_PIDSetIQPhase(i, params->iq_phase[i]);
+        if (HAS(CONFIG_IQ_BANDWIDTH))
+            rp_PIDSetIQBandwidth(i, params->iq_bandwidth[i]);
+        if (HAS(CONFIG_IQ_GAIN))
+            rp_PIDSetIQGain(i, params->iq_gain[i]);
+        if (HAS(CONFIG_IQ_REFERENCE))
+            rp_PIDSetIQReference(i, params->iq_reference[i]);
+    }
+    #undef HAS
+}
+
+int config_Load(const char *path)
+{
+    rp_lockbox_params_t params;
+    config_present_t present;
+    struct stat st;
+    int result;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return RP_EOCF;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return RP_EOCF;
+    }
+    if (st.st_size < (off_t)sizeof(int)) {
+        close(fd);
+        return RP_EICV;
+    }
+    size_t size = st.st_size;
+    // Read the whole file at once instead of page by page
+    const uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return RP_EOCF;
+    }
+
+    config_GetParams(&params);
+    memset(present, false, sizeof(present));
+    if (size >= sizeof(config_header_t) && ((const config_header_t *)data)->magic == CONFIG_MAGIC) {
+        result = parseEntries(data, size, &params, present);
+    } else if (size == sizeof(config_legacy_t)
+            && ((const config_legacy_t *)data)->config_version == CONFIG_LEGACY_VERSION) {
+        migrateLegacy((const config_legacy_t *)data, &params, present);
+        result = RP_OK;
+    } else {
+        result = RP_EICV;
+    }
+    munmap((void *)data, size);
+
+    if (result == RP_OK) {
+        applyParams(&params, present);
+    }
+    return result;
+}
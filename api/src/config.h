@@ -0,0 +1,94 @@
+/**
+ * @brief Red Pitaya library configuration file interface
+ *
+ * The configuration file starts with a header (magic, format version, number
+ * of entries and CRC-32 of the entries), followed by one fixed-size entry per
+ * value. An entry names the value it holds by a tag and a channel index and
+ * states the type of the value, so that values can be added without changing
+ * the format: unknown tags are skipped, and values missing from a file keep
+ * their current setting when it is loaded.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __CONFIG_H
+#define __CONFIG_H
+
+#include <stdint.h>
+
+#include "redpitaya/lockbox.h"
+
+#define CONFIG_MAGIC        0x4643424C  // "LBCF"
+
+// Version of the configuration files written with fwrite(rp_lockbox_params_t)
+#define CONFIG_LEGACY_VERSION   2
+
+typedef enum {
+    CONFIG_TYPE_FLOAT = 1,
+    CONFIG_TYPE_BOOL  = 2,
+    CONFIG_TYPE_INT   = 3,              // Also used for enumerations
+} config_type_t;
+
+/* Tags identify the values of a configuration file; never reuse or renumber them */
+typedef enum {
+    CONFIG_PID_SETPOINT = 1,
+    CONFIG_PID_KP,
+    CONFIG_PID_KI,
+    CONFIG_PID_KD,
+    CONFIG_PID_KII,
+    CONFIG_PID_KG,
+    CONFIG_PID_INT_RESET,
+    CONFIG_PID_INVERTED,
+    CONFIG_PID_RESET_WHEN_RAILED,
+    CONFIG_PID_HOLD,
+    CONFIG_PID_RELOCK_ENABLED,
+    CONFIG_PID_ENABLED,
+    CONFIG_PID_RELOCK_STEPSIZE,
+    CONFIG_PID_RELOCK_MINIMUM,
+    CONFIG_PID_RELOCK_MAXIMUM,
+    CONFIG_PID_RELOCK_INPUT,
+    CONFIG_PID_LSO_ENABLED,
+    CONFIG_PID_EXT_RESET_ENABLED,
+    CONFIG_PID_EXT_RESET_INPUT,
+    CONFIG_LIMIT_MIN,
+    CONFIG_LIMIT_MAX,
+    CONFIG_GEN_ENABLED,
+    CONFIG_GEN_POFFSET_ENABLED,
+    CONFIG_GEN_AMP,
+    CONFIG_GEN_OFFSET,
+    CONFIG_GEN_FREQ,
+    CONFIG_GEN_WAVEFORM,
+    CONFIG_PID_INPUT,
+    CONFIG_IQ_FREQUENCY,
+    CONFIG_IQ_PHASE,
+    CONFIG_IQ_BANDWIDTH,
+    CONFIG_IQ_GAIN,
+    CONFIG_IQ_REFERENCE,
+    CONFIG_TAG_END
+} config_tag_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;                   // LOCKBOX_CONFIG_VERSION
+    uint16_t count;                     // Number of entries
+    uint32_t crc;                       // CRC-32 of the entries
+} config_header_t;
+
+typedef struct {
+    uint8_t tag;
+    uint8_t index;                      // Channel or PID
+    uint8_t type;
+    uint8_t reserved;
+    union {
+        float f;
+        int32_t i;
+    } value;
+} config_entry_t;
+
+void config_GetParams(rp_lockbox_params_t *params);
+int config_Save(const char *path);
+int config_Load(const char *path);
+
+#endif //__CONFIG_H
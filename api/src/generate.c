@@ -24,86 +24,96 @@
 static volatile generate_control_t *generate = NULL;
 static volatile int32_t *data_chA = NULL;
 static volatile int32_t *data_chB = NULL;
+// Shadow copy of the control registers; setters change it and write it back
+static generate_control_t *gen_shadow = NULL;
 
 
 int generate_Init() {
     cmn_Map(GENERATE_BASE_SIZE, GENERATE_BASE_ADDR, (void **) &generate);
     data_chA = (int32_t *) ((char *) generate + (CHA_DATA_OFFSET));
     data_chB = (int32_t *) ((char *) generate + (CHB_DATA_OFFSET));
-    return RP_OK;
+    return cmn_ShadowAttach(generate, sizeof(generate_control_t), "generate", (void **) &gen_shadow);
 }
 
 int generate_Release() {
+    cmn_ShadowDetach((void **) &gen_shadow);
     cmn_Unmap(GENERATE_BASE_SIZE, (void **) &generate);
     data_chA = NULL;
     data_chB = NULL;
     return RP_OK;
 }
 
-int getChannelPropertiesAddress(volatile ch_properties_t **ch_properties, rp_channel_t channel) {
+int getChannelPropertiesAddress(ch_properties_t **ch_properties, rp_channel_t channel) {
     CHANNEL_ACTION(channel,
-            *ch_properties = &generate->properties_chA,
-            *ch_properties = &generate->properties_chB)
+            *ch_properties = &gen_shadow->properties_chA,
+            *ch_properties = &gen_shadow->properties_chB)
     return RP_OK;
 }
 
+/* Writes the first register from the shadow copy. It is always written, even
+ * if unchanged, because writing it with the internal trigger selected is what
+ * triggers the generator. */
+static int writeConf() {
+    return cmn_SetValue((volatile uint32_t *) generate, *(uint32_t *) gen_shadow, 0xFFFFFFFF);
+}
+
 int generate_setOutputDisable(rp_channel_t channel, bool disable) {
     if (channel == RP_CH_1) {
-        generate->AsetOutputTo0 = disable ? 1 : 0;
+        gen_shadow->AsetOutputTo0 = disable ? 1 : 0;
     }
     else if (channel == RP_CH_2) {
-        generate->BsetOutputTo0 = disable ? 1 : 0;
+        gen_shadow->BsetOutputTo0 = disable ? 1 : 0;
     }
     else {
         return RP_EPN;
     }
-    return RP_OK;
+    return writeConf();
 }
 
 int generate_getOutputEnabled(rp_channel_t channel, bool *enabled) {
     uint32_t value;
     CHANNEL_ACTION(channel,
-            value = generate->AsetOutputTo0,
-            value = generate->BsetOutputTo0)
+            value = gen_shadow->AsetOutputTo0,
+            value = gen_shadow->BsetOutputTo0)
     *enabled = value == 1 ? false : true;
     return RP_OK;
 }
 
 int generate_setPOffsetEnable(rp_channel_t channel, bool enable) {
     if (channel == RP_CH_1) {
-        generate->AsetOffsetTo0 = enable ? 1 : 0;
+        gen_shadow->AsetOffsetTo0 = enable ? 1 : 0;
     }
     else if (channel == RP_CH_2) {
-        generate->BsetOffsetTo0 = enable ? 1 : 0;
+        gen_shadow->BsetOffsetTo0 = enable ? 1 : 0;
     }
     else {
         return RP_EPN;
     }
-    return RP_OK;
+    return writeConf();
 }
 
 int generate_getPOffsetEnabled(rp_channel_t channel, bool *enabled) {
     uint32_t value;
     CHANNEL_ACTION(channel,
-            value = generate->AsetOffsetTo0,
-            value = generate->BsetOffsetTo0)
+            value = gen_shadow->AsetOffsetTo0,
+            value = gen_shadow->BsetOffsetTo0)
     *enabled = value == 1 ? true : false;
     return RP_OK;
 }
 
 int generate_setAmplitude(rp_channel_t channel, float amplitude) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
     rp_calib_params_t calib = calib_GetParams();
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
 
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->amplitudeScale = cmn_CnvVToCnt(DATA_BIT_LENGTH, amplitude, AMPLITUDE_MAX, false, amp_max, 0, 0.0);
-    return RP_OK;
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
     rp_calib_params_t calib = calib_GetParams();
     uint32_t amp_max = channel == RP_CH_1 ? calib.be_ch1_fs: calib.be_ch2_fs;
@@ -114,7 +124,7 @@ int generate_getAmplitude(rp_channel_t channel, float *amplitude) {
 }
 
 int generate_setDCOffset(rp_channel_t channel, float offset) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
     rp_calib_params_t calib = calib_GetParams();
     int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
@@ -122,11 +132,11 @@ int generate_setDCOffset(rp_channel_t channel, float offset) {
 
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->amplitudeOffset = cmn_CnvVToCnt(DATA_BIT_LENGTH, offset, (float) (OFFSET_MAX/2.f), false, amp_max, dc_offs, 0);
-    return RP_OK;
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_getDCOffset(rp_channel_t channel, float *offset) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
 
     rp_calib_params_t calib = calib_GetParams();
     int dc_offs = channel == RP_CH_1 ? calib.be_ch1_dc_offs: calib.be_ch2_dc_offs;
@@ -138,15 +148,16 @@ int generate_getDCOffset(rp_channel_t channel, float *offset) {
 }
 
 int generate_setFrequency(rp_channel_t channel, float frequency) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->counterStep = (uint32_t) round(65536 * frequency / DAC_FREQUENCY * BUFFER_LENGTH);
-    channel == RP_CH_1 ? (generate->ASM_WrapPointer = 1) : (generate->BSM_WrapPointer = 1);
-    return RP_OK;
+    cmn_ShadowFlush(gen_shadow);
+    channel == RP_CH_1 ? (gen_shadow->ASM_WrapPointer = 1) : (gen_shadow->BSM_WrapPointer = 1);
+    return writeConf();
 }
 
 int generate_getFrequency(rp_channel_t channel, float *frequency) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     *frequency = (float) round((ch_properties->counterStep * DAC_FREQUENCY) / (65536 * BUFFER_LENGTH));
     return RP_OK;
@@ -154,76 +165,76 @@ int generate_getFrequency(rp_channel_t channel, float *frequency) {
 
 int generate_setWrapCounter(rp_channel_t channel, uint32_t size) {
     CHANNEL_ACTION(channel,
-            generate->properties_chA.counterWrap = 65536 * size - 1,
-            generate->properties_chB.counterWrap = 65536 * size - 1)
-    return RP_OK;
+            gen_shadow->properties_chA.counterWrap = 65536 * size - 1,
+            gen_shadow->properties_chB.counterWrap = 65536 * size - 1)
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_setTriggerSource(rp_channel_t channel, unsigned short value) {
     CHANNEL_ACTION(channel,
-            generate->AtriggerSelector = value,
-            generate->BtriggerSelector = value)
-    return RP_OK;
+            gen_shadow->AtriggerSelector = value,
+            gen_shadow->BtriggerSelector = value)
+    return writeConf();
 }
 
 int generate_getTriggerSource(rp_channel_t channel, uint32_t *value) {
     CHANNEL_ACTION(channel,
-            *value = generate->AtriggerSelector,
-            *value = generate->BtriggerSelector)
+            *value = gen_shadow->AtriggerSelector,
+            *value = gen_shadow->BtriggerSelector)
     return RP_OK;
 }
 
 int generate_setGatedBurst(rp_channel_t channel, uint32_t value) {
     CHANNEL_ACTION(channel,
-            generate->AgatedBursts = value,
-            generate->BgatedBursts = value)
-    return RP_OK;
+            gen_shadow->AgatedBursts = value,
+            gen_shadow->BgatedBursts = value)
+    return writeConf();
 }
 
 int generate_getGatedBurst(rp_channel_t channel, uint32_t *value) {
     CHANNEL_ACTION(channel,
-            *value = generate->AgatedBursts,
-            *value = generate->BgatedBursts)
+            *value = gen_shadow->AgatedBursts,
+            *value = gen_shadow->BgatedBursts)
     return RP_OK;
 }
 
 int generate_setBurstCount(rp_channel_t channel, uint32_t num) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->cyclesInOneBurst = num;
-    return RP_OK;
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_getBurstCount(rp_channel_t channel, uint32_t *num) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     *num = ch_properties->cyclesInOneBurst;
     return RP_OK;
 }
 
 int generate_setBurstRepetitions(rp_channel_t channel, uint32_t repetitions) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->burstRepetitions = repetitions;
-    return RP_OK;
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_getBurstRepetitions(rp_channel_t channel, uint32_t *repetitions) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     *repetitions = ch_properties->burstRepetitions;
     return RP_OK;
 }
 
 int generate_setBurstDelay(rp_channel_t channel, uint32_t delay) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     ch_properties->delayBetweenBurstRepetitions = delay;
-    return RP_OK;
+    return cmn_ShadowFlush(gen_shadow);
 }
 
 int generate_getBurstDelay(rp_channel_t channel, uint32_t *delay) {
-    volatile ch_properties_t *ch_properties;
+    ch_properties_t *ch_properties;
     getChannelPropertiesAddress(&ch_properties, channel);
     *delay = ch_properties->delayBetweenBurstRepetitions;
     return RP_OK;
@@ -248,7 +259,7 @@ int generate_writeData(rp_channel_t channel, float *data, uint32_t start, uint32
             dataOut = data_chA,
             dataOut = data_chB)
 
-    volatile ch_properties_t *properties;
+    ch_properties_t *properties;
     getChannelPropertiesAddress(&properties, channel);
     generate_setWrapCounter(channel, length);
 
@@ -11,22 +11,36 @@
 #include "common.h"
 #include "limit.h"
 #include "calib.h"
+#include "sim.h"
 
 // The FPGA register structure for the Limiter
 static volatile limit_control_t *limit_reg = NULL;
+// Its shadow copy; setters change it and flush it to the registers
+static limit_control_t *limit_shadow = NULL;
 static int fd = 0;
 
 int limit_Init() {
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        ECHECK(cmn_Map(LIMIT_BASE_SIZE, SIM_LIMIT_OFFSET, (void **) &limit_reg));
+        return cmn_ShadowAttach(limit_reg, sizeof(limit_control_t), "limit", (void **) &limit_shadow);
+    }
+
     if (!fd) {
         if((fd = open("/dev/mem", O_RDWR | O_SYNC)) == -1) {
             return RP_EOMD;
         }
     }
     limit_reg = mmap(NULL, LIMIT_BASE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, LIMIT_BASE_ADDR);
-    return RP_OK;
+    return cmn_ShadowAttach(limit_reg, sizeof(limit_control_t), "limit", (void **) &limit_shadow);
 }
 
 int limit_Release() {
+    cmn_ShadowDetach((void **) &limit_shadow);
+
+    if (cmn_GetBackend() == RP_BACKEND_SIM) {
+        return cmn_Unmap(LIMIT_BASE_SIZE, (void **) &limit_reg);
+    }
+
     if(fd == -1) {
         return RP_EUMD;
     }
@@ -52,14 +66,14 @@ int limit_LimitMin(rp_channel_t channel, float value) {
     rp_calib_params_t calib = calib_GetParams();
 
     if (channel == RP_CH_1) {
-        limit_reg->ch_a_min = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
-                                            calib.be_ch1_fs, calib.be_ch1_dc_offs, 0);
-        return RP_OK;
+        limit_shadow->ch_a_min = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
+                                               calib.be_ch1_fs, calib.be_ch1_dc_offs, 0);
+        return cmn_ShadowFlush(limit_shadow);
     }
     else if (channel == RP_CH_2) {
-        limit_reg->ch_b_min = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
-                                            calib.be_ch2_fs, calib.be_ch2_dc_offs, 0);
-        return RP_OK;
+        limit_shadow->ch_b_min = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
+                                               calib.be_ch2_fs, calib.be_ch2_dc_offs, 0);
+        return cmn_ShadowFlush(limit_shadow);
     }
     else
         return RP_EPN;
@@ -69,14 +83,14 @@ int limit_LimitMax(rp_channel_t channel, float value) {
     rp_calib_params_t calib = calib_GetParams();
 
     if (channel == RP_CH_1) {
-        limit_reg->ch_a_max = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
-                                            calib.be_ch1_fs, calib.be_ch1_dc_offs, 0);
-        return RP_OK;
+        limit_shadow->ch_a_max = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
+                                               calib.be_ch1_fs, calib.be_ch1_dc_offs, 0);
+        return cmn_ShadowFlush(limit_shadow);
     }
     else if (channel == RP_CH_2) {
-        limit_reg->ch_b_max = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
-                                            calib.be_ch2_fs, calib.be_ch2_dc_offs, 0);
-        return RP_OK;
+        limit_shadow->ch_b_max = cmn_CnvVToCnt(DATA_BIT_LENGTH, value, LIMIT_MAX, false,
+                                               calib.be_ch2_fs, calib.be_ch2_dc_offs, 0);
+        return cmn_ShadowFlush(limit_shadow);
     }
 
     else
@@ -87,12 +101,12 @@ int limit_LimitGetMin(rp_channel_t channel, float *value) {
     rp_calib_params_t calib = calib_GetParams();
 
     if (channel == RP_CH_1) {
-        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_reg->ch_a_min, LIMIT_MAX, calib.be_ch1_fs,
+        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_shadow->ch_a_min, LIMIT_MAX, calib.be_ch1_fs,
                                calib.be_ch1_dc_offs, 0);
         return RP_OK;
     }
     else if (channel == RP_CH_2) {
-        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_reg->ch_b_min, LIMIT_MAX, calib.be_ch2_fs,
+        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_shadow->ch_b_min, LIMIT_MAX, calib.be_ch2_fs,
                                calib.be_ch2_dc_offs, 0);
         return RP_OK;
     }
@@ -103,15 +117,25 @@ int limit_LimitGetMax(rp_channel_t channel, float *value) {
     rp_calib_params_t calib = calib_GetParams();
 
     if (channel == RP_CH_1) {
-        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_reg->ch_a_max, LIMIT_MAX, calib.be_ch1_fs,
+        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_shadow->ch_a_max, LIMIT_MAX, calib.be_ch1_fs,
                                calib.be_ch1_dc_offs, 0);
         return RP_OK;
     }
     else if (channel == RP_CH_2) {
-        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_reg->ch_b_max, LIMIT_MAX, calib.be_ch2_fs,
+        *value = cmn_CnvCntToV(DATA_BIT_LENGTH, limit_shadow->ch_b_max, LIMIT_MAX, calib.be_ch2_fs,
                                calib.be_ch2_dc_offs, 0);
         return RP_OK;
     }
     else
         return RP_EPN;
 }
+
+int limit_GetImage(limit_control_t *image) {
+    *image = *limit_shadow;
+    return RP_OK;
+}
+
+int limit_ApplyImage(const limit_control_t *image) {
+    *limit_shadow = *image;
+    return cmn_ShadowFlush(limit_shadow);
+}
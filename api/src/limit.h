@@ -34,5 +34,7 @@ int limit_LimitMin(rp_channel_t channel, float value);
 int limit_LimitMax(rp_channel_t channel, float value);
 int limit_LimitGetMin(rp_channel_t channel, float *value);
 int limit_LimitGetMax(rp_channel_t channel, float *value);
+int limit_GetImage(limit_control_t *image);
+int limit_ApplyImage(const limit_control_t *image);
 
 #endif //__LIMIT_H
@@ -17,6 +17,8 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "redpitaya/version.h"
 #include "common.h"
@@ -29,6 +31,11 @@
 #include "gen_handler.h"
 #include "pid.h"
 #include "limit.h"
+#include "preset.h"
+#include "config.h"
+#include "psd.h"
+#include "bode.h"
+#include "sim.h"
 
 static char version[50];
 
@@ -38,7 +45,23 @@ static char version[50];
 
 int rp_Init()
 {
-    cmn_Init();
+    const char *backend = getenv(SIM_BACKEND_ENV);
+
+    if (backend && !strcmp(backend, "sim")) {
+        return rp_InitWithBackend(RP_BACKEND_SIM);
+    }
+    return rp_InitWithBackend(RP_BACKEND_UIO);
+}
+
+int rp_InitWithBackend(rp_backend_t backend)
+{
+    ECHECK(cmn_SetBackend(backend));
+
+    // The hardware backend keeps going without /dev/uio/api, as before
+    int result = cmn_Init();
+    if (result != RP_OK && backend == RP_BACKEND_SIM) {
+        return result;
+    }
 
     calib_Init();
     hk_Init();
@@ -64,6 +87,9 @@ int rp_CalibInit()
 
 int rp_Release()
 {
+    psd_Stop();
+    bode_Stop();
+    acq_axi_Release();
     osc_Release();
     generate_Release();
     ams_Release();
@@ -119,6 +145,10 @@ const char* rp_GetError(int errorCode) {
         case RP_EFWB:  return "Failed to write to the bus";
         case RP_EOCF:  return "Failed to open config file.";
         case RP_EICV:  return "Incompatible config file version";
+        case RP_EPNF:  return "Preset does not exist";
+        case RP_ECCF:  return "Config file is corrupted";
+        case RP_ENDA:  return "No data available";
+        case RP_ETMO:  return "Operation timed out";
         default:       return "Unknown error";
     }
 }
@@ -550,6 +580,11 @@ int rp_AcqGetTriggerState(rp_acq_trig_state_t* state)
     return acq_GetTriggerState(state);
 }
 
+int rp_AcqWaitTrigger(uint32_t timeout_ms)
+{
+    return acq_WaitTrigger(timeout_ms);
+}
+
 int rp_AcqSetTriggerDelay(int32_t decimated_data_num)
 {
     return acq_SetTriggerDelay(decimated_data_num, false);
@@ -692,6 +727,92 @@ int rp_AcqGetBufSize(uint32_t *size) {
     return acq_GetBufferSize(size);
 }
 
+int rp_AcqAxiSetBuffer(rp_channel_t channel, uint32_t address, uint32_t size)
+{
+    return acq_axi_SetBuffer(channel, address, size);
+}
+
+int rp_AcqAxiGetBuffer(rp_channel_t channel, const int16_t** buffer, uint32_t* samples)
+{
+    return acq_axi_GetBuffer(channel, buffer, samples);
+}
+
+int rp_AcqAxiEnable(rp_channel_t channel, bool enable)
+{
+    return acq_axi_Enable(channel, enable);
+}
+
+int rp_AcqAxiIsEnabled(rp_channel_t channel, bool* enabled)
+{
+    return acq_axi_IsEnabled(channel, enabled);
+}
+
+int rp_AcqAxiGetWritePointer(rp_channel_t channel, uint32_t* pos)
+{
+    return acq_axi_GetWritePointer(channel, pos);
+}
+
+int rp_AcqAxiGetNewData(rp_channel_t channel, uint32_t* pos, uint32_t* size, uint32_t* overflows)
+{
+    return acq_axi_GetNewData(channel, pos, size, overflows);
+}
+
+int rp_AcqAxiConsume(rp_channel_t channel, uint32_t size)
+{
+    return acq_axi_Consume(channel, size);
+}
+
+int rp_AcqAxiGetDataRaw(rp_channel_t channel, uint32_t pos, uint32_t* size, int16_t* buffer)
+{
+    return acq_axi_GetDataRaw(channel, pos, size, buffer);
+}
+
+int rp_AcqAxiGetDataV(rp_channel_t channel, uint32_t pos, uint32_t* size, float* buffer)
+{
+    return acq_axi_GetDataV(channel, pos, size, buffer);
+}
+
+int rp_PsdStart(rp_channel_t channel, uint32_t segment_length, float overlap, uint32_t averages)
+{
+    return psd_Start(channel, segment_length, overlap, averages);
+}
+
+int rp_PsdStop()
+{
+    return psd_Stop();
+}
+
+int rp_PsdIsRunning(bool* running)
+{
+    return psd_IsRunning(running);
+}
+
+int rp_PsdGetSpectrum(float* buffer, uint32_t* size, float* bin_width, uint32_t* count)
+{
+    return psd_GetSpectrum(buffer, size, bin_width, count);
+}
+
+int rp_BodeStart(rp_channel_t excitation, float amplitude, float start_frequency, float stop_frequency,
+                 uint32_t points, float settle_time, uint32_t cycles)
+{
+    return bode_Start(excitation, amplitude, start_frequency, stop_frequency, points, settle_time, cycles);
+}
+
+int rp_BodeStop()
+{
+    return bode_Stop();
+}
+
+int rp_BodeIsRunning(bool* running)
+{
+    return bode_IsRunning(running);
+}
+
+int rp_BodeGetData(rp_bode_point_t* points, uint32_t* size)
+{
+    return bode_GetData(points, size);
+}
+
 /**
 * Generate methods
 */
@@ -866,6 +987,13 @@ int rp_PIDGetKg(rp_pid_t pid, float *kg) {
     return pid_GetPIDKg(pid, kg);
 }
 
+int rp_PIDSetParams(rp_pid_t pid, const rp_pid_params_t *params) {
+    return pid_SetPIDParams(pid, params);
+}
+int rp_PIDGetParams(rp_pid_t pid, rp_pid_params_t *params) {
+    return pid_GetPIDParams(pid, params);
+}
+
 int rp_PIDSetIntReset(rp_pid_t pid, bool enable) {
     return pid_SetPIDIntReset(pid, enable);
 }
@@ -917,6 +1045,14 @@ int rp_PIDGetLockStatus(rp_pid_t pid, bool *lock_status) {
     return pid_GetPIDLockStatus(pid, lock_status);
 }
 
+int rp_PIDGetLockStats(rp_pid_t pid, rp_pid_lock_stats_t *stats) {
+    return pid_GetLockStats(pid, stats);
+}
+
+int rp_PIDResetLockStats(rp_pid_t pid) {
+    return pid_ResetLockStats(pid);
+}
+
 int rp_PIDSetRelockStepsize(rp_pid_t pid, float stepsize) {
     return pid_SetRelockStepsize(pid, stepsize);
 }
@@ -973,6 +1109,54 @@ int rp_PIDGetExtResetInput(rp_pid_t pid, rp_dpin_t *pin) {
     return pid_GetExtResetInput(pid, pin);
 }
 
+int rp_PIDSetInput(rp_pid_t pid, rp_pid_input_t input) {
+    return pid_SetPIDInput(pid, input);
+}
+
+int rp_PIDGetInput(rp_pid_t pid, rp_pid_input_t *input) {
+    return pid_GetPIDInput(pid, input);
+}
+
+int rp_PIDSetIQFrequency(rp_channel_t channel, float frequency) {
+    return pid_SetIQFrequency(channel, frequency);
+}
+
+int rp_PIDGetIQFrequency(rp_channel_t channel, float *frequency) {
+    return pid_GetIQFrequency(channel, frequency);
+}
+
+int rp_PIDSetIQPhase(rp_channel_t channel, float phase) {
+    return pid_SetIQPhase(channel, phase);
+}
+
+int rp_PIDGetIQPhase(rp_channel_t channel, float *phase) {
+    return pid_GetIQPhase(channel, phase);
+}
+
+int rp_PIDSetIQBandwidth(rp_channel_t channel, float bandwidth) {
+    return pid_SetIQBandwidth(channel, bandwidth);
+}
+
+int rp_PIDGetIQBandwidth(rp_channel_t channel, float *bandwidth) {
+    return pid_GetIQBandwidth(channel, bandwidth);
+}
+
+int rp_PIDSetIQGain(rp_channel_t channel, float gain) {
+    return pid_SetIQGain(channel, gain);
+}
+
+int rp_PIDGetIQGain(rp_channel_t channel, float *gain) {
+    return pid_GetIQGain(channel, gain);
+}
+
+int rp_PIDSetIQReference(rp_channel_t channel, rp_iq_ref_t reference) {
+    return pid_SetIQReference(channel, reference);
+}
+
+int rp_PIDGetIQReference(rp_channel_t channel, rp_iq_ref_t *reference) {
+    return pid_GetIQReference(channel, reference);
+}
+
 /**
  * Output limiter
  */
@@ -990,103 +1174,37 @@ int rp_LimitGetMax(rp_channel_t channel, float *value) {
 }
 
 int rp_SaveLockboxConfig() {
-    rp_lockbox_params_t config;
-    config.config_version = LOCKBOX_CONFIG_VERSION;
-    for (int i=0; i<4; i++) {
-        rp_PIDGetSetpoint(i, &config.pid_setpoint[i]);
-        rp_PIDGetKp(i, &config.pid_kp[i]);
-        rp_PIDGetKi(i, &config.pid_ki[i]);
-        rp_PIDGetKd(i, &config.pid_kd[i]);
-        rp_PIDGetKii(i, &config.pid_kii[i]);
-        rp_PIDGetKg(i, &config.pid_kg[i]);
-        rp_PIDGetIntReset(i, &config.pid_int_reset[i]);
-        rp_PIDGetInverted(i, &config.pid_inverted[i]);
-        rp_PIDGetResetWhenRailed(i, &config.pid_reset_when_railed[i]);
-        rp_PIDGetHold(i, &config.pid_hold[i]);
-        rp_PIDGetRelock(i, &config.pid_relock_enabled[i]);
-        rp_PIDGetEnable(i, &config.pid_enabled[i]);
-        rp_PIDGetRelockStepsize(i, &config.pid_relock_stepsize[i]);
-        rp_PIDGetRelockMinimum(i, &config.pid_relock_minimum[i]);
-        rp_PIDGetRelockMaximum(i, &config.pid_relock_maximum[i]);
-        rp_PIDGetRelockInput(i, &config.pid_relock_input[i]);
-        rp_PIDGetLockStatusOutputEnable(i, &config.pid_lso_enabled[i]);
-        rp_PIDGetExtResetEnable(i, &config.pid_ext_reset_enabled[i]);
-        rp_PIDGetExtResetInput(i, &config.pid_ext_reset_input[i]);
-    }
-    for (int i=0; i<2; i++) {
-        rp_LimitGetMin(i, &config.limit_min[i]);
-        rp_LimitGetMax(i, &config.limit_max[i]);
-        rp_GenOutIsEnabled(i, &config.gen_enabled[i]);
-        rp_GenPOffsetIsEnabled(i, &config.gen_poffset_enabled[i]);
-        rp_GenGetAmp(i, &config.gen_amp[i]);
-        rp_GenGetOffset(i, &config.gen_offset[i]);
-        rp_GenGetFreq(i, &config.gen_freq[i]);
-        rp_GenGetWaveform(i, &config.gen_waveform[i]);
-    }
-    FILE *configfile;
-    configfile = fopen(CONFIG_FILE_PATH, "w");
-
-    if (configfile == NULL)
-        return RP_EOCF;
-
-    fwrite(&config, sizeof(rp_lockbox_params_t), 1, configfile);
-    fclose(configfile);
-    return RP_OK;
+    return config_Save(CONFIG_FILE_PATH);
 }
 
 int rp_LoadLockboxConfig() {
-    rp_lockbox_params_t config;
-
-    FILE *configfile;
-    configfile = fopen(CONFIG_FILE_PATH, "r");
-
-    if (configfile == NULL)
-        return RP_EOCF;
-    (void)!fread(&config, sizeof(rp_lockbox_params_t), 1, configfile);
-    fclose(configfile);
-
-    if (config.config_version != LOCKBOX_CONFIG_VERSION)
-        return RP_EICV;
+    return config_Load(CONFIG_FILE_PATH);
+}
 
+int rp_GetLockboxSnapshot(rp_lockbox_snapshot_t *snapshot) {
+    config_GetParams(&snapshot->params);
     for (int i=0; i<4; i++) {
-        rp_PIDSetSetpoint(i, config.pid_setpoint[i]);
-        rp_PIDSetKp(i, config.pid_kp[i]);
-        rp_PIDSetKi(i, config.pid_ki[i]);
-        rp_PIDSetKd(i, config.pid_kd[i]);
-        rp_PIDSetKii(i, config.pid_kii[i]);
-        rp_PIDSetKg(i, config.pid_kg[i]);
-        rp_PIDSetIntReset(i, config.pid_int_reset[i]);
-        rp_PIDSetInverted(i, config.pid_inverted[i]);
-        rp_PIDSetResetWhenRailed(i, config.pid_reset_when_railed[i]);
-        rp_PIDSetHold(i, config.pid_hold[i]);
-        rp_PIDSetRelock(i, config.pid_relock_enabled[i]);
-        rp_PIDSetEnable(i, config.pid_enabled[i]);
-        rp_PIDSetRelockStepsize(i, config.pid_relock_stepsize[i]);
-        rp_PIDSetRelockMinimum(i, config.pid_relock_minimum[i]);
-        rp_PIDSetRelockMaximum(i, config.pid_relock_maximum[i]);
-        rp_PIDSetRelockInput(i, config.pid_relock_input[i]);
-        rp_PIDSetLockStatusOutputEnable(i, config.pid_lso_enabled[i]);
-        rp_PIDSetExtResetEnable(i, config.pid_ext_reset_enabled[i]);
-        rp_PIDSetExtResetInput(i, config.pid_ext_reset_input[i]);
+        ECHECK(rp_PIDGetLockStatus(i, &snapshot->pid_lock_status[i]));
+        ECHECK(rp_ApinGetValue(RP_AIN0 + i, &snapshot->ain_voltage[i]));
     }
     for (int i=0; i<2; i++) {
-        rp_LimitMin(i, config.limit_min[i]);
-        rp_LimitMax(i, config.limit_max[i]);
-        if (config.gen_enabled[i])
-            rp_GenOutEnable(i);
-        else
-            rp_GenOutDisable(i);
-        if (config.gen_poffset_enabled[i])
-            rp_GenPOffsetEnable(i);
-        else
-            rp_GenPOffsetDisable(i);
-        rp_GenAmp(i, config.gen_amp[i]);
-        rp_GenOffset(i, config.gen_offset[i]);
-        rp_GenFreq(i, config.gen_freq[i]);
-        rp_GenWaveform(i, config.gen_waveform[i]);
+        ECHECK(rp_GetInVoltage(i, &snapshot->in_voltage[i]));
+        ECHECK(rp_GetOutVoltage(i, &snapshot->out_voltage[i]));
     }
     return RP_OK;
-};
+}
+
+int rp_PresetStore(const char *name) {
+    return preset_Store(name);
+}
+
+int rp_PresetApply(const char *name) {
+    return preset_Apply(name);
+}
+
+int rp_PresetDelete(const char *name) {
+    return preset_Delete(name);
+}
 
 float rp_CmnCnvCntToV(uint32_t field_len, uint32_t cnts, float adc_max_v, uint32_t calibScale, int calib_dc_off, float user_dc_off)
 {
@@ -99,11 +99,21 @@ int osc_WriteDataIntoMemory(bool enable)
     }
 }
 
+int osc_GetWriteDataIntoMemory(bool* enabled)
+{
+    return cmn_AreBitsSet(osc_reg->conf, 0x1, START_DATA_WRITE_MASK, enabled);
+}
+
 int osc_ResetWriteStateMachine()
 {
     return cmn_SetBits(&osc_reg->conf, (0x1 << 1), RST_WR_ST_MCH_MASK);
 }
 
+int osc_GetResetWriteStateMachine(bool* reset)
+{
+    return cmn_AreBitsSet(osc_reg->conf, (0x1 << 1), RST_WR_ST_MCH_MASK, reset);
+}
+
 int osc_SetArmKeep(bool enable)
 {
     if (enable)
@@ -247,3 +257,61 @@ const volatile uint32_t* osc_GetDataBufferChB()
 {
     return osc_chb;
 }
+
+/**
+ * AXI (DDR) writers
+ */
+int osc_axi_SetBufferAddress(rp_channel_t channel, uint32_t start, uint32_t stop)
+{
+    CHANNEL_ACTION(channel,
+            cmn_SetValue(&osc_reg->cha_axi_start, start, AXI_ADDRESS_MASK);
+            cmn_SetValue(&osc_reg->cha_axi_stop, stop, AXI_ADDRESS_MASK),
+            cmn_SetValue(&osc_reg->chb_axi_start, start, AXI_ADDRESS_MASK);
+            cmn_SetValue(&osc_reg->chb_axi_stop, stop, AXI_ADDRESS_MASK))
+    return RP_OK;
+}
+
+int osc_axi_GetBufferAddress(rp_channel_t channel, uint32_t* start, uint32_t* stop)
+{
+    CHANNEL_ACTION(channel,
+            cmn_GetValue(&osc_reg->cha_axi_start, start, AXI_ADDRESS_MASK);
+            cmn_GetValue(&osc_reg->cha_axi_stop, stop, AXI_ADDRESS_MASK),
+            cmn_GetValue(&osc_reg->chb_axi_start, start, AXI_ADDRESS_MASK);
+            cmn_GetValue(&osc_reg->chb_axi_stop, stop, AXI_ADDRESS_MASK))
+    return RP_OK;
+}
+
+int osc_axi_SetTriggerDelay(rp_channel_t channel, uint32_t decimated_data_num)
+{
+    CHANNEL_ACTION(channel,
+            return cmn_SetValue(&osc_reg->cha_axi_dly, decimated_data_num, TRIG_DELAY_MASK),
+            return cmn_SetValue(&osc_reg->chb_axi_dly, decimated_data_num, TRIG_DELAY_MASK))
+}
+
+int osc_axi_Enable(rp_channel_t channel, bool enable)
+{
+    CHANNEL_ACTION(channel,
+            return cmn_SetValue(&osc_reg->cha_axi_en, enable ? 1 : 0, AXI_ENABLE_MASK),
+            return cmn_SetValue(&osc_reg->chb_axi_en, enable ? 1 : 0, AXI_ENABLE_MASK))
+}
+
+int osc_axi_IsEnabled(rp_channel_t channel, bool* enabled)
+{
+    CHANNEL_ACTION(channel,
+            return cmn_AreBitsSet(osc_reg->cha_axi_en, 0x1, AXI_ENABLE_MASK, enabled),
+            return cmn_AreBitsSet(osc_reg->chb_axi_en, 0x1, AXI_ENABLE_MASK, enabled))
+}
+
+int osc_axi_GetWritePointer(rp_channel_t channel, uint32_t* address)
+{
+    CHANNEL_ACTION(channel,
+            return cmn_GetValue(&osc_reg->cha_axi_cur, address, AXI_ADDRESS_MASK),
+            return cmn_GetValue(&osc_reg->chb_axi_cur, address, AXI_ADDRESS_MASK))
+}
+
+int osc_axi_GetWritePointerAtTrig(rp_channel_t channel, uint32_t* address)
+{
+    CHANNEL_ACTION(channel,
+            return cmn_GetValue(&osc_reg->cha_axi_trig, address, AXI_ADDRESS_MASK),
+            return cmn_GetValue(&osc_reg->chb_axi_trig, address, AXI_ADDRESS_MASK))
+}
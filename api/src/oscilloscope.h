@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "redpitaya/lockbox.h"
 
 // Base Oscilloscope address
 static const int OSC_BASE_ADDR = 0x00100000;
@@ -179,8 +180,56 @@ typedef struct osc_control_s {
      */
     uint32_t chb_filt_pp;
 
+    /** @brief Offset 0x50 - ChA AXI (DDR) buffer start address
+     * bits [31:0] - physical start address, 8 byte aligned
+     */
+    uint32_t cha_axi_start;
+
+    /** @brief Offset 0x54 - ChA AXI (DDR) buffer stop address
+     * bits [31:0] - physical address of the last 8 byte word of the buffer;
+     * the writer wraps around to the start address after it
+     */
+    uint32_t cha_axi_stop;
+
+    /** @brief Offset 0x58 - ChA AXI after trigger delay
+     * bits [31:0] - number of decimated samples written after the trigger
+     */
+    uint32_t cha_axi_dly;
+
+    /** @brief Offset 0x5C - ChA AXI enable
+     * bit [0] - write ChA data into DDR while the scope is armed
+     */
+    uint32_t cha_axi_en;
+
+    /** @brief Offset 0x60 - ChA AXI write pointer at trigger (read only) */
+    uint32_t cha_axi_trig;
+
+    /** @brief Offset 0x64 - ChA AXI current write pointer (read only) */
+    uint32_t cha_axi_cur;
+
+    /* Reserved 0x68 & 0x6C */
+    uint32_t reserved_axi_a[2];
+
+    /** @brief Offset 0x70 - ChB AXI (DDR) buffer start address */
+    uint32_t chb_axi_start;
+
+    /** @brief Offset 0x74 - ChB AXI (DDR) buffer stop address */
+    uint32_t chb_axi_stop;
+
+    /** @brief Offset 0x78 - ChB AXI after trigger delay */
+    uint32_t chb_axi_dly;
+
+    /** @brief Offset 0x7C - ChB AXI enable */
+    uint32_t chb_axi_en;
+
+    /** @brief Offset 0x80 - ChB AXI write pointer at trigger (read only) */
+    uint32_t chb_axi_trig;
+
+    /** @brief Offset 0x84 - ChB AXI current write pointer (read only) */
+    uint32_t chb_axi_cur;
+
     /* Reserved 0x88 & 0x8C */
-    uint32_t reserved_4[16];
+    uint32_t reserved_axi_b[2];
 
     /**@brief Trigger debuncer time
     * bits [19:0] Number of ADC clock periods
@@ -209,6 +258,8 @@ static const uint32_t RST_WR_ST_MCH_MASK    = 0x2;          // (1st bit)
 static const uint32_t TRIG_ST_MCH_MASK      = 0x4;          // (2st bit)
 static const uint32_t PRE_TRIGGER_COUNTER   = 0xFFFFFFFF;   // (32 bit)
 static const uint32_t ARM_KEEP_MASK         = 0xF;          // (4 bit)
+static const uint32_t AXI_ADDRESS_MASK      = 0xFFFFFFFF;   // (32 bits)
+static const uint32_t AXI_ENABLE_MASK       = 0x1;          // (1 bit)
 
 
 int osc_Init();
@@ -221,7 +272,9 @@ int osc_GetAveraging(bool* enable);
 int osc_SetTriggerSource(uint32_t source);
 int osc_GetTriggerSource(uint32_t* source);
 int osc_WriteDataIntoMemory(bool enable);
+int osc_GetWriteDataIntoMemory(bool* enabled);
 int osc_ResetWriteStateMachine();
+int osc_GetResetWriteStateMachine(bool* reset);
 int osc_SetArmKeep(bool enable);
 int osc_GetTriggerState(bool *received);
 int osc_GetPreTriggerCounter(uint32_t *value);
@@ -245,4 +298,12 @@ int osc_GetEqFiltersChB(uint32_t* coef_aa, uint32_t* coef_bb, uint32_t* coef_kk,
 const volatile uint32_t* osc_GetDataBufferChA();
 const volatile uint32_t* osc_GetDataBufferChB();
 
+int osc_axi_SetBufferAddress(rp_channel_t channel, uint32_t start, uint32_t stop);
+int osc_axi_GetBufferAddress(rp_channel_t channel, uint32_t* start, uint32_t* stop);
+int osc_axi_SetTriggerDelay(rp_channel_t channel, uint32_t decimated_data_num);
+int osc_axi_Enable(rp_channel_t channel, bool enable);
+int osc_axi_IsEnabled(rp_channel_t channel, bool* enabled);
+int osc_axi_GetWritePointer(rp_channel_t channel, uint32_t* address);
+int osc_axi_GetWritePointerAtTrig(rp_channel_t channel, uint32_t* address);
+
 #endif /* SRC_OSCILLOSCOPE_H_ */
@@ -25,6 +25,10 @@
 
 // The FPGA register structure for the PID
 static volatile pid_control_t *pid_reg = NULL;
+// Its shadow copy, which all configuration is read from
+static pid_control_t *pid_shadow = NULL;
+// Lock statistics of the PIDs, read from the registers themselves
+static volatile pid_lock_stats_t *pid_stats = NULL;
 
 
 /**
@@ -34,31 +38,85 @@ static volatile pid_control_t *pid_reg = NULL;
 int pid_Init()
 {
     cmn_Map(PID_BASE_SIZE, PID_BASE_ADDR, (void**)&pid_reg);
-    return RP_OK;
+    pid_stats = pid_reg ? (volatile pid_lock_stats_t *)((volatile uint8_t *)pid_reg + PID_LOCK_STATS_OFFSET) : NULL;
+    return cmn_ShadowAttach(pid_reg, sizeof(pid_control_t), "pid", (void**)&pid_shadow);
 }
 
 int pid_Release()
 {
+    cmn_ShadowDetach((void**)&pid_shadow);
     cmn_Unmap(PID_BASE_SIZE, (void**)&pid_reg);
+    pid_stats = NULL;
     return RP_OK;
 }
 
 /**
- * PID parameters
+ * Conversions to register values
  */
-int pid_SetPIDSetpoint(rp_pid_t pid, float setpoint)
+static int pid_CnvSetpointToCnt(rp_pid_t pid, float setpoint, uint32_t *counts)
 {
     rp_calib_params_t calib = calib_GetParams();
-    uint32_t setpoint_counts;
 
     if(pid == RP_PID_11 || pid == RP_PID_21)  // Input Channel A
-        setpoint_counts = cmn_CnvVToCnt(DATA_BIT_LENGTH, setpoint, SETPOINT_MAX, false,
+        *counts = cmn_CnvVToCnt(DATA_BIT_LENGTH, setpoint, SETPOINT_MAX, false,
             calib.fe_ch1_fs_g_hi, calib.fe_ch1_hi_offs, 0);
     else if (pid == RP_PID_22 || pid == RP_PID_12)  // Input Channel B
-        setpoint_counts = cmn_CnvVToCnt(DATA_BIT_LENGTH, setpoint, SETPOINT_MAX, false,
+        *counts = cmn_CnvVToCnt(DATA_BIT_LENGTH, setpoint, SETPOINT_MAX, false,
             calib.fe_ch2_fs_g_hi, calib.fe_ch2_hi_offs, 0);
     else
         return RP_EPN;
+    return RP_OK;
+}
+
+// Proportional and global gain
+static int pid_CnvPGainToCnt(float gain, uint32_t mask, uint32_t *counts)
+{
+    if(gain < 0) {
+        return RP_EIPV;
+    }
+
+    *counts = (int)round(gain * (1 << PID_PSR));
+    if(*counts > mask)  // check for integer overflow
+        *counts = mask;
+    return RP_OK;
+}
+
+// First and second integrator gain
+static int pid_CnvIGainToCnt(float gain, uint32_t mask, uint32_t *counts)
+{
+    if(gain < 0) {
+        return RP_EIPV;
+    }
+
+    *counts = (int)round(gain * (1 << PID_ISR) * PID_TIMESTEP);
+    if(*counts > mask) // check for integer overflow
+        *counts = mask;
+    return RP_OK;
+}
+
+// Derivative gain
+static int pid_CnvDGainToCnt(float gain, uint32_t mask, uint32_t *counts)
+{
+    if(gain < 0) {
+        return RP_EIPV;
+    }
+
+    *counts = (int)round(gain * (1 << PID_DSR) / PID_TIMESTEP);
+    if(*counts > mask) // check for integer overflow
+        *counts = mask;
+    return RP_OK;
+}
+
+/**
+ * PID parameters
+ */
+int pid_SetPIDSetpoint(rp_pid_t pid, float setpoint)
+{
+    uint32_t setpoint_counts;
+
+    int result = pid_CnvSetpointToCnt(pid, setpoint, &setpoint_counts);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_setpoint, setpoint_counts, PID_SETPOINT_MASK);
@@ -108,13 +166,9 @@ int pid_SetPIDKp(rp_pid_t pid, float kp)
 {
     uint32_t kp_integer;
 
-    if(kp < 0) {
-        return RP_EIPV;
-    }
-
-    kp_integer = (int)round(kp * (1 << PID_PSR));
-    if(kp_integer > PID_KP_MASK)  // check for integer overflow
-        kp_integer = PID_KP_MASK;
+    int result = pid_CnvPGainToCnt(kp, PID_KP_MASK, &kp_integer);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_Kp, kp_integer, PID_KP_MASK);
@@ -152,13 +206,9 @@ int pid_SetPIDKi(rp_pid_t pid, float ki)
 {
     uint32_t ki_integer;
 
-    if(ki < 0) {
-        return RP_EIPV;
-    }
-
-    ki_integer = (int)round(ki * (1 << PID_ISR) * PID_TIMESTEP);
-    if(ki_integer > PID_KI_MASK) // check for integer overflow
-        ki_integer = PID_KI_MASK;
+    int result = pid_CnvIGainToCnt(ki, PID_KI_MASK, &ki_integer);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_Ki, ki_integer, PID_KI_MASK);
@@ -196,13 +246,9 @@ int pid_SetPIDKd(rp_pid_t pid, float kd)
 {
     uint32_t kd_integer;
 
-    if(kd < 0) {
-        return RP_EIPV;
-    }
-
-    kd_integer = (int)round(kd * (1 << PID_DSR) / PID_TIMESTEP);
-    if(kd_integer > PID_KD_MASK) // check for integer overflow
-        kd_integer = PID_KD_MASK;
+    int result = pid_CnvDGainToCnt(kd, PID_KD_MASK, &kd_integer);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_Kd, kd_integer, PID_KD_MASK);
@@ -240,13 +286,9 @@ int pid_SetPIDKii(rp_pid_t pid, float kii)
 {
     uint32_t kii_integer;
 
-    if(kii < 0) {
-        return RP_EIPV;
-    }
-
-    kii_integer = (int)round(kii * (1 << PID_ISR) * PID_TIMESTEP);
-    if(kii_integer > PID_KII_MASK) // check for integer overflow
-        kii_integer = PID_KII_MASK;
+    int result = pid_CnvIGainToCnt(kii, PID_KII_MASK, &kii_integer);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_Kii, kii_integer, PID_KII_MASK);
@@ -284,13 +326,9 @@ int pid_SetPIDKg(rp_pid_t pid, float kg)
 {
     uint32_t kg_integer;
 
-    if(kg < 0) {
-        return RP_EIPV;
-    }
-
-    kg_integer = (int)round(kg * (1 << PID_PSR));
-    if(kg_integer > PID_KG_MASK)  // check for integer overflow
-        kg_integer = PID_KG_MASK;
+    int result = pid_CnvPGainToCnt(kg, PID_KG_MASK, &kg_integer);
+    if(result != RP_OK)
+        return result;
 
     switch(pid) {
         case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_Kg, kg_integer, PID_KG_MASK);
@@ -324,6 +362,52 @@ int pid_GetPIDKg(rp_pid_t pid, float *kg)
     return RP_OK;
 }
 
+int pid_SetPIDParams(rp_pid_t pid, const rp_pid_params_t *params)
+{
+    uint32_t setpoint_counts, kp_integer, ki_integer, kd_integer, kii_integer, kg_integer;
+    int result;
+
+    if(pid < RP_PID_11 || pid > RP_PID_22)
+        return RP_EPN;
+
+    // Convert everything first, so that nothing is written if a value is invalid
+    if((result = pid_CnvSetpointToCnt(pid, params->setpoint, &setpoint_counts)) != RP_OK ||
+       (result = pid_CnvPGainToCnt(params->kp, PID_KP_MASK, &kp_integer)) != RP_OK ||
+       (result = pid_CnvIGainToCnt(params->ki, PID_KI_MASK, &ki_integer)) != RP_OK ||
+       (result = pid_CnvDGainToCnt(params->kd, PID_KD_MASK, &kd_integer)) != RP_OK ||
+       (result = pid_CnvIGainToCnt(params->kii, PID_KII_MASK, &kii_integer)) != RP_OK ||
+       (result = pid_CnvPGainToCnt(params->kg, PID_KG_MASK, &kg_integer)) != RP_OK)
+        return result;
+
+    // The registers of the four PIDs are stored in the order of rp_pid_t.
+    // While the update hold bit is set, the FPGA keeps using the previous
+    // values; clearing it makes all new values take effect in the same cycle.
+    cmn_SetBits(&pid_reg->update_hold, 1 << pid, PID_UPDATE_HOLD_MASK);
+    (&pid_shadow->pid11_setpoint)[pid] = setpoint_counts & PID_SETPOINT_MASK;
+    (&pid_shadow->pid11_Kp)[pid] = kp_integer;
+    (&pid_shadow->pid11_Ki)[pid] = ki_integer;
+    (&pid_shadow->pid11_Kd)[pid] = kd_integer;
+    (&pid_shadow->pid11_Kii)[pid] = kii_integer;
+    (&pid_shadow->pid11_Kg)[pid] = kg_integer;
+    cmn_ShadowFlush(pid_shadow);
+    cmn_UnsetBits(&pid_reg->update_hold, 1 << pid, PID_UPDATE_HOLD_MASK);
+    return RP_OK;
+}
+
+int pid_GetPIDParams(rp_pid_t pid, rp_pid_params_t *params)
+{
+    int result;
+
+    if((result = pid_GetPIDSetpoint(pid, &params->setpoint)) != RP_OK ||
+       (result = pid_GetPIDKp(pid, &params->kp)) != RP_OK ||
+       (result = pid_GetPIDKi(pid, &params->ki)) != RP_OK ||
+       (result = pid_GetPIDKd(pid, &params->kd)) != RP_OK ||
+       (result = pid_GetPIDKii(pid, &params->kii)) != RP_OK ||
+       (result = pid_GetPIDKg(pid, &params->kg)) != RP_OK)
+        return result;
+    return RP_OK;
+}
+
 int pid_SetPIDIntReset(rp_pid_t pid, bool enable) {
     if(enable) {
         switch(pid) {
@@ -346,10 +430,10 @@ int pid_SetPIDIntReset(rp_pid_t pid, bool enable) {
 }
 int pid_GetPIDIntReset(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 1, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 2, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 3, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 1, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 2, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 3, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -377,10 +461,10 @@ int pid_SetPIDInverted(rp_pid_t pid, bool inverted) {
 
 int pid_GetPIDInverted(rp_pid_t pid, bool *inverted) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 4, PID_CONF_MASK, inverted);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 5, PID_CONF_MASK, inverted);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 6, PID_CONF_MASK, inverted);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 7, PID_CONF_MASK, inverted);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 4, PID_CONF_MASK, inverted);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 5, PID_CONF_MASK, inverted);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 6, PID_CONF_MASK, inverted);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 7, PID_CONF_MASK, inverted);
         default: return RP_EPN;
     }
 }
@@ -407,10 +491,10 @@ int pid_SetResetWhenRailed(rp_pid_t pid, bool enable) {
 }
 int pid_GetResetWhenRailed(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 8, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 9, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 10, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 11, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 8, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 9, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 10, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 11, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -438,10 +522,10 @@ int pid_SetHold(rp_pid_t pid, bool enable) {
 
 int pid_GetHold(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 12, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 13, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 14, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 15, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 12, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 13, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 14, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 15, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -469,10 +553,10 @@ int pid_SetPIDRelock(rp_pid_t pid, bool enable) {
 
 int pid_GetPIDRelock(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 16, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 17, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 18, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 19, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 16, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 17, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 18, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 19, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -500,15 +584,16 @@ int pid_SetPIDEnable(rp_pid_t pid, bool enable) {
 
 int pid_GetPIDEnable(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 20, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 21, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 22, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 23, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 20, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 21, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 22, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 23, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
 
 int pid_GetPIDLockStatus(rp_pid_t pid, bool *lock_status) {
+    // Set by the FPGA, so read from the register itself
     switch(pid) {
         case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 24, PID_CONF_MASK, lock_status);
         case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 25, PID_CONF_MASK, lock_status);
@@ -518,6 +603,35 @@ int pid_GetPIDLockStatus(rp_pid_t pid, bool *lock_status) {
     }
 }
 
+static double pid_CnvCyclesToTime(volatile const uint32_t *cycles)
+{
+    return (((uint64_t)cycles[1] << 32) | cycles[0]) * (double)PID_TIMESTEP;
+}
+
+int pid_GetLockStats(rp_pid_t pid, rp_pid_lock_stats_t *stats) {
+    if(pid < RP_PID_11 || pid > RP_PID_22)
+        return RP_EPN;
+
+    // Copy the counters of all PIDs at once, so that the values belong together
+    ECHECK(cmn_SetValue(&pid_reg->lock_stats, 0, PID_LOCK_STATS_MASK));
+
+    volatile const pid_lock_stats_t *regs = &pid_stats[pid];
+    stats->locked = regs->locked & 0x1;
+    stats->unlock_count = regs->unlock_count;
+    stats->unlocked_time = pid_CnvCyclesToTime(regs->unlocked_time);
+    stats->longest_outage = pid_CnvCyclesToTime(regs->longest_outage);
+    stats->last_unlock = pid_CnvCyclesToTime(regs->last_unlock);
+    stats->last_relock = pid_CnvCyclesToTime(regs->last_relock);
+    stats->timestamp = pid_CnvCyclesToTime(regs->timestamp);
+    return RP_OK;
+}
+
+int pid_ResetLockStats(rp_pid_t pid) {
+    if(pid < RP_PID_11 || pid > RP_PID_22)
+        return RP_EPN;
+    return cmn_SetValue(&pid_reg->lock_stats, 0x1 << pid, PID_LOCK_STATS_MASK);
+}
+
 int pid_SetRelockStepsize(rp_pid_t pid, float stepsize) {
     uint32_t stepsize_integer;
 
@@ -690,10 +804,10 @@ int pid_SetLockStatusOutputEnable(rp_pid_t pid, bool enable) {
 
 int pid_GetLockStatusOutputEnable(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 28, PID_CONF_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 29, PID_CONF_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 30, PID_CONF_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf, 0x1 << 31, PID_CONF_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 28, PID_CONF_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 29, PID_CONF_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 30, PID_CONF_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf, 0x1 << 31, PID_CONF_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -721,10 +835,10 @@ int pid_SetExtResetEnable(rp_pid_t pid, bool enable) {
 
 int pid_GetExtResetEnable(rp_pid_t pid, bool *enabled) {
     switch(pid) {
-        case RP_PID_11: return cmn_AreBitsSet(pid_reg->conf2, 0x1, PID_CONF2_MASK, enabled);
-        case RP_PID_12: return cmn_AreBitsSet(pid_reg->conf2, 0x1 << 1, PID_CONF2_MASK, enabled);
-        case RP_PID_21: return cmn_AreBitsSet(pid_reg->conf2, 0x1 << 2, PID_CONF2_MASK, enabled);
-        case RP_PID_22: return cmn_AreBitsSet(pid_reg->conf2, 0x1 << 3, PID_CONF2_MASK, enabled);
+        case RP_PID_11: return cmn_AreBitsSet(pid_shadow->conf2, 0x1, PID_CONF2_MASK, enabled);
+        case RP_PID_12: return cmn_AreBitsSet(pid_shadow->conf2, 0x1 << 1, PID_CONF2_MASK, enabled);
+        case RP_PID_21: return cmn_AreBitsSet(pid_shadow->conf2, 0x1 << 2, PID_CONF2_MASK, enabled);
+        case RP_PID_22: return cmn_AreBitsSet(pid_shadow->conf2, 0x1 << 3, PID_CONF2_MASK, enabled);
         default: return RP_EPN;
     }
 }
@@ -761,3 +875,187 @@ int pid_GetExtResetInput(rp_pid_t pid, rp_dpin_t *pin) {
     *pin = tmp_pin+RP_DIO5_P;
     return RP_OK;
 }
+
+/**
+ * Error signal and IQ demodulators
+ */
+int pid_SetPIDInput(rp_pid_t pid, rp_pid_input_t input) {
+    if (input > RP_PID_INPUT_IQ_Q)
+        return RP_EPN;
+    switch(pid) {
+        case RP_PID_11: return cmn_SetValue(&pid_reg->pid11_input, input, PID_INPUT_MASK);
+        case RP_PID_12: return cmn_SetValue(&pid_reg->pid12_input, input, PID_INPUT_MASK);
+        case RP_PID_21: return cmn_SetValue(&pid_reg->pid21_input, input, PID_INPUT_MASK);
+        case RP_PID_22: return cmn_SetValue(&pid_reg->pid22_input, input, PID_INPUT_MASK);
+        default: return RP_EPN;
+    }
+}
+int pid_GetPIDInput(rp_pid_t pid, rp_pid_input_t *input) {
+    uint32_t value;
+    switch(pid) {
+        case RP_PID_11:
+            cmn_GetValue(&pid_reg->pid11_input, &value, PID_INPUT_MASK);
+            break;
+        case RP_PID_12:
+            cmn_GetValue(&pid_reg->pid12_input, &value, PID_INPUT_MASK);
+            break;
+        case RP_PID_21:
+            cmn_GetValue(&pid_reg->pid21_input, &value, PID_INPUT_MASK);
+            break;
+        case RP_PID_22:
+            cmn_GetValue(&pid_reg->pid22_input, &value, PID_INPUT_MASK);
+            break;
+        default: return RP_EPN;
+    }
+    *input = value;
+    return RP_OK;
+}
+
+int pid_SetIQFrequency(rp_channel_t channel, float frequency) {
+    volatile uint32_t *reg;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_frequency,
+            reg = &pid_reg->iq_b_frequency)
+    if (!(frequency >= 0 && frequency <= 0.5 / PID_TIMESTEP))
+        return RP_EOOR;
+    uint32_t counts = (uint32_t)llround(frequency * PID_TIMESTEP * IQ_PHASE_RANGE);
+    return cmn_SetValue(reg, counts, IQ_FREQUENCY_MASK);
+}
+int pid_GetIQFrequency(rp_channel_t channel, float *frequency) {
+    volatile uint32_t *reg;
+    uint32_t counts;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_frequency,
+            reg = &pid_reg->iq_b_frequency)
+    cmn_GetValue(reg, &counts, IQ_FREQUENCY_MASK);
+    *frequency = counts / (PID_TIMESTEP * IQ_PHASE_RANGE);
+    return RP_OK;
+}
+
+// Phase in degrees, any value is wrapped to 0 - 360
+int pid_SetIQPhase(rp_channel_t channel, float phase) {
+    volatile uint32_t *reg;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_phase,
+            reg = &pid_reg->iq_b_phase)
+    if (!isfinite(phase))
+        return RP_EOOR;
+    double turns = fmod(phase / 360.0, 1.0);
+    if (turns < 0)
+        turns += 1.0;
+    uint32_t counts = (uint32_t)((uint64_t)llround(turns * IQ_PHASE_RANGE) & IQ_PHASE_MASK);
+    return cmn_SetValue(reg, counts, IQ_PHASE_MASK);
+}
+int pid_GetIQPhase(rp_channel_t channel, float *phase) {
+    volatile uint32_t *reg;
+    uint32_t counts;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_phase,
+            reg = &pid_reg->iq_b_phase)
+    cmn_GetValue(reg, &counts, IQ_PHASE_MASK);
+    *phase = counts * 360.0 / IQ_PHASE_RANGE;
+    return RP_OK;
+}
+
+// Corner frequency of each of the two low-pass filters, rounded to a power of two
+int pid_SetIQBandwidth(rp_channel_t channel, float bandwidth) {
+    volatile uint32_t *reg;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    if (!(bandwidth > 0))
+        return RP_EOOR;
+    long shift = lround(log2(1.0 / (2 * M_PI * PID_TIMESTEP * bandwidth)));
+    if (shift < 0)
+        shift = 0;
+    if (shift > IQ_BANDWIDTH_SHIFT_MAX)
+        shift = IQ_BANDWIDTH_SHIFT_MAX;
+    return cmn_SetValue(reg, shift, IQ_BANDWIDTH_MASK);
+}
+int pid_GetIQBandwidth(rp_channel_t channel, float *bandwidth) {
+    volatile uint32_t *reg;
+    uint32_t shift;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    cmn_GetValue(reg, &shift, IQ_BANDWIDTH_MASK);
+    *bandwidth = 1.0 / (2 * M_PI * PID_TIMESTEP * (1 << shift));
+    return RP_OK;
+}
+
+// Output gain, rounded to a power of two
+int pid_SetIQGain(rp_channel_t channel, float gain) {
+    volatile uint32_t *reg;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    if (!(gain > 0))
+        return RP_EIPV;
+    long shift = lround(log2(gain));
+    if (shift < 0)
+        shift = 0;
+    if (shift > IQ_GAIN_SHIFT_MAX)
+        shift = IQ_GAIN_SHIFT_MAX;
+    return cmn_SetShiftedValue(reg, shift, IQ_GAIN_MASK, IQ_GAIN_BIT);
+}
+int pid_GetIQGain(rp_channel_t channel, float *gain) {
+    volatile uint32_t *reg;
+    uint32_t shift;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    cmn_GetShiftedValue(reg, &shift, IQ_GAIN_MASK, IQ_GAIN_BIT);
+    *gain = 1 << shift;
+    return RP_OK;
+}
+
+int pid_SetIQReference(rp_channel_t channel, rp_iq_ref_t reference) {
+    volatile uint32_t *reg;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    if (reference > RP_IQ_REF_GEN_B)
+        return RP_EPN;
+    return cmn_SetShiftedValue(reg, reference, IQ_REFERENCE_MASK, IQ_REFERENCE_BIT);
+}
+int pid_GetIQReference(rp_channel_t channel, rp_iq_ref_t *reference) {
+    volatile uint32_t *reg;
+    uint32_t value;
+    CHANNEL_ACTION(channel,
+            reg = &pid_reg->iq_a_conf,
+            reg = &pid_reg->iq_b_conf)
+    cmn_GetShiftedValue(reg, &value, IQ_REFERENCE_MASK, IQ_REFERENCE_BIT);
+    *reference = value;
+    return RP_OK;
+}
+
+/**
+ * Returns the configuration registers of all PIDs.
+ */
+int pid_GetImage(pid_control_t *image)
+{
+    *image = *pid_shadow;
+    image->conf &= ~PID_CONF_LOCK_STATUS_MASK;
+    image->update_hold = 0;
+    image->lock_stats = 0;
+    return RP_OK;
+}
+
+/**
+ * Writes the configuration registers returned by pid_GetImage. Only the
+ * registers that differ are written. The setpoints and gains of all PIDs are
+ * held until the end, so that they take effect in the same clock cycle.
+ */
+int pid_ApplyImage(const pid_control_t *image)
+{
+    uint32_t update_hold = pid_shadow->update_hold;
+    uint32_t lock_status = pid_shadow->conf & PID_CONF_LOCK_STATUS_MASK;
+
+    cmn_SetBits(&pid_reg->update_hold, PID_UPDATE_HOLD_MASK, PID_UPDATE_HOLD_MASK);
+    uint32_t held = pid_shadow->update_hold;
+    *pid_shadow = *image;
+    pid_shadow->conf |= lock_status;
+    pid_shadow->update_hold = held;
+    cmn_ShadowFlush(pid_shadow);
+    return cmn_SetValue(&pid_reg->update_hold, update_hold, PID_UPDATE_HOLD_MASK);
+}
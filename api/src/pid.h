@@ -30,13 +30,14 @@
 
 // Base PID address
 static const int PID_BASE_ADDR = 0x00300000;
-static const int PID_BASE_SIZE = 0x4C;
+static const int PID_BASE_SIZE = 0x200;
 
 // PID structure declaration
 typedef struct pid_control_s {
     uint32_t conf;
     uint32_t conf2;
-    uint32_t reserved[2];
+    uint32_t update_hold;
+    uint32_t lock_stats;
     uint32_t pid11_setpoint;
     uint32_t pid12_setpoint;
     uint32_t pid21_setpoint;
@@ -81,10 +82,38 @@ typedef struct pid_control_s {
     uint32_t pid12_ext_reset_input;
     uint32_t pid21_ext_reset_input;
     uint32_t pid22_ext_reset_input;
+    uint32_t pid11_input;
+    uint32_t pid12_input;
+    uint32_t pid21_input;
+    uint32_t pid22_input;
+    uint32_t iq_a_frequency;
+    uint32_t iq_b_frequency;
+    uint32_t iq_a_phase;
+    uint32_t iq_b_phase;
+    uint32_t iq_a_conf;
+    uint32_t iq_b_conf;
 } pid_control_t;
 
+// Lock statistics of one PID, copied from the counters by a write to
+// lock_stats. Times are in clock cycles, split in low and high word.
+static const int PID_LOCK_STATS_OFFSET = 0x100;  // PID11, followed by PID12, 21, 22
+
+typedef struct pid_lock_stats_s {
+    uint32_t unlock_count;
+    uint32_t locked;
+    uint32_t unlocked_time[2];
+    uint32_t longest_outage[2];
+    uint32_t last_unlock[2];
+    uint32_t last_relock[2];
+    uint32_t timestamp[2];
+    uint32_t reserved[4];
+} pid_lock_stats_t;
+
 static const uint32_t PID_CONF_MASK = 0xFFFFFFFF; // (32 bits)
+static const uint32_t PID_CONF_LOCK_STATUS_MASK = 0x0F000000; // (4 bits, read only)
 static const uint32_t PID_CONF2_MASK = 0x0000000F; // (4 bits)
+static const uint32_t PID_UPDATE_HOLD_MASK = 0xF; // (4 bits)
+static const uint32_t PID_LOCK_STATS_MASK = 0xF; // (4 bits, write only)
 static const uint32_t PID_SETPOINT_MASK = 0x3FFF; // (14 bits)
 static const uint32_t PID_KP_MASK = 0xFFFFFF; // (24 bits)
 static const uint32_t PID_KI_MASK = 0xFFFFFF; // (24 bits)
@@ -95,6 +124,14 @@ static const uint32_t PID_RELOCK_INPUT_MASK = 0x3; // (2 bits)
 static const uint32_t PID_KII_MASK = 0xFFFFFF; // (24 bits)
 static const uint32_t PID_KG_MASK = 0xFFFFFF; // (24 bits)
 static const uint32_t PID_EXT_RESET_INPUT_MASK = 0x3; // (2 bits)
+static const uint32_t PID_INPUT_MASK = 0x3; // (2 bits)
+static const uint32_t IQ_FREQUENCY_MASK = 0xFFFFFFFF; // (32 bits)
+static const uint32_t IQ_PHASE_MASK = 0xFFFFFFFF; // (32 bits)
+static const uint32_t IQ_BANDWIDTH_MASK = 0x1F; // (5 bits, conf bits 4:0)
+static const uint32_t IQ_GAIN_MASK = 0xF; // (4 bits, conf bits 11:8)
+static const uint32_t IQ_REFERENCE_MASK = 0x3; // (2 bits, conf bits 17:16)
+static const uint32_t IQ_GAIN_BIT = 8;
+static const uint32_t IQ_REFERENCE_BIT = 16;
 
 static const float PID_TIMESTEP = 8E-9; // Inverse of the sampling rate
 static const float PID_DACCOUNT = 1.221E-4; // DAC count in V = 2V/2**14
@@ -103,6 +140,12 @@ static const uint32_t PID_ISR = 28; // I gain = Ki >> PID_PSR
 static const uint32_t PID_DSR = 8; // D gain = Kp >> PID_DSR
 // Slew rate (in DAC counts/clock cycle) = stepsize >> PID_STEPSR
 static const uint32_t PID_STEPSR = 18;
+// IQ demodulator: NCO and phase offset span 2^32 per period, the corner
+// frequency of its low-pass filters is 1 / (2*pi * PID_TIMESTEP * 2^shift)
+// and its output gain is 2^shift
+static const double IQ_PHASE_RANGE = 4294967296.0;
+static const uint32_t IQ_BANDWIDTH_SHIFT_MAX = 24;
+static const uint32_t IQ_GAIN_SHIFT_MAX = 14;
 
 int pid_Init();
 int pid_Release();
@@ -119,6 +162,8 @@ int pid_SetPIDKii(rp_pid_t pid, float kii);
 int pid_GetPIDKii(rp_pid_t pid, float *kii);
 int pid_SetPIDKg(rp_pid_t pid, float kg);
 int pid_GetPIDKg(rp_pid_t pid, float *kg);
+int pid_SetPIDParams(rp_pid_t pid, const rp_pid_params_t *params);
+int pid_GetPIDParams(rp_pid_t pid, rp_pid_params_t *params);
 int pid_SetPIDIntReset(rp_pid_t pid, bool enable);
 int pid_GetPIDIntReset(rp_pid_t pid, bool *enabled);
 int pid_SetPIDInverted(rp_pid_t pid, bool inverted);
@@ -132,6 +177,8 @@ int pid_GetPIDRelock(rp_pid_t pid, bool *enabled);
 int pid_SetPIDEnable(rp_pid_t pid, bool enable);
 int pid_GetPIDEnable(rp_pid_t pid, bool *enabled);
 int pid_GetPIDLockStatus(rp_pid_t pid, bool *lock_status);
+int pid_GetLockStats(rp_pid_t pid, rp_pid_lock_stats_t *stats);
+int pid_ResetLockStats(rp_pid_t pid);
 int pid_SetRelockStepsize(rp_pid_t pid, float stepsize);
 int pid_GetRelockStepsize(rp_pid_t pid, float *stepsize);
 int pid_SetRelockMinimum(rp_pid_t pid, float minimum);
@@ -146,5 +193,19 @@ int pid_SetExtResetEnable(rp_pid_t pid, bool enable);
 int pid_GetExtResetEnable(rp_pid_t pid, bool *enabled);
 int pid_SetExtResetInput(rp_pid_t pid, rp_dpin_t pin);
 int pid_GetExtResetInput(rp_pid_t pid, rp_dpin_t *pin);
+int pid_SetPIDInput(rp_pid_t pid, rp_pid_input_t input);
+int pid_GetPIDInput(rp_pid_t pid, rp_pid_input_t *input);
+int pid_SetIQFrequency(rp_channel_t channel, float frequency);
+int pid_GetIQFrequency(rp_channel_t channel, float *frequency);
+int pid_SetIQPhase(rp_channel_t channel, float phase);
+int pid_GetIQPhase(rp_channel_t channel, float *phase);
+int pid_SetIQBandwidth(rp_channel_t channel, float bandwidth);
+int pid_GetIQBandwidth(rp_channel_t channel, float *bandwidth);
+int pid_SetIQGain(rp_channel_t channel, float gain);
+int pid_GetIQGain(rp_channel_t channel, float *gain);
+int pid_SetIQReference(rp_channel_t channel, rp_iq_ref_t reference);
+int pid_GetIQReference(rp_channel_t channel, rp_iq_ref_t *reference);
+int pid_GetImage(pid_control_t *image);
+int pid_ApplyImage(const pid_control_t *image);
 
 #endif //__PID_H
@@ -0,0 +1,187 @@
+/**
+ * @brief Red Pitaya library preset implementation
+ *
+ * The file of a preset is the source of truth: a preset in memory is only
+ * applied while its file is unchanged, so that presets stored or deleted by
+ * another process are noticed. Files are replaced atomically by writing a
+ * temporary file and renaming it.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "redpitaya/lockbox.h"
+#include "common.h"
+#include "pid.h"
+#include "limit.h"
+#include "preset.h"
+
+// Contents of a preset file
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    pid_control_t pid;
+    limit_control_t limit;
+} preset_image_t;
+
+typedef struct {
+    char name[PRESET_NAME_LEN];     // Empty if the slot is unused
+    ino_t inode;                    // Identify the file the image was read from
+    struct timespec mtime;
+    preset_image_t image;
+} preset_t;
+
+static preset_t presets[PRESET_MAX];
+static int next_replaced = 0;
+
+
+/* Checks the name and returns the path of the preset file */
+static int presetPath(const char *name, char *path, size_t size)
+{
+    size_t len = name ? strlen(name) : 0;
+    if (len == 0 || len >= PRESET_NAME_LEN) {
+        return RP_EIPV;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                || c == '-' || c == '_')) {
+            return RP_EIPV;
+        }
+    }
+    snprintf(path, size, "%s/%s%s", PRESET_DIR_PATH, name, PRESET_FILE_EXT);
+    return RP_OK;
+}
+
+static preset_t *findPreset(const char *name)
+{
+    for (int i = 0; i < PRESET_MAX; i++) {
+        if (strcmp(presets[i].name, name) == 0) {
+            return &presets[i];
+        }
+    }
+    return NULL;
+}
+
+/* Returns the slot of a preset, a free slot or the slot to be replaced */
+static preset_t *slotFor(const char *name)
+{
+    preset_t *preset = findPreset(name);
+    if (preset == NULL) {
+        preset = findPreset("");
+    }
+    if (preset == NULL) {
+        preset = &presets[next_replaced];
+        next_replaced = (next_replaced + 1) % PRESET_MAX;
+    }
+    return preset;
+}
+
+static void remember(preset_t *preset, const char *name, const struct stat *st,
+                     const preset_image_t *image)
+{
+    strcpy(preset->name, name);
+    preset->inode = st->st_ino;
+    preset->mtime = st->st_mtim;
+    preset->image = *image;
+}
+
+int preset_Store(const char *name)
+{
+    char path[sizeof(PRESET_DIR_PATH) + PRESET_NAME_LEN + sizeof(PRESET_FILE_EXT) + 1];
+    char tmp_path[sizeof(path) + 4];
+    preset_image_t image = { .magic = PRESET_MAGIC, .version = PRESET_VERSION };
+    struct stat st;
+
+    int result = presetPath(name, path, sizeof(path));
+    if (result != RP_OK) {
+        return result;
+    }
+    ECHECK(pid_GetImage(&image.pid));
+    ECHECK(limit_GetImage(&image.limit));
+
+    if (mkdir(PRESET_DIR_PATH, 0755) != 0 && errno != EEXIST) {
+        return RP_EOCF;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "w");
+    if (file == NULL) {
+        return RP_EOCF;
+    }
+    size_t written = fwrite(&image, sizeof(image), 1, file);
+    if (fclose(file) != 0 || written != 1 || rename(tmp_path, path) != 0
+            || stat(path, &st) != 0) {
+        unlink(tmp_path);
+        return RP_EOCF;
+    }
+
+    remember(slotFor(name), name, &st, &image);
+    return RP_OK;
+}
+
+int preset_Apply(const char *name)
+{
+    char path[sizeof(PRESET_DIR_PATH) + PRESET_NAME_LEN + sizeof(PRESET_FILE_EXT) + 1];
+    struct stat st;
+
+    int result = presetPath(name, path, sizeof(path));
+    if (result != RP_OK) {
+        return result;
+    }
+
+    preset_t *preset = findPreset(name);
+    if (stat(path, &st) != 0) {
+        if (preset) {
+            preset->name[0] = '\0';
+        }
+        return RP_EPNF;
+    }
+
+    if (preset == NULL || preset->inode != st.st_ino
+            || preset->mtime.tv_sec != st.st_mtim.tv_sec
+            || preset->mtime.tv_nsec != st.st_mtim.tv_nsec) {
+        // Not in memory, or changed by another process
+        preset_image_t image;
+        FILE *file = fopen(path, "r");
+        if (file == NULL) {
+            return RP_EOCF;
+        }
+        size_t read = fread(&image, sizeof(image), 1, file);
+        fclose(file);
+        if (read != 1 || image.magic != PRESET_MAGIC || image.version != PRESET_VERSION) {
+            return RP_EICV;
+        }
+        preset = slotFor(name);
+        remember(preset, name, &st, &image);
+    }
+
+    ECHECK(limit_ApplyImage(&preset->image.limit));
+    return pid_ApplyImage(&preset->image.pid);
+}
+
+int preset_Delete(const char *name)
+{
+    char path[sizeof(PRESET_DIR_PATH) + PRESET_NAME_LEN + sizeof(PRESET_FILE_EXT) + 1];
+
+    int result = presetPath(name, path, sizeof(path));
+    if (result != RP_OK) {
+        return result;
+    }
+
+    preset_t *preset = findPreset(name);
+    if (preset) {
+        preset->name[0] = '\0';
+    }
+    if (unlink(path) != 0) {
+        return errno == ENOENT ? RP_EPNF : RP_EOCF;
+    }
+    return RP_OK;
+}
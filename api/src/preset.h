@@ -0,0 +1,25 @@
+/**
+ * @brief Red Pitaya library preset interface
+ *
+ * A preset is an image of the PID and output limit registers. Presets are
+ * kept in memory and in PRESET_DIR_PATH, so that they survive a restart and
+ * are shared by all processes using the library.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __PRESET_H
+#define __PRESET_H
+
+#define PRESET_MAX          16          // Presets kept in memory
+#define PRESET_MAGIC        0x4C425053  // "SPBL"
+#define PRESET_VERSION      2
+#define PRESET_FILE_EXT     ".preset"
+
+int preset_Store(const char *name);
+int preset_Apply(const char *name);
+int preset_Delete(const char *name);
+
+#endif //__PRESET_H
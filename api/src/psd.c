@@ -0,0 +1,253 @@
+/**
+ * @brief Red Pitaya library noise spectral density implementation
+ *
+ * Each acquisition is a full scope buffer of fresh samples (see
+ * acq_AcquireBuffer), so consecutive spectra never reuse data. Segments of
+ * the buffer are detrended (mean removed), multiplied by a periodic Hann
+ * window and transformed; their squared magnitudes are summed until the
+ * requested number of averages is reached. The spectrum is then published as a
+ * one-sided amplitude spectral density in V/sqrt(Hz) and the next average
+ * starts.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "redpitaya/lockbox.h"
+#include "common.h"
+#include "acq_handler.h"
+#include "kiss_fftr.h"
+#include "psd.h"
+
+static pthread_t psd_thread;
+static bool psd_started = false;
+static volatile bool psd_running = false;
+
+// Settings of the running worker
+static rp_channel_t psd_channel;
+static uint32_t psd_length;
+static uint32_t psd_step;
+static uint32_t psd_averages;
+
+// Buffers of the worker
+static float psd_signal[ADC_BUFFER_SIZE];
+static float *psd_window = NULL;
+static float *psd_segment = NULL;
+static double *psd_sum = NULL;
+static kiss_fft_cpx *psd_fft = NULL;
+static kiss_fftr_cfg psd_cfg = NULL;
+static double psd_window_power;
+
+// Last averaged spectrum
+static pthread_mutex_t psd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static float psd_result[PSD_MAX_BINS];
+static uint32_t psd_bins = 0;
+static float psd_bin_width = 0;
+static uint32_t psd_count = 0;
+
+
+static void freeBuffers()
+{
+    free(psd_window);
+    free(psd_segment);
+    free(psd_sum);
+    free(psd_fft);
+    free(psd_cfg);
+    psd_window = psd_segment = NULL;
+    psd_sum = NULL;
+    psd_fft = NULL;
+    psd_cfg = NULL;
+}
+
+static int allocBuffers(uint32_t length)
+{
+    psd_window = malloc(length * sizeof(float));
+    psd_segment = malloc(length * sizeof(float));
+    psd_sum = calloc(length / 2 + 1, sizeof(double));
+    psd_fft = malloc((length / 2 + 1) * sizeof(kiss_fft_cpx));
+    psd_cfg = kiss_fftr_alloc(length, 0, NULL, NULL);
+    if (!psd_window || !psd_segment || !psd_sum || !psd_fft || !psd_cfg) {
+        freeBuffers();
+        return RP_EOOR;
+    }
+
+    psd_window_power = 0;
+    for (uint32_t i = 0; i < length; i++) {
+        psd_window[i] = 0.5 * (1 - cos(2 * M_PI * i / length));
+        psd_window_power += (double)psd_window[i] * psd_window[i];
+    }
+    return RP_OK;
+}
+
+static int acquire(float *sampling_rate, bool *done)
+{
+    uint32_t size = ADC_BUFFER_SIZE;
+
+    ECHECK(acq_GetSamplingRateHz(sampling_rate));
+    ECHECK(acq_AcquireBuffer(&psd_running, done));
+    if (!*done) {
+        return RP_OK;
+    }
+    return acq_GetOldestDataV(psd_channel, &size, psd_signal);
+}
+
+static void accumulate(const float *data)
+{
+    const uint32_t length = psd_length;
+    float mean = 0;
+
+    for (uint32_t i = 0; i < length; i++) {
+        mean += data[i];
+    }
+    mean /= length;
+    for (uint32_t i = 0; i < length; i++) {
+        psd_segment[i] = (data[i] - mean) * psd_window[i];
+    }
+
+    kiss_fftr(psd_cfg, psd_segment, psd_fft);
+
+    for (uint32_t k = 0; k <= length / 2; k++) {
+        psd_sum[k] += (double)psd_fft[k].r * psd_fft[k].r + (double)psd_fft[k].i * psd_fft[k].i;
+    }
+}
+
+static void publish(float sampling_rate)
+{
+    const uint32_t bins = psd_length / 2 + 1;
+    const double scale = 1.0 / (sampling_rate * psd_window_power * psd_averages);
+
+    pthread_mutex_lock(&psd_mutex);
+    for (uint32_t k = 0; k < bins; k++) {
+        // One-sided: all bins except DC and Nyquist contain the power of both signs
+        double density = psd_sum[k] * scale * ((k == 0 || k == bins - 1) ? 1 : 2);
+        psd_result[k] = sqrt(density);
+    }
+    psd_bins = bins;
+    psd_bin_width = sampling_rate / psd_length;
+    psd_count++;
+    pthread_mutex_unlock(&psd_mutex);
+
+    memset(psd_sum, 0, bins * sizeof(double));
+}
+
+static void *psdThread(void *arg)
+{
+    float sampling_rate = 0;
+    uint32_t segments = 0;
+
+    while (psd_running) {
+        float rate;
+        bool done;
+        int result = acquire(&rate, &done);
+        if (result != RP_OK) {
+            fprintf(stderr, "Noise spectral density stopped: %s\n", rp_GetError(result));
+            break;
+        }
+        if (!done) {
+            break;
+        }
+        if (rate != sampling_rate) {
+            // Decimation was changed; discard the partial average
+            sampling_rate = rate;
+            segments = 0;
+            memset(psd_sum, 0, (psd_length / 2 + 1) * sizeof(double));
+        }
+
+        for (uint32_t start = 0; start + psd_length <= ADC_BUFFER_SIZE; start += psd_step) {
+            accumulate(&psd_signal[start]);
+            if (++segments == psd_averages) {
+                publish(sampling_rate);
+                segments = 0;
+            }
+        }
+    }
+    psd_running = false;
+    return NULL;
+}
+
+int psd_Start(rp_channel_t channel, uint32_t segment_length, float overlap, uint32_t averages)
+{
+    if (channel != RP_CH_1 && channel != RP_CH_2) {
+        return RP_EPN;
+    }
+    if (segment_length < PSD_MIN_SEGMENT || segment_length > ADC_BUFFER_SIZE
+            || (segment_length & (segment_length - 1)) != 0
+            || !(overlap >= 0 && overlap < 1) || averages == 0) {
+        return RP_EOOR;
+    }
+
+    psd_Stop();
+    ECHECK(allocBuffers(segment_length));
+
+    psd_channel = channel;
+    psd_length = segment_length;
+    psd_step = segment_length - (uint32_t)lroundf(overlap * segment_length);
+    if (psd_step == 0) {
+        psd_step = 1;
+    }
+    psd_averages = averages;
+
+    pthread_mutex_lock(&psd_mutex);
+    psd_bins = 0;
+    psd_count = 0;
+    pthread_mutex_unlock(&psd_mutex);
+
+    psd_running = true;
+    if (pthread_create(&psd_thread, NULL, psdThread, NULL) != 0) {
+        psd_running = false;
+        freeBuffers();
+        return RP_EUF;
+    }
+    psd_started = true;
+    return RP_OK;
+}
+
+int psd_Stop()
+{
+    if (!psd_started) {
+        return RP_OK;
+    }
+    psd_running = false;
+    pthread_join(psd_thread, NULL);
+    psd_started = false;
+    freeBuffers();
+    return acq_Stop();
+}
+
+int psd_IsRunning(bool *running)
+{
+    *running = psd_running;
+    return RP_OK;
+}
+
+int psd_GetSpectrum(float *buffer, uint32_t *size, float *bin_width, uint32_t *count)
+{
+    int result = RP_OK;
+
+    pthread_mutex_lock(&psd_mutex);
+    if (psd_bins == 0) {
+        result = RP_ENDA;
+    }
+    else if (*size < psd_bins) {
+        result = RP_BTS;
+    }
+    else {
+        memcpy(buffer, psd_result, psd_bins * sizeof(float));
+        *size = psd_bins;
+        if (bin_width) {
+            *bin_width = psd_bin_width;
+        }
+        if (count) {
+            *count = psd_count;
+        }
+    }
+    pthread_mutex_unlock(&psd_mutex);
+    return result;
+}
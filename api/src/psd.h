@@ -0,0 +1,28 @@
+/**
+ * @brief Red Pitaya library noise spectral density interface
+ *
+ * A worker thread takes acquisitions of one input channel with the scope and
+ * averages the spectra of their segments (Welch's method). Only the averaged
+ * spectrum is kept, so that clients do not have to fetch the samples.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __PSD_H
+#define __PSD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "redpitaya/lockbox.h"
+
+#define PSD_MIN_SEGMENT     64          // Shortest segment in samples
+
+int psd_Start(rp_channel_t channel, uint32_t segment_length, float overlap, uint32_t averages);
+int psd_Stop();
+int psd_IsRunning(bool *running);
+int psd_GetSpectrum(float *buffer, uint32_t *size, float *bin_width, uint32_t *count);
+
+#endif //__PSD_H
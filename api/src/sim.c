@@ -0,0 +1,433 @@
+/**
+ * @brief Red Pitaya library register-map simulator implementation
+ *
+ * The simulator backs every cmn_Map() call with a block of an anonymous (or
+ * POSIX shared memory) region instead of /dev/uio/api. Plain registers simply
+ * keep the last written value. A model thread additionally emulates the parts
+ * of the FPGA the acquisition path depends on:
+ *  - the scope write state machine (arm, reset, trigger, trigger delay,
+ *    write pointers and pre-trigger counter),
+ *  - the 16k sample buffers of both scope channels, which are filled with the
+ *    signal generator output (digital loopback ASG A -> ADC A, ASG B -> ADC B),
+ *  - the AXI writers streaming the same samples into a simulated DDR window.
+ *  - the acquisition done interrupt, delivered to threads of the process that
+ *    runs the model (see sim_WaitIrq).
+ *
+ * When LOCKBOX_SIM_SHM names a shared memory object, the first process to
+ * create it runs the model; later processes only attach to the register map.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+
+#include "common.h"
+#include "oscilloscope.h"
+#include "generate.h"
+#include "sim.h"
+
+#define SIM_REG_SIZE        (SIM_BLOCK_COUNT * SIM_BLOCK_SIZE)
+#define SIM_MEM_SIZE        (SIM_REG_SIZE + SIM_DDR_SIZE)
+#define SIM_SAMPLE_MASK     0x3FFF
+
+// Upper bound of samples modelled per tick; at the highest sampling rates the
+// simulated time therefore runs slower than wall-clock time.
+#define SIM_MAX_SAMPLES     (2 * ADC_BUFFER_SIZE)
+
+static uint8_t *sim_mem = NULL;
+static int sim_fd = -1;
+static const char *sim_shm_name = NULL;
+
+static bool sim_owner = false;
+static pid_t sim_pid = 0;
+static pthread_t sim_thread;
+static volatile bool sim_running = false;
+
+// Scope write state machine
+static bool adc_we = false;
+static bool adc_dly_do = false;
+static uint32_t adc_wp = 0;
+static uint32_t adc_wp_cur = 0;
+static uint32_t adc_wp_trig = 0;
+static uint32_t adc_we_cnt = 0;
+static uint32_t adc_dly_cnt = 0;
+static uint64_t adc_clk_rem = 0;
+static int32_t adc_last[2] = {0, 0};
+
+// Acquisition done interrupt
+static pthread_mutex_t irq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t irq_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t irq_count = 0;
+static __thread uint32_t irq_armed = 0;
+
+// AXI (DDR) writers
+static bool axi_we[2] = {false, false};
+static bool axi_dly_do[2] = {false, false};
+static uint32_t axi_dly_cnt[2] = {0, 0};
+static uint32_t axi_cur[2] = {0, 0};
+static uint32_t axi_trig[2] = {0, 0};
+
+// Signal generator read pointers (16.16 fixed point, as in the FPGA)
+static uint64_t asg_cnt[2] = {0, 0};
+
+static inline void *sim_Block(size_t offset)
+{
+    return sim_mem + (offset >> 20) * SIM_BLOCK_SIZE;
+}
+
+static inline int32_t sim_SignExtend14(uint32_t value)
+{
+    value &= SIM_SAMPLE_MASK;
+    return (value & 0x2000) ? (int32_t) value - 0x4000 : (int32_t) value;
+}
+
+static int32_t sim_AsgSample(rp_channel_t channel, uint32_t dec)
+{
+    volatile generate_control_t *gen = sim_Block(GENERATE_BASE_ADDR);
+    volatile ch_properties_t *props = (channel == RP_CH_1) ? &gen->properties_chA : &gen->properties_chB;
+    volatile uint32_t *data = (volatile uint32_t *) ((uint8_t *) gen +
+            ((channel == RP_CH_1) ? CHA_DATA_OFFSET : CHB_DATA_OFFSET));
+    bool disabled = (channel == RP_CH_1) ? gen->AsetOutputTo0 : gen->BsetOutputTo0;
+
+    uint64_t wrap = (uint64_t) props->counterWrap + 1;
+    asg_cnt[channel] = (asg_cnt[channel] + (uint64_t) props->counterStep * dec) % wrap;
+    if (disabled) {
+        return 0;
+    }
+
+    int32_t value = sim_SignExtend14(data[(asg_cnt[channel] >> 16) % BUFFER_LENGTH]);
+    value = ((value * (int32_t) props->amplitudeScale) >> 13) + sim_SignExtend14(props->amplitudeOffset);
+    return MAX(-(1 << 13), MIN(value, (1 << 13) - 1));
+}
+
+static bool sim_Trigger(uint32_t source, const int32_t *sample, volatile osc_control_t *osc)
+{
+    int32_t thr_a = sim_SignExtend14(osc->cha_thr);
+    int32_t thr_b = sim_SignExtend14(osc->chb_thr);
+
+    switch (source) {
+        case RP_TRIG_SRC_DISABLED:
+            return false;
+        case RP_TRIG_SRC_CHA_PE:
+            return adc_last[RP_CH_1] < thr_a && sample[RP_CH_1] >= thr_a;
+        case RP_TRIG_SRC_CHA_NE:
+            return adc_last[RP_CH_1] > thr_a && sample[RP_CH_1] <= thr_a;
+        case RP_TRIG_SRC_CHB_PE:
+            return adc_last[RP_CH_2] < thr_b && sample[RP_CH_2] >= thr_b;
+        case RP_TRIG_SRC_CHB_NE:
+            return adc_last[RP_CH_2] > thr_b && sample[RP_CH_2] <= thr_b;
+        default:
+            // Software trigger; external and ASG edges are not modelled and fire immediately
+            return true;
+    }
+}
+
+/**
+ * Advances the model by the given number of ADC clock cycles.
+ */
+static void sim_Step(uint64_t clocks)
+{
+    volatile osc_control_t *osc = sim_Block(OSC_BASE_ADDR);
+    volatile uint32_t *buf_a = (volatile uint32_t *) ((uint8_t *) osc + OSC_CHA_OFFSET);
+    volatile uint32_t *buf_b = (volatile uint32_t *) ((uint8_t *) osc + OSC_CHB_OFFSET);
+
+    volatile uint32_t *axi_start[2] = { &osc->cha_axi_start, &osc->chb_axi_start };
+    volatile uint32_t *axi_stop[2] = { &osc->cha_axi_stop, &osc->chb_axi_stop };
+    volatile uint32_t *axi_dly[2] = { &osc->cha_axi_dly, &osc->chb_axi_dly };
+    bool axi_en[2] = { osc->cha_axi_en & 0x1, osc->chb_axi_en & 0x1 };
+    int16_t *ddr = (int16_t *) (sim_mem + SIM_REG_SIZE);
+
+    // Reset and arm are write strobes on hardware; here they are taken from the
+    // register contents (reset bit is self-clearing, arm is a 0 -> 1 transition).
+    uint32_t conf = __sync_fetch_and_and(&osc->conf, ~0x2u);
+    bool irq = false;
+    if (conf & 0x2) {
+        adc_we = adc_dly_do = false;
+        adc_wp = adc_wp_cur = adc_wp_trig = adc_we_cnt = 0;
+        osc->trig_source = 0;
+        for (int ch = 0; ch < 2; ch++) {
+            axi_we[ch] = axi_dly_do[ch] = false;
+            axi_cur[ch] = *axi_start[ch];
+            axi_trig[ch] = 0;
+        }
+    }
+    else if ((conf & 0x1) && !adc_we) {
+        adc_we = true;
+        adc_dly_do = false;
+        adc_we_cnt = 0;
+        for (int ch = 0; ch < 2; ch++) {
+            axi_we[ch] = axi_en[ch];
+            axi_dly_do[ch] = false;
+        }
+    }
+
+    uint32_t dec = osc->data_dec & DATA_DEC_MASK;
+    if (dec == 0) {
+        dec = 1;
+    }
+    clocks += adc_clk_rem;
+    uint64_t samples = clocks / dec;
+    adc_clk_rem = clocks % dec;
+    if (samples > SIM_MAX_SAMPLES) {
+        samples = SIM_MAX_SAMPLES;
+    }
+
+    for (uint64_t i = 0; i < samples; i++) {
+        int32_t sample[2] = { sim_AsgSample(RP_CH_1, dec), sim_AsgSample(RP_CH_2, dec) };
+        uint32_t source = osc->trig_source & TRIG_SRC_MASK;
+        bool trig = adc_we && !adc_dly_do && sim_Trigger(source, sample, osc);
+
+        for (int ch = 0; ch < 2; ch++) {
+            if (!axi_we[ch]) {
+                continue;
+            }
+            uint32_t start = *axi_start[ch], stop = *axi_stop[ch];
+            if ((axi_cur[ch] < start) || (axi_cur[ch] >= stop + 8)) {
+                axi_cur[ch] = start;
+            }
+            if ((axi_cur[ch] >= SIM_DDR_BASE) && (axi_cur[ch] + 2 <= SIM_DDR_BASE + SIM_DDR_SIZE)) {
+                ddr[(axi_cur[ch] - SIM_DDR_BASE) / 2] = (int16_t) sample[ch];
+            }
+            if (trig && !axi_dly_do[ch]) {
+                axi_dly_do[ch] = true;
+                axi_dly_cnt[ch] = *axi_dly[ch];
+                axi_trig[ch] = axi_cur[ch];
+            }
+            axi_cur[ch] += 2;
+            if (axi_dly_do[ch]) {
+                if (axi_dly_cnt[ch] == 0) {
+                    axi_we[ch] = axi_dly_do[ch] = false;
+                }
+                else {
+                    axi_dly_cnt[ch]--;
+                }
+            }
+        }
+
+        if (adc_we) {
+            buf_a[adc_wp] = (uint32_t) sample[RP_CH_1] & SIM_SAMPLE_MASK;
+            buf_b[adc_wp] = (uint32_t) sample[RP_CH_2] & SIM_SAMPLE_MASK;
+            adc_wp_cur = adc_wp;
+            adc_wp = (adc_wp + 1) % ADC_BUFFER_SIZE;
+
+            if (!adc_dly_do) {
+                if (adc_we_cnt != UINT32_MAX) {
+                    adc_we_cnt++;
+                }
+                if (trig) {
+                    adc_dly_do = true;
+                    adc_dly_cnt = osc->trigger_delay;
+                    adc_wp_trig = adc_wp_cur;
+                }
+            }
+            else if (adc_dly_cnt > 0) {
+                adc_dly_cnt--;
+            }
+
+            if (adc_dly_do && adc_dly_cnt == 0) {
+                adc_dly_do = false;
+                if (__sync_bool_compare_and_swap(&osc->trig_source, source, 0) && source) {
+                    irq = true;
+                }
+                if (!(conf & 0x8)) {
+                    adc_we = false;
+                }
+            }
+        }
+
+        adc_last[RP_CH_1] = sample[RP_CH_1];
+        adc_last[RP_CH_2] = sample[RP_CH_2];
+    }
+
+    osc->wr_ptr_cur = adc_wp_cur;
+    osc->wr_ptr_trigger = adc_wp_trig;
+    osc->pre_trigger_counter = adc_we_cnt;
+    // The AXI writers publish their position in whole 64-bit words
+    osc->cha_axi_cur = axi_cur[RP_CH_1] & ~0x7u;
+    osc->chb_axi_cur = axi_cur[RP_CH_2] & ~0x7u;
+    osc->cha_axi_trig = axi_trig[RP_CH_1];
+    osc->chb_axi_trig = axi_trig[RP_CH_2];
+
+    // Publish arm/trigger status without losing an arm issued during this step
+    uint32_t old, new;
+    do {
+        old = osc->conf;
+        bool armed = adc_we || ((old & 0x1) && !(conf & 0x1));
+        new = (old & ~0x5u) | (adc_dly_do ? 0x4 : 0) | (armed ? 0x1 : 0);
+    } while (!__sync_bool_compare_and_swap(&osc->conf, old, new));
+
+    if (irq) {
+        pthread_mutex_lock(&irq_lock);
+        irq_count++;
+        pthread_cond_broadcast(&irq_cond);
+        pthread_mutex_unlock(&irq_lock);
+    }
+}
+
+static void *sim_Run(void *arg)
+{
+    struct timespec last, now;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+
+    while (sim_running) {
+        usleep(SIM_TICK_US);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t ns = (int64_t) (now.tv_sec - last.tv_sec) * 1000000000LL + (now.tv_nsec - last.tv_nsec);
+        last = now;
+        sim_Step((uint64_t) ns / SIM_CLOCK_PERIOD_NS);
+    }
+    return NULL;
+}
+
+int sim_Init()
+{
+    if (sim_mem) {
+        return RP_OK;
+    }
+    sim_pid = getpid();
+
+    sim_shm_name = getenv(SIM_SHM_ENV);
+    if (sim_shm_name && *sim_shm_name) {
+        sim_fd = shm_open(sim_shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (sim_fd >= 0) {
+            sim_owner = true;
+            if (ftruncate(sim_fd, SIM_MEM_SIZE) < 0) {
+                close(sim_fd);
+                shm_unlink(sim_shm_name);
+                sim_fd = -1;
+                return RP_EOMD;
+            }
+        }
+        else if (errno == EEXIST) {
+            sim_fd = shm_open(sim_shm_name, O_RDWR, 0600);
+            sim_owner = false;
+        }
+        if (sim_fd < 0) {
+            return RP_EOMD;
+        }
+        sim_mem = mmap(NULL, SIM_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, sim_fd, 0);
+    }
+    else {
+        sim_shm_name = NULL;
+        sim_owner = true;
+        sim_mem = mmap(NULL, SIM_MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+
+    if (sim_mem == MAP_FAILED) {
+        sim_mem = NULL;
+        sim_Release();
+        return RP_EMMD;
+    }
+
+    if (sim_owner) {
+        sim_running = true;
+        if (pthread_create(&sim_thread, NULL, sim_Run, NULL) != 0) {
+            sim_running = false;
+            sim_Release();
+            return RP_EMMD;
+        }
+    }
+    return RP_OK;
+}
+
+int sim_Release()
+{
+    // The model thread only exists in the process that started it (not in forked children)
+    if (sim_running && sim_pid == getpid()) {
+        sim_running = false;
+        pthread_join(sim_thread, NULL);
+    }
+
+    if (sim_mem) {
+        if (munmap(sim_mem, SIM_MEM_SIZE) < 0) {
+            return RP_EUMD;
+        }
+        sim_mem = NULL;
+    }
+
+    if (sim_fd >= 0) {
+        close(sim_fd);
+        sim_fd = -1;
+        if (sim_owner && sim_pid == getpid()) {
+            shm_unlink(sim_shm_name);
+        }
+    }
+    return RP_OK;
+}
+
+int sim_Map(size_t size, size_t offset, void** mapped)
+{
+    if (!sim_mem || (offset >> 20) >= SIM_BLOCK_COUNT || size > SIM_BLOCK_SIZE) {
+        return RP_EMMD;
+    }
+    *mapped = sim_Block(offset);
+    return RP_OK;
+}
+
+int sim_MapDDR(size_t size, size_t address, void** mapped)
+{
+    if (!sim_mem || (address < SIM_DDR_BASE) || (address + size > SIM_DDR_BASE + SIM_DDR_SIZE)) {
+        return RP_EMMD;
+    }
+    *mapped = sim_mem + SIM_REG_SIZE + (address - SIM_DDR_BASE);
+    return RP_OK;
+}
+
+int sim_Unmap(size_t size, void** mapped)
+{
+    if ((mapped == NULL) || (*mapped == NULL)) {
+        return RP_EUMD;
+    }
+    *mapped = NULL;
+    return RP_OK;
+}
+
+int sim_ArmIrq()
+{
+    pthread_mutex_lock(&irq_lock);
+    irq_armed = irq_count;
+    pthread_mutex_unlock(&irq_lock);
+    return RP_OK;
+}
+
+/**
+ * Waits for an acquisition done event of the model after the last sim_ArmIrq()
+ * of the calling thread. Processes attached to the shared memory of another
+ * process do not see its events and only sleep for one model tick.
+ */
+int sim_WaitIrq(uint32_t timeout_ms)
+{
+    if (!sim_running || sim_pid != getpid()) {
+        usleep(MIN(timeout_ms * 1000ULL, SIM_TICK_US));
+        return RP_OK;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&irq_lock);
+    while (irq_count == irq_armed) {
+        if (pthread_cond_timedwait(&irq_cond, &irq_lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&irq_lock);
+    return RP_OK;
+}
@@ -0,0 +1,49 @@
+/**
+ * @brief Red Pitaya library register-map simulator interface
+ *
+ * Software stand-in for the FPGA register space normally mapped from
+ * /dev/uio/api. Used when the library is initialized with RP_BACKEND_SIM.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Every FPGA block is addressed in 1 MB steps (offset >> 20); the simulator
+// reserves SIM_BLOCK_SIZE bytes for each block index below SIM_BLOCK_COUNT.
+#define SIM_BLOCK_COUNT     8
+#define SIM_BLOCK_SIZE      0x40000
+
+// Block offset used for the output limiter (0x40600000 on hardware)
+#define SIM_LIMIT_OFFSET    0x00600000
+
+// Physical DDR window available to the simulated AXI (scope -> DDR) writers
+#define SIM_DDR_BASE        0x01000000
+#define SIM_DDR_SIZE        0x01000000
+
+// ADC clock period in ns, used to advance the simulated write pointer
+#define SIM_CLOCK_PERIOD_NS 8
+// Model update interval in us
+#define SIM_TICK_US         1000
+
+// Environment variables
+#define SIM_BACKEND_ENV     "LOCKBOX_BACKEND"   // "sim" selects the simulator in rp_Init()
+#define SIM_SHM_ENV         "LOCKBOX_SIM_SHM"   // optional POSIX shm name, e.g. "/lockbox-sim"
+
+int sim_Init();
+int sim_Release();
+
+int sim_Map(size_t size, size_t offset, void** mapped);
+int sim_Unmap(size_t size, void** mapped);
+int sim_MapDDR(size_t size, size_t address, void** mapped);
+
+int sim_ArmIrq();
+int sim_WaitIrq(uint32_t timeout_ms);
+
+#endif //__SIM_H
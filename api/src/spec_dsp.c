@@ -23,7 +23,7 @@
 #include "spec_dsp.h"
 //#include "spectrometerApp.h"
 #include "spec_fpga.h"
-#include "kiss_fftr.h"
+#include "kiss_fft.h"
 
 extern float g_spectr_fpga_adc_max_v;
 extern const int c_spectr_fpga_adc_bits;
@@ -31,10 +31,12 @@ extern const int c_spectr_fpga_adc_bits;
 /* length of output signals: floor(SPECTR_FPGA_SIG_LEN/2) */
 
 /* Internal structures used in DSP  */
-double                *rp_hann_window   = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out1 = NULL;
-kiss_fft_cpx         *rp_kiss_fft_out2 = NULL;
-kiss_fftr_cfg         rp_kiss_fft_cfg  = NULL;
+float                *rp_hann_window   = NULL;
+/* Both channels are transformed at once: ChA is the real and ChB the
+ * imaginary part of the input */
+kiss_fft_cpx         *rp_kiss_fft_in   = NULL;
+kiss_fft_cpx         *rp_kiss_fft_out  = NULL;
+kiss_fft_cfg          rp_kiss_fft_cfg  = NULL;
 
 /* constants - calibration dependant */
 /* Power calc. impedance*/
@@ -87,9 +89,11 @@ int rp_spectr_hann_init()
 {
     int i;
 
-    rp_spectr_hann_clean(rp_hann_window);
+    /* The window is kept until rp_spectr_hann_clean() */
+    if(rp_hann_window)
+        return 0;
 
-    rp_hann_window = (double *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(double));
+    rp_hann_window = (float *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(float));
     if(rp_hann_window == NULL) {
         fprintf(stderr, "rp_spectr_hann_create() can not allocate mem");
         return -1;
@@ -113,18 +117,23 @@ int rp_spectr_hann_clean()
 }
 
 
-int rp_spectr_hann_filter(double *cha_in, double *chb_in,
-                          double **cha_out, double **chb_out)
+int rp_spectr_hann_filter(float *cha_in, float *chb_in,
+                          float **cha_out, float **chb_out)
 {
     int i;
-    double *cha_o = *cha_out;
-    double *chb_o = *chb_out;
+    float *restrict cha_o = *cha_out;
+    float *restrict chb_o = *chb_out;
+    const float *restrict window;
 
     if(!cha_in || !chb_in || !*cha_out || !*chb_out)
         return -1;
+    if(rp_spectr_hann_init() < 0)
+        return -1;
+
+    window = rp_hann_window;
     for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
-        cha_o[i] = cha_in[i] * rp_hann_window[i];
-        chb_o[i] = chb_in[i] * rp_hann_window[i];
+        cha_o[i] = cha_in[i] * window[i];
+        chb_o[i] = chb_in[i] * window[i];
     }
 
     return 0;
@@ -132,30 +141,36 @@ int rp_spectr_hann_filter(double *cha_in, double *chb_in,
 
 int rp_spectr_fft_init()
 {
-    if(rp_kiss_fft_out1 || rp_kiss_fft_out2 || rp_kiss_fft_cfg) {
-        rp_spectr_fft_clean();
-    }
+    /* The plan and buffers are kept until rp_spectr_fft_clean() */
+    if(rp_kiss_fft_in && rp_kiss_fft_out && rp_kiss_fft_cfg)
+        return 0;
+    rp_spectr_fft_clean();
 
-    rp_kiss_fft_out1 = 
+    rp_kiss_fft_in =
         (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
-    rp_kiss_fft_out2 =
+    rp_kiss_fft_out =
         (kiss_fft_cpx *)malloc(SPECTR_FPGA_SIG_LEN * sizeof(kiss_fft_cpx));
 
-    rp_kiss_fft_cfg = kiss_fftr_alloc(SPECTR_FPGA_SIG_LEN, 0, NULL, NULL);
+    rp_kiss_fft_cfg = kiss_fft_alloc(SPECTR_FPGA_SIG_LEN, 0, NULL, NULL);
 
+    if(!rp_kiss_fft_in || !rp_kiss_fft_out || !rp_kiss_fft_cfg) {
+        fprintf(stderr, "rp_spectr_fft_init() can not allocate mem");
+        rp_spectr_fft_clean();
+        return -1;
+    }
     return 0;
 }
 
 int rp_spectr_fft_clean()
 {
     kiss_fft_cleanup();
-    if(rp_kiss_fft_out1) {
-        free(rp_kiss_fft_out1);
-        rp_kiss_fft_out1 = NULL;
+    if(rp_kiss_fft_in) {
+        free(rp_kiss_fft_in);
+        rp_kiss_fft_in = NULL;
     }
-    if(rp_kiss_fft_out2) {
-        free(rp_kiss_fft_out2);
-        rp_kiss_fft_out2 = NULL;
+    if(rp_kiss_fft_out) {
+        free(rp_kiss_fft_out);
+        rp_kiss_fft_out = NULL;
     }
     if(rp_kiss_fft_cfg) {
         free(rp_kiss_fft_cfg);
@@ -164,33 +179,47 @@ int rp_spectr_fft_clean()
     return 0;
 }
 
-int rp_spectr_fft(double *cha_in, double *chb_in, 
-                  double **cha_out, double **chb_out)
+int rp_spectr_fft(float *cha_in, float *chb_in, 
+                  float **cha_out, float **chb_out)
 {
-    double *cha_o = *cha_out;
-    double *chb_o = *chb_out;
+    float *restrict cha_o = *cha_out;
+    float *restrict chb_o = *chb_out;
+    kiss_fft_cpx *restrict in;
+    const kiss_fft_cpx *restrict z;
     int i;
     if(!cha_in || !chb_in || !*cha_out || !*chb_out)
         return -1;
 
-    if(!rp_kiss_fft_out1 || !rp_kiss_fft_out2 || !rp_kiss_fft_cfg) {
+    if(rp_spectr_fft_init() < 0) {
         fprintf(stderr, "rp_spect_fft not initialized");
         return -1;
     }
 
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)cha_in, rp_kiss_fft_out1);
-    kiss_fftr(rp_kiss_fft_cfg, (kiss_fft_scalar *)chb_in, rp_kiss_fft_out2);
+    in = rp_kiss_fft_in;
+    for(i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
+        in[i].r = cha_in[i];
+        in[i].i = chb_in[i];
+    }
 
-    for(i = 0; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of amplitudes
-        cha_o[i] = sqrt(pow(rp_kiss_fft_out1[i].r, 2) + 
-                        pow(rp_kiss_fft_out1[i].i, 2));
-        chb_o[i] = sqrt(pow(rp_kiss_fft_out2[i].r, 2) + 
-                        pow(rp_kiss_fft_out2[i].i, 2));
+    kiss_fft(rp_kiss_fft_cfg, rp_kiss_fft_in, rp_kiss_fft_out);
+
+    /* Z[k] = A[k] + i B[k] with the spectra A and B of the real signals, so
+     * A[k] = (Z[k] + conj(Z[N-k])) / 2 and B[k] = (Z[k] - conj(Z[N-k])) / 2i */
+    z = rp_kiss_fft_out;
+    cha_o[0] = z[0].r * z[0].r;
+    chb_o[0] = z[0].i * z[0].i;
+    for(i = 1; i < c_dsp_sig_len; i++) {                     // FFT limited to fs/2, specter of powers
+        const kiss_fft_cpx zk = z[i];
+        const kiss_fft_cpx zn = z[SPECTR_FPGA_SIG_LEN - i];
+        float ar = zk.r + zn.r, ai = zk.i - zn.i;
+        float br = zk.i + zn.i, bi = zk.r - zn.r;
+        cha_o[i] = 0.25f * (ar * ar + ai * ai);
+        chb_o[i] = 0.25f * (br * br + bi * bi);
     }
     return 0;
 }
 
-int rp_spectr_decimate(double *cha_in, double *chb_in, 
+int rp_spectr_decimate(float *cha_in, float *chb_in, 
                        float **cha_out, float **chb_out,
                        int in_len, int out_len)
 {
@@ -206,31 +235,29 @@ int rp_spectr_decimate(double *cha_in, double *chb_in,
     if(step < 1)
         step = 1;
 
+    /* Conversion factor from ADC counts to Volts */
+    double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
+    /* Conversion from squared FFT amplitude to power (Watts) */
+    const float c_p = c2v * c2v / c_imp /
+        (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2; // x 2 for unilateral spectral density representation
+                                                                      // c_imp = 50 Ohms, is the transmission line impdeance
+
+    if(out_len * step > in_len) {
+        fprintf(stderr, "rp_spectr_decimate() index too high\n");
+        return -1;
+    }
+
     for(i = 0, j = 0; i < out_len; i++, j+=step) {
-        int k=j;
+        int k;
+        float cha_p = 0;
+        float chb_p = 0;
 
-        if(j >= in_len) {
-            fprintf(stderr, "rp_spectr_decimate() index too high\n");
-            return -1;
-        }
-        cha_o[i] = 0;
-        chb_o[i] = 0;
-	
-	/* Conversion factor from ADC counts to Volts */
-    	double c2v = g_spectr_fpga_adc_max_v/(float)((int)(1<<(c_spectr_fpga_adc_bits-1)));
-	
         for(k=j; k < j+step; k++) {
-	
-	/* Conversion to power (Watts) */  
-        double cha_p = pow(cha_in[k] * c2v, 2) / c_imp /
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2; // x 2 for unilateral spectral density representation
-        double chb_p = pow(chb_in[k] * c2v, 2) / c_imp /                   // c_imp = 50 Ohms, is the transmission line impdeance   
-            (double)SPECTR_FPGA_SIG_LEN / (double)SPECTR_FPGA_SIG_LEN * 2;
-	  
-	  
-            cha_o[i] += (float)cha_p;  // Summing the power expressed in Watts associated to each FFT bin
-            chb_o[i] += (float)chb_p;
+            cha_p += cha_in[k];  // Summing the power associated to each FFT bin
+            chb_p += chb_in[k];
         }
+        cha_o[i] = cha_p * c_p;
+        chb_o[i] = chb_p * c_p;
     }
 
     return 0;
@@ -278,8 +305,8 @@ int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
         /* Conversion to power (Watts) */
     	
 	    
-	double cha_p=cha_in[i];
-        double chb_p=chb_in[i];    
+	float cha_p=cha_in[i];
+        float chb_p=chb_in[i];    
 
 	
 	
@@ -287,13 +314,13 @@ int rp_spectr_cnv_to_dBm(float *cha_in, float *chb_in,
 	// Avoiding -Inf due to log10(0.0) 
 	
 	if (cha_p * c_w2mw > 1.0e-12 )	
-        cha_o[i] = 10 * log10(cha_p * c_w2mw);  // W -> mW -> dBm
+        cha_o[i] = 10 * log10f(cha_p * c_w2mw);  // W -> mW -> dBm
 	else	
 	cha_o[i]=10 * log10(1.0e-12);  
 	
 	
         if (chb_p * c_w2mw > 1.0e-12 )        	
-        chb_o[i] = 10 * log10(chb_p * c_w2mw);
+        chb_o[i] = 10 * log10f(chb_p * c_w2mw);
 	else	
 	 chb_o[i]=10 * log10(1.0e-12);
 	
@@ -32,26 +32,30 @@ int rp_spectr_prepare_freq_vector(float **freq_out, double f_s,
 int rp_spectr_hann_init();
 int rp_spectr_hann_clean();
 
-/* Input & Outputs of SPECTR_FPGA_SIG_LEN */
-int rp_spectr_hann_filter(double *cha_in, double *chb_in,
-                          double **cha_out, double **chb_out);
+/* Input & Outputs of SPECTR_FPGA_SIG_LEN. The window is created on first use
+ * and kept until rp_spectr_hann_clean(). */
+int rp_spectr_hann_filter(float *cha_in, float *chb_in,
+                          float **cha_out, float **chb_out);
 
 int rp_spectr_fft_init();
 int rp_spectr_fft_clean();
 
 /* Inputs length: SPECTR_FPGA_SIG_LEN
  * Outputs length: floor(SPECTR_FPGA_SIG_LEN/2) 
- * Output is not complex number as usually is from the FFT but abs() value of the
- * calculation.
+ * Output is not complex number as usually is from the FFT but the squared
+ * abs() value of the calculation. Both channels are computed with a single
+ * complex FFT, whose plan is created on first use and kept until
+ * rp_spectr_fft_clean().
  */
-int rp_spectr_fft(double *cha_in, double *chb_in, 
-                  double **cha_out, double **chb_out);
+int rp_spectr_fft(float *cha_in, float *chb_in, 
+                  float **cha_out, float **chb_out);
 
 
 /*
- * Decimation (usually from internal 8k -> output 2k)
+ * Decimation (usually from internal 8k -> output 2k), summing the power of
+ * the squared FFT amplitudes from rp_spectr_fft() in Watts
 */
-int rp_spectr_decimate(double *cha_in, double *chb_in,
+int rp_spectr_decimate(float *cha_in, float *chb_in,
                        float **cha_out, float **chb_out,
                        int in_len, int out_len);
 
@@ -201,12 +201,12 @@ int spectr_fpga_get_sig_ptr(int **cha_signal, int **chb_signal)
     return 0;
 }
 
-int spectr_fpga_get_signal(double **cha_signal, double **chb_signal)
+int spectr_fpga_get_signal(float **cha_signal, float **chb_signal)
 {
     int wr_ptr_trig;
     int in_idx, out_idx;
-    double *cha_o = *cha_signal;
-    double *chb_o = *chb_signal;
+    float *cha_o = *cha_signal;
+    float *chb_o = *chb_signal;
 
     if(!cha_o || !chb_o) {
         fprintf(stderr, "spectr_fpga_get_signal() not initialized\n");
@@ -224,10 +224,10 @@ int spectr_fpga_get_signal(double **cha_signal, double **chb_signal)
         chb_o[out_idx] = g_spectr_fpga_chb_mem[in_idx];
 
         // convert to signed
-        if(cha_o[out_idx] > (double)(1<<13))
-            cha_o[out_idx] -= (double)(1<<14);
-        if(chb_o[out_idx] > (double)(1<<13))
-            chb_o[out_idx] -= (double)(1<<14);
+        if(cha_o[out_idx] > (float)(1<<13))
+            cha_o[out_idx] -= (float)(1<<14);
+        if(chb_o[out_idx] > (float)(1<<13))
+            chb_o[out_idx] -= (float)(1<<14);
     }
     return 0;
 }
@@ -0,0 +1,410 @@
+/**
+ * @brief Red Pitaya lockbox benchmark
+ *
+ * Measures the throughput and latency of the library hot paths and, when a
+ * SCPI server is available, of the command round trip. Every benchmark
+ * repeats its operation until a minimum time has elapsed and prints one JSON
+ * object per line, so that results of different revisions can be compared by
+ * scripts.
+ *
+ * The library is linked statically to reach its internal functions. Without a
+ * backend given in LOCKBOX_BACKEND the in-memory register map of the simulator
+ * is used, so the benchmark also runs on a development machine.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "redpitaya/lockbox.h"
+#include "common.h"
+#include "generate.h"
+#include "config.h"
+#include "spec_dsp.h"
+#include "spec_fpga.h"
+#include "sim.h"
+
+#define SCPI_PORT           "5000"
+#define SCPI_DELIMITER      "\r\n"
+#define SCPI_CONNECT_MS     5000        // Time given to a started server to listen
+
+// Longest response expected from the server (ACQ:SOUR#:DATA? in ASCII)
+#define SCPI_RESPONSE_SIZE  (ADC_BUFFER_SIZE * 16)
+
+typedef int (*bench_fn_t)(void *arg);
+
+static double min_time = 1.0;           // s per benchmark
+static const char *backend = "sim";
+
+static float samples_v[2][ADC_BUFFER_SIZE];
+static uint16_t samples_raw[2][ADC_BUFFER_SIZE];
+static float waveform[BUFFER_LENGTH];
+static float spectrum_in[2][SPECTR_FPGA_SIG_LEN];
+static float spectrum_tmp[2][SPECTR_FPGA_SIG_LEN];
+static float spectrum_out[2][SPECTR_FPGA_SIG_LEN];
+static char config_path[] = "/tmp/lockbox-bench-XXXXXX";
+
+static int scpi_fd = -1;
+static pid_t scpi_pid = 0;
+static char scpi_response[SCPI_RESPONSE_SIZE];
+
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, double value, const char *unit, uint64_t iterations, double seconds)
+{
+    printf("{\"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"iterations\": %llu, "
+           "\"seconds\": %.3f, \"backend\": \"%s\"}\n",
+           name, value, unit, (unsigned long long) iterations, seconds, backend);
+    fflush(stdout);
+}
+
+static void reportSkipped(const char *name, const char *reason)
+{
+    printf("{\"name\": \"%s\", \"skipped\": \"%s\", \"backend\": \"%s\"}\n", name, reason, backend);
+    fflush(stdout);
+}
+
+/*
+ * Calls fn in batches of doubling size until min_time has elapsed.
+ * Returns the number of calls and their duration in s, or -1 if a call failed.
+ */
+static int run(bench_fn_t fn, void *arg, uint64_t *iterations, double *seconds)
+{
+    uint64_t batch = 1;
+    uint64_t count = 0;
+    double start = now();
+    double elapsed = 0;
+
+    while (elapsed < min_time) {
+        for (uint64_t i = 0; i < batch; i++) {
+            if (fn(arg) != RP_OK) {
+                return -1;
+            }
+        }
+        count += batch;
+        elapsed = now() - start;
+        if (batch < (1 << 20)) {
+            batch *= 2;
+        }
+    }
+    *iterations = count;
+    *seconds = elapsed;
+    return 0;
+}
+
+/* Reports items per second, where every call processes items_per_call items */
+static void benchRate(const char *name, bench_fn_t fn, void *arg, double items_per_call, const char *unit)
+{
+    uint64_t iterations;
+    double seconds;
+
+    if (run(fn, arg, &iterations, &seconds) < 0) {
+        reportSkipped(name, "call failed");
+        return;
+    }
+    report(name, iterations * items_per_call / seconds, unit, iterations, seconds);
+}
+
+/* Reports the mean duration of a call in us */
+static void benchLatency(const char *name, bench_fn_t fn, void *arg)
+{
+    uint64_t iterations;
+    double seconds;
+
+    if (run(fn, arg, &iterations, &seconds) < 0) {
+        reportSkipped(name, "call failed");
+        return;
+    }
+    report(name, seconds / iterations * 1e6, "us", iterations, seconds);
+}
+
+
+/*
+ * Library benchmarks
+ */
+
+static int acqGetDataV(void *arg)
+{
+    uint32_t size = ADC_BUFFER_SIZE;
+    return rp_AcqGetDataV(RP_CH_1, 0, &size, samples_v[0]);
+}
+
+static int acqGetDataRawV2(void *arg)
+{
+    uint32_t size = ADC_BUFFER_SIZE;
+    return rp_AcqGetDataRawV2(0, &size, samples_raw[0], samples_raw[1]);
+}
+
+static int cnvVToCnt(void *arg)
+{
+    volatile uint32_t sum = 0;
+    for (uint32_t i = 0; i < BUFFER_LENGTH; i++) {
+        sum += cmn_CnvVToCnt(DATA_BIT_LENGTH, waveform[i], AMPLITUDE_MAX, false, 0, 0, 0.0);
+    }
+    return RP_OK;
+}
+
+static int cnvCntToV(void *arg)
+{
+    volatile float sum = 0;
+    for (uint32_t i = 0; i < ADC_BUFFER_SIZE; i++) {
+        sum += cmn_CnvCntToV(DATA_BIT_LENGTH, i & ((1 << DATA_BIT_LENGTH) - 1), 1.0, 0, 0, 0.0);
+    }
+    return RP_OK;
+}
+
+static int writeData(void *arg)
+{
+    return generate_writeData(RP_CH_1, waveform, 0, BUFFER_LENGTH);
+}
+
+static int configSave(void *arg)
+{
+    return config_Save(config_path);
+}
+
+static int configLoad(void *arg)
+{
+    return config_Load(config_path);
+}
+
+static int spectrum(void *arg)
+{
+    float *tmp[2] = { spectrum_tmp[0], spectrum_tmp[1] };
+    float *out[2] = { spectrum_out[0], spectrum_out[1] };
+    float peak_power[2], peak_freq[2];
+
+    if (rp_spectr_hann_filter(spectrum_in[0], spectrum_in[1], &out[0], &out[1]) < 0
+            || rp_spectr_fft(out[0], out[1], &tmp[0], &tmp[1]) < 0
+            || rp_spectr_decimate(tmp[0], tmp[1], &out[0], &out[1], c_dsp_sig_len, SPECTR_OUT_SIG_LENGTH) < 0
+            || rp_spectr_cnv_to_dBm(out[0], out[1], &tmp[0], &tmp[1],
+                                    &peak_power[0], &peak_freq[0], &peak_power[1], &peak_freq[1], 0) < 0) {
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+static void benchLibrary()
+{
+    for (uint32_t i = 0; i < BUFFER_LENGTH; i++) {
+        waveform[i] = sin(2 * M_PI * i / BUFFER_LENGTH);
+    }
+    for (uint32_t i = 0; i < SPECTR_FPGA_SIG_LEN; i++) {
+        spectrum_in[0][i] = 1000 * sin(2 * M_PI * 100 * i / SPECTR_FPGA_SIG_LEN);
+        spectrum_in[1][i] = 1000 * cos(2 * M_PI * 250 * i / SPECTR_FPGA_SIG_LEN);
+    }
+
+    benchRate("acq_get_data_v", acqGetDataV, NULL, ADC_BUFFER_SIZE, "samples/s");
+    benchRate("acq_get_data_raw_v2", acqGetDataRawV2, NULL, 2 * ADC_BUFFER_SIZE, "samples/s");
+    benchRate("cnv_v_to_cnt", cnvVToCnt, NULL, BUFFER_LENGTH, "conversions/s");
+    benchRate("cnv_cnt_to_v", cnvCntToV, NULL, ADC_BUFFER_SIZE, "conversions/s");
+    benchLatency("gen_write_data", writeData, NULL);
+
+    int fd = mkstemp(config_path);
+    if (fd < 0) {
+        reportSkipped("config_save", "no temporary file");
+        reportSkipped("config_load", "no temporary file");
+    }
+    else {
+        close(fd);
+        benchLatency("config_save", configSave, NULL);
+        benchLatency("config_load", configLoad, NULL);
+        unlink(config_path);
+    }
+
+    benchRate("spectrum_pipeline", spectrum, NULL, 1, "spectra/s");
+    rp_spectr_hann_clean();
+    rp_spectr_fft_clean();
+}
+
+
+/*
+ * SCPI benchmarks
+ */
+
+static int scpiConnect(const char *host)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addresses;
+
+    if (getaddrinfo(host, SCPI_PORT, &hints, &addresses) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo *a = addresses; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (fd >= 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+/* Sends a query and reads the response up to the delimiter */
+static int scpiQuery(void *arg)
+{
+    const char *query = arg;
+    size_t length = strlen(query);
+    size_t received = 0;
+
+    if (send(scpi_fd, query, length, 0) != length
+            || send(scpi_fd, SCPI_DELIMITER, 2, 0) != 2) {
+        return RP_EOOR;
+    }
+    while (received < 2 || memcmp(&scpi_response[received - 2], SCPI_DELIMITER, 2) != 0) {
+        if (received == sizeof(scpi_response)) {
+            return RP_BTS;
+        }
+        ssize_t n = recv(scpi_fd, &scpi_response[received], sizeof(scpi_response) - received, 0);
+        if (n <= 0) {
+            return RP_EOOR;
+        }
+        received += n;
+    }
+    return RP_OK;
+}
+
+/* Starts the server with the simulator and waits until it accepts connections */
+static int scpiStart(const char *server)
+{
+    scpi_pid = fork();
+    if (scpi_pid < 0) {
+        return -1;
+    }
+    if (scpi_pid == 0) {
+        setenv(SIM_BACKEND_ENV, "sim", 1);
+        execl(server, server, (char *) NULL);
+        _exit(127);
+    }
+
+    for (int i = 0; i < SCPI_CONNECT_MS / 10; i++) {
+        scpi_fd = scpiConnect("localhost");
+        if (scpi_fd >= 0) {
+            return 0;
+        }
+        if (waitpid(scpi_pid, NULL, WNOHANG) == scpi_pid) {
+            scpi_pid = 0;
+            return -1;
+        }
+        usleep(10000);
+    }
+    return -1;
+}
+
+static void scpiStop()
+{
+    if (scpi_fd >= 0) {
+        close(scpi_fd);
+        scpi_fd = -1;
+    }
+    if (scpi_pid > 0) {
+        kill(scpi_pid, SIGTERM);
+        waitpid(scpi_pid, NULL, 0);
+        scpi_pid = 0;
+    }
+}
+
+static void benchScpi(const char *host, const char *server)
+{
+    if (server && scpiStart(server) < 0) {
+        fprintf(stderr, "Failed to start %s\n", server);
+    }
+    else if (host) {
+        scpi_fd = scpiConnect(host);
+    }
+
+    if (scpi_fd < 0) {
+        const char *reason = (host || server) ? "no connection" : "no server given";
+        reportSkipped("scpi_idn_round_trip", reason);
+        reportSkipped("scpi_acq_data", reason);
+        scpiStop();
+        return;
+    }
+
+    benchLatency("scpi_idn_round_trip", scpiQuery, "*IDN?");
+    benchLatency("scpi_acq_data", scpiQuery, "ACQ:SOUR1:DATA?");
+    scpiStop();
+}
+
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-t seconds] [-H host | -S server]\n"
+            "  -t seconds  minimum duration of every benchmark (default %.1f)\n"
+            "  -H host     measure the SCPI commands of a running server\n"
+            "  -S server   start the server executable with the simulator and measure it\n",
+            name, min_time);
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = NULL;
+    const char *server = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:H:S:h")) != -1) {
+        switch (opt) {
+        case 't':
+            min_time = atof(optarg);
+            break;
+        case 'H':
+            host = optarg;
+            break;
+        case 'S':
+            server = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // The register map of the simulator unless a backend is chosen
+    if (getenv(SIM_BACKEND_ENV)) {
+        backend = getenv(SIM_BACKEND_ENV);
+    }
+    else {
+        setenv(SIM_BACKEND_ENV, backend, 1);
+    }
+
+    int result = rp_Init();
+    if (result != RP_OK) {
+        fprintf(stderr, "Failed to initialize the library: %s\n", rp_GetError(result));
+        return 1;
+    }
+    benchLibrary();
+    rp_Release();
+
+    benchScpi(host, server);
+    return 0;
+}
@@ -90,6 +90,34 @@ class RedPitaya():
         self.tx_txt(msg)
         return self.rx_txt()
 
+    def tx_txt_batch(self, msgs):
+        """Send several text strings at once, each followed by the delimiter.
+
+        The server executes all commands received at once before it replies, so this is much
+        faster than calling tx_txt for each command, e.g., for parameter sweeps.
+
+        :msgs: list of text strings to send
+        """
+        LOG.debug("TX: %d commands", len(msgs))
+        try:
+            self._socket.sendall(''.join(msg + self.delimiter for msg in msgs).encode('utf-8'))
+        except (OSError, socket.timeout) as err:
+            LOG.error("Failed to send message to socket. Error: %s", err)
+
+    def txrx_txt_batch(self, msgs, chunksize=4096):
+        """Send several text strings at once and return the responses to the queries among them.
+
+        :msgs: list of text strings to send
+        :chunksize: number of bytes to receive at once (default: 4096)
+        :returns: list of responses, one for each message ending with '?'
+        """
+        num_queries = sum(1 for msg in msgs if msg.endswith('?'))
+        self.tx_txt_batch(msgs)
+        msg = ''
+        while msg.count(self.delimiter) < num_queries:
+            msg += self._socket.recv(chunksize).decode('utf-8')
+        return msg.split(self.delimiter)[:num_queries]
+
     def set_output_state(self, num_out, state):
         """Disable or enable the signal generator output.
 
@@ -243,6 +271,20 @@ class RedPitaya():
         """
         return float(self.txrx_txt('PID:IN{}:OUT{}:KD?'.format(num_in, num_out)))
 
+    def set_pid_params(self, num_in, num_out, setpoint, kp, ki, kd, kii, kg):
+        """Set the setpoint and all gains at once (units as in the single setters).
+
+        The new values take effect in the same clock cycle."""
+        self.tx_txt('PID:IN{}:OUT{}:PARams {},{},{},{},{},{}'.format(
+            num_in, num_out, setpoint, kp, ki, kd, kii, kg))
+
+    def get_pid_params(self, num_in, num_out):
+        """Return the setpoint and all gains.
+
+        :returns: tuple (setpoint, kp, ki, kd, kii, kg)."""
+        return tuple(float(x) for x in self.txrx_txt(
+            'PID:IN{}:OUT{}:PARams?'.format(num_in, num_out)).split(','))
+
     def set_int_reset_state(self, num_in, num_out, state):
         """Reset the integrator register.
 
@@ -382,6 +424,68 @@ class RedPitaya():
         response = self.txrx_txt('PID:IN{}:OUT{}:REL:INP?'.format(num_in, num_out))
         return int(response[-1]) # response format: AIN[0-3]
 
+    def get_lock_stats(self, num_in, num_out):
+        """Return the lock statistics of the specified PID, counted by the FPGA at every clock
+        cycle. Times are in s; timestamps count from the start of the FPGA.
+
+        :returns: dict with the keys 'locked', 'unlock_count', 'unlocked_time',
+            'longest_outage', 'last_unlock', 'last_relock' and 'timestamp'
+        """
+        values = self.txrx_txt('PID:IN{}:OUT{}:LOCK:STAT?'.format(num_in, num_out)).split(',')
+        fields = [('locked', _to_bool), ('unlock_count', int), ('unlocked_time', float),
+                  ('longest_outage', float), ('last_unlock', float), ('last_relock', float),
+                  ('timestamp', float)]
+        return {name: convert(value) for (name, convert), value in zip(fields, values)}
+
+    def reset_lock_stats(self, num_in, num_out):
+        """Reset the lock statistics of the specified PID to zero."""
+        self.tx_txt('PID:IN{}:OUT{}:LOCK:STAT:RES'.format(num_in, num_out))
+
+    def set_pid_error_signal(self, num_in, num_out, error_signal):
+        """Select the error signal of the specified PID
+
+        :error_signal: 'DIRECT' for the input, 'I' or 'Q' for an output of the IQ demodulator of
+            the input
+        """
+        self.tx_txt('PID:IN{}:OUT{}:ERR {}'.format(num_in, num_out, error_signal))
+
+    def get_pid_error_signal(self, num_in, num_out):
+        """Return the error signal of the specified PID
+
+        :returns: 'DIRECT', 'I' or 'Q'
+        """
+        return self.txrx_txt('PID:IN{}:OUT{}:ERR?'.format(num_in, num_out))
+
+    def set_iq_demodulator(self, num_in, frequency=None, phase=None, bandwidth=None, gain=None,
+                           reference=None):
+        """Configure the IQ demodulator of the specified input. Parameters that are None are
+        left unchanged.
+
+        :frequency: frequency of the internal reference oscillator in Hz
+        :phase: phase of the reference in degrees
+        :bandwidth: corner frequency of the two low-pass filters in Hz
+        :gain: gain of the I and Q outputs, rounded to a power of two (1 - 16384)
+        :reference: 'NCO' for the internal oscillator, 'GEN1' or 'GEN2' for the phase of a
+            signal generator output
+        """
+        for command, value in [('FREQ', frequency), ('PHAS', phase), ('BAND', bandwidth),
+                               ('GAIN', gain), ('REF', reference)]:
+            if value is not None:
+                self.tx_txt('PID:IN{}:IQ:{} {}'.format(num_in, command, value))
+
+    def get_iq_demodulator(self, num_in):
+        """Return the configuration of the IQ demodulator of the specified input
+
+        :returns: dict with frequency, phase, bandwidth, gain and reference
+        """
+        return {
+            'frequency': float(self.txrx_txt('PID:IN{}:IQ:FREQ?'.format(num_in))),
+            'phase': float(self.txrx_txt('PID:IN{}:IQ:PHAS?'.format(num_in))),
+            'bandwidth': float(self.txrx_txt('PID:IN{}:IQ:BAND?'.format(num_in))),
+            'gain': float(self.txrx_txt('PID:IN{}:IQ:GAIN?'.format(num_in))),
+            'reference': self.txrx_txt('PID:IN{}:IQ:REF?'.format(num_in)),
+        }
+
     def set_output_minimum(self, num_out, minimum):
         """Set the minimum output voltage for the specified channel.
 
@@ -421,3 +525,131 @@ class RedPitaya():
     def load_lockbox_config(self):
         """Load the lockbox configuration from the SD-card."""
         self.tx_txt("LOCK:CONF:LOAD")
+
+    def store_preset(self, name):
+        """Store the current PID and output limit configuration as a preset.
+
+        :name: name of the preset (letters, digits, '-' and '_')
+        """
+        self.tx_txt("LOCK:PRES:STOR {}".format(name))
+
+    def apply_preset(self, name):
+        """Apply a preset stored with store_preset.
+
+        :name: name of the preset
+        """
+        self.tx_txt("LOCK:PRES:APPL {}".format(name))
+
+    def delete_preset(self, name):
+        """Delete a preset.
+
+        :name: name of the preset
+        """
+        self.tx_txt("LOCK:PRES:DEL {}".format(name))
+
+    def get_snapshot(self):
+        """Return the complete lockbox configuration together with the lock status and the
+        input and output voltages, read in one query.
+
+        :returns: dict with the keys 'pid' (dict of dicts indexed by (num_in, num_out)),
+            'output' (dict of dicts indexed by num_out), 'in_voltage', 'out_voltage' and
+            'ain_voltage' (lists of voltages)
+        """
+        values = iter(self.txrx_txt("LOCK:SNAP?").split(','))
+        pid_fields = [
+            ('setpoint', float), ('kp', float), ('ki', float), ('kd', float), ('kii', float),
+            ('kg', float), ('int_reset', _to_bool), ('inverted', _to_bool),
+            ('int_auto', _to_bool), ('hold', _to_bool), ('relock', _to_bool),
+            ('enabled', _to_bool), ('relock_stepsize', float), ('relock_minimum', float),
+            ('relock_maximum', float), ('relock_input', str), ('lso_enabled', _to_bool),
+            ('ext_reset_enabled', _to_bool), ('ext_reset_input', str),
+            ('lock_status', _to_bool)]
+        output_fields = [
+            ('minimum', float), ('maximum', float), ('generator_enabled', _to_bool),
+            ('generator_poffset_enabled', _to_bool), ('generator_amplitude', float),
+            ('generator_offset', float), ('generator_frequency', float),
+            ('generator_waveform', str)]
+        snapshot = {'pid': {}, 'output': {}}
+        for num_out, num_in in [(1, 1), (1, 2), (2, 1), (2, 2)]:
+            snapshot['pid'][(num_in, num_out)] = {
+                name: convert(next(values)) for name, convert in pid_fields}
+        for num_out in [1, 2]:
+            snapshot['output'][num_out] = {
+                name: convert(next(values)) for name, convert in output_fields}
+        snapshot['in_voltage'] = [float(next(values)) for _ in range(2)]
+        snapshot['out_voltage'] = [float(next(values)) for _ in range(2)]
+        snapshot['ain_voltage'] = [float(next(values)) for _ in range(4)]
+        return snapshot
+
+    def start_noise_spectrum(self, num_in, segment_length=4096, overlap=0.5, averages=16):
+        """Start averaging the noise spectral density of an input on the Red Pitaya.
+
+        :segment_length: length of the FFT segments in samples (power of 2, 64 to 16384)
+        :overlap: overlap of consecutive segments as a fraction of their length (0 to <1)
+        :averages: number of segments averaged for each spectrum
+        """
+        self.tx_txt("ACQ:SOUR{}:PSD:START {},{},{}".format(
+            num_in, segment_length, overlap, averages))
+
+    def stop_noise_spectrum(self):
+        """Stop the noise spectral density measurement."""
+        self.tx_txt("ACQ:PSD:STOP")
+
+    def get_noise_spectrum(self):
+        """Return the last averaged noise spectral density.
+
+        :returns: tuple (bin_width, spectrum) with the bin width in Hz and a list of amplitude
+            spectral densities in V/sqrt(Hz), starting at 0 Hz
+        """
+        bin_width = float(self.txrx_txt("ACQ:PSD:BINW?"))
+        spectrum = self.txrx_txt("ACQ:PSD:DATA?").strip('{}')
+        return bin_width, [float(value) for value in spectrum.split(',')]
+
+    def start_bode(self, num_out, amplitude, start, stop, points, settle_time=0.01, cycles=10):
+        """Start a swept-sine transfer function measurement on the Red Pitaya.
+
+        The excitation is added to the output num_out; the transfer function is measured from
+        input 1 to input 2.
+
+        :amplitude: excitation amplitude in V
+        :start: first frequency in Hz
+        :stop: last frequency in Hz
+        :points: number of logarithmically spaced frequencies (at most 1024)
+        :settle_time: time in s to wait after changing the frequency
+        :cycles: minimum number of excitation periods to integrate over
+        """
+        self.tx_txt("SOUR{}:BODE:START {},{},{},{},{},{}".format(
+            num_out, amplitude, start, stop, points, settle_time, cycles))
+
+    def stop_bode(self):
+        """Stop the transfer function measurement."""
+        self.tx_txt("BODE:STOP")
+
+    def get_bode_state(self):
+        """Return whether the transfer function measurement is running."""
+        return _to_bool(self.txrx_txt("BODE:STAT?"))
+
+    def get_bode(self):
+        """Return the frequencies measured so far.
+
+        :returns: list of dicts with the keys 'frequency' (Hz), 'amplitude_in1' and
+            'amplitude_in2' (V), 'magnitude' and 'phase' (degrees) of the transfer function
+            from input 1 to input 2
+        """
+        response = self.txrx_txt("BODE:DATA?").strip('{}')
+        values = [float(value) for value in response.split(',') if value]
+        names = ['frequency', 'amplitude_in1', 'amplitude_in2', 'magnitude', 'phase']
+        return [dict(zip(names, values[i:i + len(names)]))
+                for i in range(0, len(values), len(names))]
+
+    def wait_trigger(self, timeout=1000):
+        """Wait for the current scope acquisition to finish.
+
+        :timeout: maximum time to wait in ms
+        :returns: True if the acquisition is done, False on timeout
+        """
+        return self.txrx_txt("ACQ:TRIG:WAIT? {}".format(int(timeout))) == 'TD'
+
+def _to_bool(response):
+    """Convert a SCPI boolean response to bool."""
+    return response in ('1', 'ON')
@@ -52,6 +52,8 @@ module red_pitaya_ps (
   // system signals
   output logic [  4-1:0] fclk_clk_o         ,
   output logic [  4-1:0] fclk_rstn_o        ,
+  // interrupts
+  input  logic           irq_i              ,  // IRQ_F2P[0], scope acquisition done
   // GPIO
   gpio_if.m              gpio,
   // system read/write channel
@@ -259,6 +261,8 @@ system system_i (
   .FCLK_RESET1_N     (fclk_rstn[1]     ),
   .FCLK_RESET2_N     (fclk_rstn[2]     ),
   .FCLK_RESET3_N     (fclk_rstn[3]     ),
+  // interrupts
+  .IRQ_F2P           (irq_i            ),
   // GP0
   .M_AXI_GP0_ACLK    (axi_gp.ACLK   ),
 //  .M_AXI_GP0_ARESETn (axi_gp.ARESETn),
@@ -184,6 +184,7 @@ logic signed [14-1:0] dac_a_center, dac_b_center;  // center of the output range
 
 // ASG
 SBG_T [2-1:0]            asg_dat;
+logic [2-1:0] [14-1:0]   asg_phase;
 
 // PID
 SBA_T [2-1:0]            pid_dat;
@@ -269,6 +270,8 @@ red_pitaya_ps ps (
   // system signals
   .fclk_clk_o    (fclk        ),
   .fclk_rstn_o   (frstn       ),
+  // interrupts
+  .irq_i         (trig_done   ),
   // ADC analog inputs
 //  .vinp_i        (vinp_i      ),
 //  .vinn_i        (vinn_i      ),
@@ -476,6 +479,7 @@ assign gpio.i[23:16] = exp_n_in;
 ////////////////////////////////////////////////////////////////////////////////
 
 logic trig_asg_out;
+logic trig_done;
 
 red_pitaya_scope i_scope (
   // ADC
@@ -485,6 +489,7 @@ red_pitaya_scope i_scope (
   .adc_rstn_i    (adc_rstn    ),  // reset - active low
   .trig_ext_i    (gpio.i[8]   ),  // external trigger
   .trig_asg_i    (trig_asg_out),  // ASG trigger
+  .trig_done_o   (trig_done   ),  // acquisition done interrupt
   // AXI0 master                 // AXI1 master
   .axi0_clk_o    (axi0_clk   ),  .axi1_clk_o    (axi1_clk   ),
   .axi0_rstn_o   (axi0_rstn  ),  .axi1_rstn_o   (axi1_rstn  ),
@@ -520,6 +525,8 @@ red_pitaya_asg i_asg (
   .trig_a_i        (gpio.i[8]   ),
   .trig_b_i        (gpio.i[8]   ),
   .trig_out_o      (trig_asg_out),
+  .phase_a_o       (asg_phase[0]),  // CH 1 table read pointer
+  .phase_b_o       (asg_phase[1]),  // CH 2 table read pointer
   // System bus
   .sys_addr        (sys[2].addr ),
   .sys_wdata       (sys[2].wdata),
@@ -554,6 +561,8 @@ red_pitaya_pid i_pid (
   .out_b_center_i  (dac_b_center), // center of out 2 range
   .reset_a_i       (gpio.i[13])  , // PID11 loop reset
   .reset_d_i       (gpio.i[14])  , // PID22 loop reset
+  .asg_a_phase_i   (asg_phase[0]), // generator 1 phase
+  .asg_b_phase_i   (asg_phase[1]), // generator 2 phase
 
    // Output signals
   .dat_a_o         (pid_dat[0]  ), // out 1
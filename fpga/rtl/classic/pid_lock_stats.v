@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2018, Fabian Schmid
+ *
+ * All rights reserved.
+ *
+ * Counts the transitions of the lock status of a PID and the time spent
+ * unlocked, so that outages shorter than the polling interval of a client
+ * are not missed. Times are counted in clock cycles; unlock and relock
+ * events are stamped with the free-running counter time_i.
+ */
+`timescale 1ns / 1ps
+
+module pid_lock_stats (
+    input  wire            clk_i,
+    input  wire            rstn_i,
+    input  wire            locked_i,         // lock status
+    input  wire [64-1:0]   time_i,           // timestamp counter
+    input  wire            clear_i,          // reset the statistics
+    output reg  [32-1:0]   unlock_count_o,   // number of unlock events
+    output reg  [64-1:0]   unlocked_time_o,  // total time unlocked
+    output reg  [64-1:0]   longest_o,        // longest single outage
+    output reg  [64-1:0]   last_unlock_o,    // time of the last unlock event
+    output reg  [64-1:0]   last_relock_o     // time of the last relock event
+);
+
+reg          locked_f;
+reg [64-1:0] outage_f;      // duration of the current outage
+
+always @(posedge clk_i) begin
+    locked_f <= locked_i;
+    if (!rstn_i || clear_i) begin
+        unlock_count_o  <= 32'd0;
+        unlocked_time_o <= 64'd0;
+        longest_o       <= 64'd0;
+        last_unlock_o   <= 64'd0;
+        last_relock_o   <= 64'd0;
+        outage_f        <= 64'd0;
+    end else begin
+        if (locked_f && !locked_i) begin
+            unlock_count_o <= unlock_count_o + 32'd1;
+            last_unlock_o  <= time_i;
+        end
+        if (!locked_f && locked_i)
+            last_relock_o <= time_i;
+
+        if (!locked_i) begin
+            unlocked_time_o <= unlocked_time_o + 64'd1;
+            outage_f        <= outage_f + 64'd1;
+            // The ongoing outage counts as soon as it is the longest one
+            if (outage_f >= longest_o)
+                longest_o <= outage_f + 64'd1;
+        end else begin
+            outage_f <= 64'd0;
+        end
+    end
+end
+
+endmodule
@@ -57,6 +57,8 @@ module red_pitaya_asg (
   input                 trig_a_i  ,  // starting trigger CHA
   input                 trig_b_i  ,  // starting trigger CHB
   output                trig_out_o,  // notification trigger
+  output     [ 14-1: 0] phase_a_o ,  // table read pointer CHA
+  output     [ 14-1: 0] phase_b_o ,  // table read pointer CHB
   // System bus
   input      [ 32-1: 0] sys_addr  ,  // bus address
   input      [ 32-1: 0] sys_wdata ,  // bus write data
@@ -129,6 +131,11 @@ red_pitaya_asg_ch  #(.RSZ (RSZ)) ch [1:0] (
   .set_rgate_i     ({set_b_rgate      , set_a_rgate      })   // set external gated repetition
 );
 
+// The read pointer is the phase of the built-in waveforms, which fill the
+// whole table with one period
+assign phase_a_o = buf_a_rpnt ;
+assign phase_b_o = buf_b_rpnt ;
+
 always @(posedge dac_clk_i)
 begin
    buf_a_we   <= sys_wen && (sys_addr[19:RSZ+2] == 'h1);
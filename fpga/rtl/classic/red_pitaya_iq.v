@@ -0,0 +1,267 @@
+/**
+ * Copyright (c) 2018, Fabian Schmid
+ *
+ * All rights reserved.
+ *
+ * @brief Red Pitaya IQ demodulator (lock-in) for the PID error signal.
+ *
+ * This part of code is written in Verilog hardware description language (HDL).
+ * Please visit http://en.wikipedia.org/wiki/Verilog
+ * for more details on the language used herein.
+ */
+
+
+
+/**
+ * GENERAL DESCRIPTION:
+ *
+ * Demodulates an ADC input at the phase of a reference oscillator.
+ *
+ *
+ *                      /-----\       /-----\      /-----\      /------\
+ *   IN -------------+->|  X  | ----> | LPF | ---> | LPF | ---> | GAIN | ---> I
+ *                   |  \-----/       \-----/      \-----/      \------/
+ *                   |     ^ sin
+ *     /-----\   /---\     |
+ *     | NCO |-->|   |   /-----\
+ *     \-----/   |MUX|-->| LUT |
+ *   ASG A ----->|   |   \-----/
+ *   ASG B ----->|   |     | cos
+ *               \---/  /-----\       /-----\      /-----\      /------\
+ *                 ^ +  |  X  | ----> | LPF | ---> | LPF | ---> | GAIN | ---> Q
+ *       phase ----/    \-----/       \-----/      \-----/      \------/
+ *
+ *
+ * The reference phase is either the 32 bit phase accumulator of the internal
+ * numerically controlled oscillator or the table read pointer of one signal
+ * generator channel, so that a modulation produced by the generator can be
+ * demodulated without any frequency or phase drift. A phase offset is added to
+ * the reference before the sine and cosine are taken from a quarter wave table.
+ *
+ * For an input A*sin(ref + a) the outputs are I = A*cos(a - phase) and
+ * Q = A*sin(a - phase), multiplied by 2^gain and saturated to 14 bits.
+ *
+ * Each low-pass is a first order IIR filter y += (x - y) >> bw with a corner
+ * frequency of about 125 MHz / (2*pi * 2^bw).
+ *
+ */
+
+`timescale 1ns / 1ps
+module red_pitaya_iq #(
+   parameter     BW_BITS = 5                    ,  // width of the low-pass shift
+   parameter     BW_MAX  = 24                      // largest low-pass shift
+)
+(
+   // data
+   input                        clk_i           ,  // clock
+   input                        rstn_i          ,  // reset - active low
+   input signed  [ 14-1: 0]     dat_i           ,  // input data
+   input         [ 14-1: 0]     asg_a_phase_i   ,  // signal generator A table read pointer
+   input         [ 14-1: 0]     asg_b_phase_i   ,  // signal generator B table read pointer
+   output reg signed [14-1: 0]  i_o             ,  // in-phase output
+   output reg signed [14-1: 0]  q_o             ,  // quadrature output
+
+   // settings
+   input         [ 32-1: 0]     set_freq_i      ,  // NCO phase increment
+   input         [ 32-1: 0]     set_phase_i     ,  // reference phase offset
+   input         [  2-1: 0]     set_ref_i       ,  // reference: 0 - NCO, 1 - ASG A, 2 - ASG B
+   input         [ BW_BITS-1:0] set_bw_i        ,  // low-pass shift
+   input         [  4-1: 0]     set_gain_i         // output gain shift
+);
+
+localparam  MUL_BITS = 14 + 16                  ;  // mixer product
+localparam  ACC_BITS = MUL_BITS + BW_MAX        ;  // low-pass accumulator
+
+//---------------------------------------------------------------------------------
+//  Reference phase
+
+reg  [ 32-1: 0] nco_phase ;
+reg  [ 32-1: 0] ref_phase ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      nco_phase <= 32'h0 ;
+      ref_phase <= 32'h0 ;
+   end
+   else begin
+      nco_phase <= nco_phase + set_freq_i ;
+
+      case (set_ref_i)
+         2'd1:    ref_phase <= {asg_a_phase_i, 18'h0} + set_phase_i ;
+         2'd2:    ref_phase <= {asg_b_phase_i, 18'h0} + set_phase_i ;
+         default: ref_phase <= nco_phase + set_phase_i ;
+      endcase
+   end
+end
+
+//---------------------------------------------------------------------------------
+//  Sine and cosine from a quarter wave table
+//  lut[k] = 32767 * sin(2*pi * (k + 0.5) / 1024), so that all quadrants are
+//  mirrored without duplicating the samples at 0 and 90 degrees.
+
+reg  [ 15-1: 0] lut [0:255] ;
+
+initial begin
+   lut[  0] = 15'd  101; lut[  1] = 15'd  302; lut[  2] = 15'd  503; lut[  3] = 15'd  704;
+   lut[  4] = 15'd  905; lut[  5] = 15'd 1106; lut[  6] = 15'd 1307; lut[  7] = 15'd 1507;
+   lut[  8] = 15'd 1708; lut[  9] = 15'd 1909; lut[ 10] = 15'd 2110; lut[ 11] = 15'd 2310;
+   lut[ 12] = 15'd 2511; lut[ 13] = 15'd 2711; lut[ 14] = 15'd 2911; lut[ 15] = 15'd 3112;
+   lut[ 16] = 15'd 3312; lut[ 17] = 15'd 3512; lut[ 18] = 15'd 3712; lut[ 19] = 15'd 3911;
+   lut[ 20] = 15'd 4111; lut[ 21] = 15'd 4310; lut[ 22] = 15'd 4509; lut[ 23] = 15'd 4708;
+   lut[ 24] = 15'd 4907; lut[ 25] = 15'd 5106; lut[ 26] = 15'd 5305; lut[ 27] = 15'd 5503;
+   lut[ 28] = 15'd 5701; lut[ 29] = 15'd 5899; lut[ 30] = 15'd 6096; lut[ 31] = 15'd 6294;
+   lut[ 32] = 15'd 6491; lut[ 33] = 15'd 6688; lut[ 34] = 15'd 6885; lut[ 35] = 15'd 7081;
+   lut[ 36] = 15'd 7277; lut[ 37] = 15'd 7473; lut[ 38] = 15'd 7669; lut[ 39] = 15'd 7864;
+   lut[ 40] = 15'd 8059; lut[ 41] = 15'd 8254; lut[ 42] = 15'd 8448; lut[ 43] = 15'd 8642;
+   lut[ 44] = 15'd 8836; lut[ 45] = 15'd 9030; lut[ 46] = 15'd 9223; lut[ 47] = 15'd 9416;
+   lut[ 48] = 15'd 9608; lut[ 49] = 15'd 9800; lut[ 50] = 15'd 9992; lut[ 51] = 15'd10183;
+   lut[ 52] = 15'd10374; lut[ 53] = 15'd10564; lut[ 54] = 15'd10754; lut[ 55] = 15'd10944;
+   lut[ 56] = 15'd11133; lut[ 57] = 15'd11322; lut[ 58] = 15'd11511; lut[ 59] = 15'd11699;
+   lut[ 60] = 15'd11886; lut[ 61] = 15'd12074; lut[ 62] = 15'd12260; lut[ 63] = 15'd12446;
+   lut[ 64] = 15'd12632; lut[ 65] = 15'd12817; lut[ 66] = 15'd13002; lut[ 67] = 15'd13187;
+   lut[ 68] = 15'd13370; lut[ 69] = 15'd13554; lut[ 70] = 15'd13736; lut[ 71] = 15'd13919;
+   lut[ 72] = 15'd14101; lut[ 73] = 15'd14282; lut[ 74] = 15'd14462; lut[ 75] = 15'd14643;
+   lut[ 76] = 15'd14822; lut[ 77] = 15'd15001; lut[ 78] = 15'd15180; lut[ 79] = 15'd15358;
+   lut[ 80] = 15'd15535; lut[ 81] = 15'd15712; lut[ 82] = 15'd15888; lut[ 83] = 15'd16063;
+   lut[ 84] = 15'd16238; lut[ 85] = 15'd16413; lut[ 86] = 15'd16586; lut[ 87] = 15'd16759;
+   lut[ 88] = 15'd16932; lut[ 89] = 15'd17104; lut[ 90] = 15'd17275; lut[ 91] = 15'd17445;
+   lut[ 92] = 15'd17615; lut[ 93] = 15'd17784; lut[ 94] = 15'd17953; lut[ 95] = 15'd18121;
+   lut[ 96] = 15'd18288; lut[ 97] = 15'd18454; lut[ 98] = 15'd18620; lut[ 99] = 15'd18785;
+   lut[100] = 15'd18950; lut[101] = 15'd19113; lut[102] = 15'd19276; lut[103] = 15'd19438;
+   lut[104] = 15'd19600; lut[105] = 15'd19761; lut[106] = 15'd19921; lut[107] = 15'd20080;
+   lut[108] = 15'd20238; lut[109] = 15'd20396; lut[110] = 15'd20553; lut[111] = 15'd20709;
+   lut[112] = 15'd20865; lut[113] = 15'd21019; lut[114] = 15'd21173; lut[115] = 15'd21326;
+   lut[116] = 15'd21479; lut[117] = 15'd21630; lut[118] = 15'd21781; lut[119] = 15'd21930;
+   lut[120] = 15'd22079; lut[121] = 15'd22227; lut[122] = 15'd22375; lut[123] = 15'd22521;
+   lut[124] = 15'd22667; lut[125] = 15'd22812; lut[126] = 15'd22956; lut[127] = 15'd23099;
+   lut[128] = 15'd23241; lut[129] = 15'd23382; lut[130] = 15'd23522; lut[131] = 15'd23662;
+   lut[132] = 15'd23801; lut[133] = 15'd23938; lut[134] = 15'd24075; lut[135] = 15'd24211;
+   lut[136] = 15'd24346; lut[137] = 15'd24480; lut[138] = 15'd24613; lut[139] = 15'd24746;
+   lut[140] = 15'd24877; lut[141] = 15'd25007; lut[142] = 15'd25137; lut[143] = 15'd25265;
+   lut[144] = 15'd25393; lut[145] = 15'd25519; lut[146] = 15'd25645; lut[147] = 15'd25770;
+   lut[148] = 15'd25893; lut[149] = 15'd26016; lut[150] = 15'd26138; lut[151] = 15'd26259;
+   lut[152] = 15'd26378; lut[153] = 15'd26497; lut[154] = 15'd26615; lut[155] = 15'd26732;
+   lut[156] = 15'd26848; lut[157] = 15'd26962; lut[158] = 15'd27076; lut[159] = 15'd27189;
+   lut[160] = 15'd27300; lut[161] = 15'd27411; lut[162] = 15'd27521; lut[163] = 15'd27629;
+   lut[164] = 15'd27737; lut[165] = 15'd27843; lut[166] = 15'd27949; lut[167] = 15'd28053;
+   lut[168] = 15'd28157; lut[169] = 15'd28259; lut[170] = 15'd28360; lut[171] = 15'd28460;
+   lut[172] = 15'd28560; lut[173] = 15'd28658; lut[174] = 15'd28755; lut[175] = 15'd28850;
+   lut[176] = 15'd28945; lut[177] = 15'd29039; lut[178] = 15'd29131; lut[179] = 15'd29223;
+   lut[180] = 15'd29313; lut[181] = 15'd29403; lut[182] = 15'd29491; lut[183] = 15'd29578;
+   lut[184] = 15'd29664; lut[185] = 15'd29749; lut[186] = 15'd29832; lut[187] = 15'd29915;
+   lut[188] = 15'd29997; lut[189] = 15'd30077; lut[190] = 15'd30156; lut[191] = 15'd30234;
+   lut[192] = 15'd30311; lut[193] = 15'd30387; lut[194] = 15'd30462; lut[195] = 15'd30535;
+   lut[196] = 15'd30607; lut[197] = 15'd30679; lut[198] = 15'd30749; lut[199] = 15'd30818;
+   lut[200] = 15'd30885; lut[201] = 15'd30952; lut[202] = 15'd31017; lut[203] = 15'd31082;
+   lut[204] = 15'd31145; lut[205] = 15'd31206; lut[206] = 15'd31267; lut[207] = 15'd31327;
+   lut[208] = 15'd31385; lut[209] = 15'd31442; lut[210] = 15'd31498; lut[211] = 15'd31553;
+   lut[212] = 15'd31607; lut[213] = 15'd31659; lut[214] = 15'd31710; lut[215] = 15'd31760;
+   lut[216] = 15'd31809; lut[217] = 15'd31857; lut[218] = 15'd31903; lut[219] = 15'd31949;
+   lut[220] = 15'd31993; lut[221] = 15'd32036; lut[222] = 15'd32077; lut[223] = 15'd32118;
+   lut[224] = 15'd32157; lut[225] = 15'd32195; lut[226] = 15'd32232; lut[227] = 15'd32267;
+   lut[228] = 15'd32302; lut[229] = 15'd32335; lut[230] = 15'd32367; lut[231] = 15'd32397;
+   lut[232] = 15'd32427; lut[233] = 15'd32455; lut[234] = 15'd32482; lut[235] = 15'd32508;
+   lut[236] = 15'd32533; lut[237] = 15'd32556; lut[238] = 15'd32578; lut[239] = 15'd32599;
+   lut[240] = 15'd32619; lut[241] = 15'd32637; lut[242] = 15'd32655; lut[243] = 15'd32671;
+   lut[244] = 15'd32685; lut[245] = 15'd32699; lut[246] = 15'd32711; lut[247] = 15'd32722;
+   lut[248] = 15'd32732; lut[249] = 15'd32741; lut[250] = 15'd32748; lut[251] = 15'd32755;
+   lut[252] = 15'd32759; lut[253] = 15'd32763; lut[254] = 15'd32766; lut[255] = 15'd32767;
+end
+
+wire [ 10-1: 0] sin_pnt = ref_phase[32-1:32-10] ;
+wire [ 10-1: 0] cos_pnt = sin_pnt + 10'd256 ;
+wire [  8-1: 0] sin_adr = sin_pnt[8] ? ~sin_pnt[7:0] : sin_pnt[7:0] ;
+wire [  8-1: 0] cos_adr = cos_pnt[8] ? ~cos_pnt[7:0] : cos_pnt[7:0] ;
+
+reg  [ 15-1: 0] sin_lut   , cos_lut   ;
+reg             sin_neg   , cos_neg   ;
+reg  signed [ 16-1: 0] sin_val   , cos_val   ;
+reg  signed [ 14-1: 0] dat_r     , dat_rr    ;
+
+always @(posedge clk_i) begin
+   sin_lut <= lut[sin_adr] ;
+   cos_lut <= lut[cos_adr] ;
+   sin_neg <= sin_pnt[9] ;
+   cos_neg <= cos_pnt[9] ;
+
+   sin_val <= sin_neg ? -$signed({1'b0, sin_lut}) : $signed({1'b0, sin_lut}) ;
+   cos_val <= cos_neg ? -$signed({1'b0, cos_lut}) : $signed({1'b0, cos_lut}) ;
+
+   dat_r   <= dat_i ;
+   dat_rr  <= dat_r ;
+end
+
+//---------------------------------------------------------------------------------
+//  Mixer
+
+reg  signed [MUL_BITS-1: 0] mix_i , mix_q ;
+
+always @(posedge clk_i) begin
+   mix_i <= dat_rr * sin_val ;
+   mix_q <= dat_rr * cos_val ;
+end
+
+//---------------------------------------------------------------------------------
+//  Two first order low-pass filters per output
+
+reg  signed [ACC_BITS-1: 0] acc_i1, acc_i2, acc_q1, acc_q2 ;
+reg         [ BW_BITS-1: 0] bw_sr ;
+
+always @(posedge clk_i)
+   bw_sr <= (set_bw_i > BW_MAX) ? BW_MAX : set_bw_i ;
+
+wire signed [ACC_BITS-1: 0] lpf_i1 = acc_i1 >>> bw_sr ;
+wire signed [ACC_BITS-1: 0] lpf_i2 = acc_i2 >>> bw_sr ;
+wire signed [ACC_BITS-1: 0] lpf_q1 = acc_q1 >>> bw_sr ;
+wire signed [ACC_BITS-1: 0] lpf_q2 = acc_q2 >>> bw_sr ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      acc_i1 <= {ACC_BITS{1'b0}} ;
+      acc_i2 <= {ACC_BITS{1'b0}} ;
+      acc_q1 <= {ACC_BITS{1'b0}} ;
+      acc_q2 <= {ACC_BITS{1'b0}} ;
+   end
+   else begin
+      acc_i1 <= acc_i1 + mix_i  - lpf_i1 ;
+      acc_i2 <= acc_i2 + lpf_i1 - lpf_i2 ;
+      acc_q1 <= acc_q1 + mix_q  - lpf_q1 ;
+      acc_q2 <= acc_q2 + lpf_q1 - lpf_q2 ;
+   end
+end
+
+//---------------------------------------------------------------------------------
+//  Gain and saturation
+//  A full scale input gives 2^27 after the filters, i.e. 2^13 at gain 1.
+
+reg  signed [MUL_BITS-1: 0] flt_i , flt_q ;
+
+always @(posedge clk_i) begin
+   flt_i <= lpf_i2[MUL_BITS-1:0] ;
+   flt_q <= lpf_q2[MUL_BITS-1:0] ;
+end
+
+wire [  4-1: 0] gain_sr = (set_gain_i > 4'd14) ? 4'd0 : 4'd14 - set_gain_i ;
+
+wire signed [MUL_BITS-1: 0] out_i = flt_i >>> gain_sr ;
+wire signed [MUL_BITS-1: 0] out_q = flt_q >>> gain_sr ;
+
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0) begin
+      i_o <= 14'd0 ;
+      q_o <= 14'd0 ;
+   end
+   else begin
+      if (out_i[MUL_BITS-1:13] == {MUL_BITS-13{1'b0}} || out_i[MUL_BITS-1:13] == {MUL_BITS-13{1'b1}})
+         i_o <= out_i[14-1:0] ;
+      else
+         i_o <= {out_i[MUL_BITS-1], {13{~out_i[MUL_BITS-1]}}} ;
+
+      if (out_q[MUL_BITS-1:13] == {MUL_BITS-13{1'b0}} || out_q[MUL_BITS-1:13] == {MUL_BITS-13{1'b1}})
+         q_o <= out_q[14-1:0] ;
+      else
+         q_o <= {out_q[MUL_BITS-1], {13{~out_q[MUL_BITS-1]}}} ;
+   end
+end
+
+endmodule
@@ -50,6 +50,16 @@
  * Each output is sum of two controllers with different input. That sum is also
  * saturated to protect from wrapping.
  *
+ * Each input also feeds an IQ demodulator (red_pitaya_iq). Every controller
+ * takes either its input directly or the I or Q output of the demodulator of
+ * that input as its error signal.
+ *
+ * The lock status of every controller is monitored (pid_lock_stats): unlock
+ * events, time spent unlocked and the times of the last unlock and relock are
+ * counted in clock cycles of a free-running 64 bit counter. A write to 0x0C
+ * copies the statistics of all controllers to the read registers at once and
+ * clears those of the controllers whose bits are set.
+ *
  */
 `timescale 1ns / 1ps
 module red_pitaya_pid (
@@ -68,6 +78,8 @@ module red_pitaya_pid (
    input signed [ 14-1: 0] out_b_center_i  ,  // center of out 2 range
    input                   reset_a_i       ,  // PID11 loop reset
    input                   reset_d_i       ,  // PID22 loop reset
+   input        [ 14-1: 0] asg_a_phase_i   ,  // signal generator A table read pointer
+   input        [ 14-1: 0] asg_b_phase_i   ,  // signal generator B table read pointer
    output       [ 14-1: 0] dat_a_o         ,  //!< output data CHA
    output       [ 14-1: 0] dat_b_o         ,  //!< output data CHB
    output       [  4-1: 0] lock_status_o    ,  // lock status
@@ -90,6 +102,7 @@ localparam  KI_BITS = 24     ;
 localparam  KD_BITS = 24     ;
 localparam  RELOCK_STEP_BITS = 24;
 localparam  RELOCK_STEPSR = 18;
+localparam  IQ_BW_BITS = 5;
 
 wire        [14-1: 0    ] pid_in               [3:0];
 wire signed [14-1: 0    ] pid_out              [3:0];
@@ -99,6 +112,13 @@ reg         [KI_BITS-1:0] set_ki               [3:0];
 reg         [KD_BITS-1:0] set_kd               [3:0];
 reg         [KI_BITS-1:0] set_kii              [3:0];
 reg         [KP_BITS-1:0] set_kg               [3:0];
+reg         [14-1: 0    ] act_sp               [3:0];
+reg         [KP_BITS-1:0] act_kp               [3:0];
+reg         [KI_BITS-1:0] act_ki               [3:0];
+reg         [KD_BITS-1:0] act_kd               [3:0];
+reg         [KI_BITS-1:0] act_kii              [3:0];
+reg         [KP_BITS-1:0] act_kg               [3:0];
+reg         [3:0]         set_update_hold           ;
 reg         [3:0]         pid_inverted              ;
 reg         [3:0]         set_irst                  ;
 reg         [3:0]         set_irst_when_railed      ;
@@ -115,6 +135,8 @@ wire        [1:0]         output_enabled       [3:0];
 wire        [3:0]         ext_reset            [3:0];
 reg         [2-1:0]       ext_reset_source     [3:0];
 
+reg         [2-1:0]       pid_input_sel        [3:0];
+
 wire signed [15-1:0]      pid_sum              [3:0];
 wire signed [14-1:0]      pid_sat              [3:0];
 
@@ -131,18 +153,72 @@ wire        [12-1:0]               relock_signal_i  [3:0];
 wire                               relock_hold_i    [3:0];
 wire                               relock_locked_o  [3:0];
 
+// Lock statistics, counted and as last copied for reading
+reg         [64-1:0]               lock_time;
+reg         [3:0]                  lock_stats_clear;
+wire        [32-1:0]               stats_unlocks    [3:0];
+wire        [64-1:0]               stats_unlocked   [3:0];
+wire        [64-1:0]               stats_longest    [3:0];
+wire        [64-1:0]               stats_unlock     [3:0];
+wire        [64-1:0]               stats_relock     [3:0];
+reg         [3:0]                  snap_locked;
+reg         [64-1:0]               snap_time;
+reg         [32-1:0]               snap_unlocks     [3:0];
+reg         [64-1:0]               snap_unlocked    [3:0];
+reg         [64-1:0]               snap_longest     [3:0];
+reg         [64-1:0]               snap_unlock      [3:0];
+reg         [64-1:0]               snap_relock      [3:0];
+reg         [32-1:0]               lock_stats_rdata;
+
 wire        [12-1:0]               relock_i         [3:0];
 assign relock_i[0] = relock_a_i;
 assign relock_i[1] = relock_b_i;
 assign relock_i[2] = relock_c_i;
 assign relock_i[3] = relock_d_i;
 
+wire        [14-1:0]               adc_in           [1:0];
+assign adc_in[0] = dat_a_i;
+assign adc_in[1] = dat_b_i;
+
+// IQ demodulators of the inputs
+reg         [32-1:0]               iq_freq          [1:0];
+reg         [32-1:0]               iq_phase         [1:0];
+reg         [IQ_BW_BITS-1:0]       iq_bw            [1:0];
+reg         [4-1:0]                iq_gain          [1:0];
+reg         [2-1:0]                iq_ref           [1:0];
+wire signed [14-1:0]               iq_i             [1:0];
+wire signed [14-1:0]               iq_q             [1:0];
+
 // External (through digital input) loop reset
 wire        [3:0]                  reset_i          [3:0];
 assign reset_i[0] = reset_a_i;
 assign reset_i[1] = reset_d_i;
 
 genvar pid_index;
+genvar iq_index;
+
+generate for (iq_index = 0; iq_index < 2; iq_index = iq_index + 1) begin
+    red_pitaya_iq #(
+      .BW_BITS ( IQ_BW_BITS)
+    ) i_iq (
+       // data
+      .clk_i         (  clk_i                  ),  // clock
+      .rstn_i        (  rstn_i                 ),  // reset - active low
+      .dat_i         (  adc_in[iq_index]       ),  // input data
+      .asg_a_phase_i (  asg_a_phase_i          ),  // signal generator A phase
+      .asg_b_phase_i (  asg_b_phase_i          ),  // signal generator B phase
+      .i_o           (  iq_i[iq_index]         ),  // in-phase output
+      .q_o           (  iq_q[iq_index]         ),  // quadrature output
+
+       // settings
+      .set_freq_i    (  iq_freq[iq_index]      ),  // NCO phase increment
+      .set_phase_i   (  iq_phase[iq_index]     ),  // reference phase offset
+      .set_ref_i     (  iq_ref[iq_index]       ),  // reference source
+      .set_bw_i      (  iq_bw[iq_index]        ),  // low-pass shift
+      .set_gain_i    (  iq_gain[iq_index]      )   // output gain shift
+    );
+end
+endgenerate
 
 generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
     assign ext_reset[pid_index] = reset_i[ext_reset_source[pid_index]] && set_ext_reset_enabled[pid_index];
@@ -171,12 +247,12 @@ generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
       .dat_o        (  pid_out[pid_index]     ),  // output data
 
        // settings
-      .set_sp_i      (  set_sp[pid_index]      ),  // set point
-      .set_kp_i      (  set_kp[pid_index]      ),  // Kp
-      .set_ki_i      (  set_ki[pid_index]      ),  // Ki
-      .set_kd_i      (  set_kd[pid_index]      ),  // Kd
-      .set_kii_i     (  set_kii[pid_index]     ),  // Kii (second integrator gain)
-      .set_kg_i      (  set_kg[pid_index]      ),  // Kg (global gain)
+      .set_sp_i      (  act_sp[pid_index]      ),  // set point
+      .set_kp_i      (  act_kp[pid_index]      ),  // Kp
+      .set_ki_i      (  act_ki[pid_index]      ),  // Ki
+      .set_kd_i      (  act_kd[pid_index]      ),  // Kd
+      .set_kii_i     (  act_kii[pid_index]     ),  // Kii (second integrator gain)
+      .set_kg_i      (  act_kg[pid_index]      ),  // Kg (global gain)
       .inverted_i    (  pid_inverted[pid_index]),  // feedback sign
       .int_rst_i     (  pid_irst[pid_index]    ),   // integrator reset
       .int_ctr_rst_i (  pid_ctr_rst[pid_index] ),
@@ -200,13 +276,29 @@ generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
         .clear_o(relock_clear_o[pid_index]),
         .signal_o(relock_signal_o[pid_index])
     );
+
+    pid_lock_stats i_lock_stats (
+        .clk_i(clk_i),
+        .rstn_i(rstn_i),
+        .locked_i(relock_locked_o[pid_index]),
+        .time_i(lock_time),
+        .clear_i(lock_stats_clear[pid_index]),
+        .unlock_count_o(stats_unlocks[pid_index]),
+        .unlocked_time_o(stats_unlocked[pid_index]),
+        .longest_o(stats_longest[pid_index]),
+        .last_unlock_o(stats_unlock[pid_index]),
+        .last_relock_o(stats_relock[pid_index])
+    );
 end
 endgenerate
 
-assign pid_in[0] = dat_a_i;
-assign pid_in[1] = dat_b_i;
-assign pid_in[2] = dat_a_i;
-assign pid_in[3] = dat_b_i;
+// Error signal: input (0), I (1) or Q (2) of the demodulator of the input
+generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
+    assign pid_in[pid_index] = (pid_input_sel[pid_index] == 2'd1) ? iq_i[pid_index % 2] :
+                               (pid_input_sel[pid_index] == 2'd2) ? iq_q[pid_index % 2] :
+                                                                    adc_in[pid_index % 2];
+end
+endgenerate
 
 assign pid_irst[0] = set_irst[0] || ext_reset[0];
 assign pid_irst[1] = set_irst[1] || ext_reset[1];
@@ -255,6 +347,62 @@ assign lock_status_o[1] = relock_lock_status[1] && set_lock_status_out_en[1];
 assign lock_status_o[2] = relock_lock_status[2] && set_lock_status_out_en[2];
 assign lock_status_o[3] = relock_lock_status[3] && set_lock_status_out_en[3];
 
+// Timestamps of the lock statistics
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0)
+      lock_time <= 64'd0;
+   else
+      lock_time <= lock_time + 64'd1;
+end
+
+// A write to 0x0C copies the statistics of all PIDs, so that the values read
+// afterwards belong together, and clears the statistics of the selected PIDs
+always @(posedge clk_i) begin
+   if (rstn_i == 1'b0)
+      lock_stats_clear <= 4'b0;
+   else
+      lock_stats_clear <= (sys_wen && sys_addr[19:0]==20'hc) ? sys_wdata[4-1:0] : 4'b0;
+end
+
+generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
+    always @(posedge clk_i) begin
+       if (sys_wen && sys_addr[19:0]==20'hc) begin
+          snap_unlocks[pid_index]  <= stats_unlocks[pid_index];
+          snap_unlocked[pid_index] <= stats_unlocked[pid_index];
+          snap_longest[pid_index]  <= stats_longest[pid_index];
+          snap_unlock[pid_index]   <= stats_unlock[pid_index];
+          snap_relock[pid_index]   <= stats_relock[pid_index];
+       end
+    end
+end
+endgenerate
+
+always @(posedge clk_i) begin
+   if (sys_wen && sys_addr[19:0]==20'hc) begin
+      snap_locked <= relock_lock_status;
+      snap_time   <= lock_time;
+   end
+end
+
+// Statistics of PID sys_addr[7:6] at 0x100 + 0x40*pid
+always @(*) begin
+   case (sys_addr[5:2])
+      4'h0: lock_stats_rdata = snap_unlocks[sys_addr[7:6]];
+      4'h1: lock_stats_rdata = {{32-1{1'b0}}, snap_locked[sys_addr[7:6]]};
+      4'h2: lock_stats_rdata = snap_unlocked[sys_addr[7:6]][32-1:0];
+      4'h3: lock_stats_rdata = snap_unlocked[sys_addr[7:6]][64-1:32];
+      4'h4: lock_stats_rdata = snap_longest[sys_addr[7:6]][32-1:0];
+      4'h5: lock_stats_rdata = snap_longest[sys_addr[7:6]][64-1:32];
+      4'h6: lock_stats_rdata = snap_unlock[sys_addr[7:6]][32-1:0];
+      4'h7: lock_stats_rdata = snap_unlock[sys_addr[7:6]][64-1:32];
+      4'h8: lock_stats_rdata = snap_relock[sys_addr[7:6]][32-1:0];
+      4'h9: lock_stats_rdata = snap_relock[sys_addr[7:6]][64-1:32];
+      4'ha: lock_stats_rdata = snap_time[32-1:0];
+      4'hb: lock_stats_rdata = snap_time[64-1:32];
+      default: lock_stats_rdata = 32'h0;
+   endcase
+end
+
 //---------------------------------------------------------------------------------
 //  Sum and saturation
 
@@ -327,6 +475,7 @@ generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
           relock_stepsize[pid_index] <= {RELOCK_STEP_BITS{1'b0}};
           relock_source[pid_index]   <= 2'd0;
           ext_reset_source[pid_index]<= 2'd0;
+          pid_input_sel[pid_index]   <= 2'd0;
        end
        else begin
           if (sys_wen) begin
@@ -352,16 +501,70 @@ generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
                  set_kg[pid_index] <= sys_wdata[KP_BITS-1:0];
              if (sys_addr[19:0]==('hb0+4*pid_index))
                  ext_reset_source[pid_index]  <= sys_wdata[2-1:0] ;
+             if (sys_addr[19:0]==('hc0+4*pid_index))
+                 pid_input_sel[pid_index]  <= sys_wdata[2-1:0] ;
+          end
+       end
+    end
+end
+endgenerate
+
+// IQ demodulator parameters write
+generate for (iq_index = 0; iq_index < 2; iq_index = iq_index + 1) begin
+    always @(posedge clk_i) begin
+       if (rstn_i == 1'b0) begin
+          iq_freq[iq_index]  <= 32'd0;
+          iq_phase[iq_index] <= 32'd0;
+          iq_bw[iq_index]    <= {IQ_BW_BITS{1'b0}};
+          iq_gain[iq_index]  <= 4'd0;
+          iq_ref[iq_index]   <= 2'd0;
+       end
+       else begin
+          if (sys_wen) begin
+             if (sys_addr[19:0]==('hd0+4*iq_index))
+                 iq_freq[iq_index]  <= sys_wdata;
+             if (sys_addr[19:0]==('hd8+4*iq_index))
+                 iq_phase[iq_index] <= sys_wdata;
+             if (sys_addr[19:0]==('he0+4*iq_index))
+                 {iq_ref[iq_index], iq_gain[iq_index], iq_bw[iq_index]}
+                 <= {sys_wdata[18-1:16], sys_wdata[12-1:8], sys_wdata[IQ_BW_BITS-1:0]};
           end
        end
     end
 end
 endgenerate
 
+// Setpoint and gains used by the PID blocks. They follow the bus registers,
+// except while the update hold bit of the PID is set: then the written values
+// are kept back and all of them take effect in the clock cycle after the bit
+// is cleared again.
+generate for (pid_index = 0; pid_index < 4; pid_index = pid_index + 1) begin
+    always @(posedge clk_i) begin
+       if (rstn_i == 1'b0) begin
+          act_sp[pid_index]  <= 14'd0 ;
+          act_kp[pid_index]  <= {KP_BITS{1'b0}} ;
+          act_ki[pid_index]  <= {KI_BITS{1'b0}} ;
+          act_kd[pid_index]  <= {KD_BITS{1'b0}} ;
+          act_kii[pid_index] <= {KI_BITS{1'b0}} ;
+          act_kg[pid_index]  <= {KP_BITS{1'b0}} ;
+       end
+       else if (!set_update_hold[pid_index]) begin
+          act_sp[pid_index]  <= set_sp[pid_index] ;
+          act_kp[pid_index]  <= set_kp[pid_index] ;
+          act_ki[pid_index]  <= set_ki[pid_index] ;
+          act_kd[pid_index]  <= set_kd[pid_index] ;
+          act_kii[pid_index] <= set_kii[pid_index] ;
+          act_kg[pid_index]  <= set_kg[pid_index] ;
+       end
+    end
+end
+endgenerate
+
 // Flags write
 always @(posedge clk_i) begin
     if (rstn_i == 1'b0) begin
           set_ext_reset_enabled  <=  4'b0;
+          set_update_hold        <=  4'b0;
           set_lock_status_out_en <=  4'b1111;
           set_output_enabled     <=  4'b1111;
           relock_enabled         <=  4'b0   ;
@@ -385,6 +588,9 @@ always @(posedge clk_i) begin
         if (rstn_i & sys_wen & sys_addr[19:0]==20'h4)
             {set_ext_reset_enabled}
             <= sys_wdata[4-1:0];
+        if (rstn_i & sys_wen & sys_addr[19:0]==20'h8)
+            {set_update_hold}
+            <= sys_wdata[4-1:0];
     end
 end
 
@@ -408,6 +614,14 @@ end else begin
           sys_ack <= sys_en;
           sys_rdata <= {{32-28{1'b0}}, set_ext_reset_enabled};
       end
+       20'h08: begin
+          sys_ack <= sys_en;
+          sys_rdata <= {{32-4{1'b0}}, set_update_hold};
+      end
+       20'h0c: begin
+          sys_ack <= sys_en;
+          sys_rdata <= 32'h0;
+      end
 
       20'h1?: begin sys_ack <= sys_en; sys_rdata <= {{32-14{1'b0}}, set_sp[sys_addr[3:0] >> 2]}; end
       20'h2?: begin sys_ack <= sys_en; sys_rdata <= {{32-KP_BITS{1'b0}}, set_kp[sys_addr[3:0] >> 2]}; end
@@ -421,6 +635,16 @@ end else begin
       20'h9?: begin sys_ack <= sys_en; sys_rdata <= {{32-KI_BITS{1'b0}}, set_kii[sys_addr[3:0] >> 2]}; end
       20'ha?: begin sys_ack <= sys_en; sys_rdata <= {{32-KP_BITS{1'b0}}, set_kg[sys_addr[3:0] >> 2]}; end
       20'hb?: begin sys_ack <= sys_en; sys_rdata <= {{32-2{1'b0}}, ext_reset_source[sys_addr[3:0] >> 2]}; end
+      20'hc?: begin sys_ack <= sys_en; sys_rdata <= {{32-2{1'b0}}, pid_input_sel[sys_addr[3:0] >> 2]}; end
+
+      20'hd0: begin sys_ack <= sys_en; sys_rdata <= iq_freq[0]; end
+      20'hd4: begin sys_ack <= sys_en; sys_rdata <= iq_freq[1]; end
+      20'hd8: begin sys_ack <= sys_en; sys_rdata <= iq_phase[0]; end
+      20'hdc: begin sys_ack <= sys_en; sys_rdata <= iq_phase[1]; end
+      20'he0: begin sys_ack <= sys_en; sys_rdata <= {{32-18{1'b0}}, iq_ref[0], 4'h0, iq_gain[0], {8-IQ_BW_BITS{1'b0}}, iq_bw[0]}; end
+      20'he4: begin sys_ack <= sys_en; sys_rdata <= {{32-18{1'b0}}, iq_ref[1], 4'h0, iq_gain[1], {8-IQ_BW_BITS{1'b0}}, iq_bw[1]}; end
+
+      20'h1??: begin sys_ack <= sys_en; sys_rdata <= lock_stats_rdata; end
 
      default: begin sys_ack <= sys_en; sys_rdata <=  32'h0; end
    endcase
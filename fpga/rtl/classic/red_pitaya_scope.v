@@ -58,6 +58,7 @@ module red_pitaya_scope #(
    // trigger sources
    input                 trig_ext_i      ,  // external trigger
    input                 trig_asg_i      ,  // ASG trigger
+   output reg            trig_done_o     ,  // acquisition done (interrupt request)
 
    // AXI0 master
    output                axi0_clk_o      ,  // global clock
@@ -521,6 +522,7 @@ if (adc_rstn_i == 1'b0) begin
    adc_trig_sw   <= 1'b0 ;
    set_trig_src  <= 4'h0 ;
    adc_trig      <= 1'b0 ;
+   trig_done_o   <= 1'b0 ;
 end else begin
    adc_arm_do  <= sys_wen && (sys_addr[19:0]==20'h0) && sys_wdata[0] ; // SW ARM
    adc_rst_do  <= sys_wen && (sys_addr[19:0]==20'h0) && sys_wdata[1] ;
@@ -531,6 +533,13 @@ end else begin
       else if (((adc_dly_do || adc_trig) && (adc_dly_cnt == 32'h0)) || adc_rst_do) //delayed reached or reset
          set_trig_src <= 4'h0 ;
 
+      // Raised when the trigger source is reset by the end of an acquisition,
+      // held until the trigger source is written or the scope is armed/reset
+      if ((sys_wen && (sys_addr[19:0]==20'h4)) || adc_rst_do || adc_arm_do)
+         trig_done_o <= 1'b0 ;
+      else if ((adc_dly_do || adc_trig) && (adc_dly_cnt == 32'h0) && |set_trig_src)
+         trig_done_o <= 1'b1 ;
+
    case (set_trig_src)
        4'd1 : adc_trig <= adc_trig_sw   ; // manual
        4'd2 : adc_trig <= adc_trig_ap   ; // A ch rising edge
@@ -18,6 +18,7 @@
 
 #include "acquire.h"
 #include "common.h"
+#include "connection.h"
 
 #include "scpi/parser.h"
 #include "scpi/units.h"
@@ -331,6 +332,31 @@ scpi_result_t RP_AcqTriggerSrcQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+/*
+ * Blocks until the acquisition is done or the timeout (in ms) has elapsed and
+ * returns TD or WAIT, like ACQ:TRIG:STAT?.
+ */
+scpi_result_t RP_AcqTriggerWaitQ(scpi_t *context) {
+    uint32_t timeout;
+
+    if (!SCPI_ParamUInt32(context, &timeout, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:TRIG:WAIT? is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqWaitTrigger(timeout);
+    if (RP_OK != result && RP_ETMO != result) {
+        RP_LOG(LOG_ERR, "*ACQ:TRIG:WAIT? Failed to wait for trigger: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    // Return back result
+    SCPI_ResultMnemonic(context, (RP_OK == result) ? "TD" : "WAIT");
+
+    RP_LOG(LOG_INFO, "*ACQ:TRIG:WAIT? Successfully returned trigger.\n");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_AcqTriggerDelay(scpi_t *context) {
     int32_t triggerDelay;
 
@@ -615,6 +641,27 @@ scpi_result_t RP_AcqScpiDataUnitsQ(scpi_t *context){
     return SCPI_RES_OK;
 }
 
+/* Scratch buffer of the connection, large enough for a full acquisition buffer */
+static void *getDataBuffer(scpi_t *context) {
+    return ((connection_t *) context->user_context)->data;
+}
+
+/*
+ * Returns acquired samples in the selected units. In binary format the samples
+ * are sent as a definite length block of little endian float32 (VOLTS) or
+ * int16 (RAW) straight from the buffer.
+ */
+static void resultData(scpi_t *context, const void *buffer, uint32_t size) {
+    if (context->binary_output) {
+        size_t sample_size = (unit == RP_SCPI_VOLTS) ? sizeof(float) : sizeof(int16_t);
+        RP_ConnectionWriteBlock(context->user_context, buffer, size * sample_size);
+    } else if (unit == RP_SCPI_VOLTS) {
+        SCPI_ResultBufferFloat(context, buffer, size);
+    } else {
+        SCPI_ResultBufferInt16(context, buffer, size);
+    }
+}
+
 scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
     
     uint32_t start, end;
@@ -637,30 +684,26 @@ scpi_result_t RP_AcqDataPosQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size = end - start;
+    uint32_t size = ADC_BUFFER_SIZE;
+    void *buffer = getDataBuffer(context);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
         result = rp_AcqGetDataPosV(channel, start, end, buffer, &size);
         
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:STA:END? Failed to get data in volts: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-        
-        SCPI_ResultBufferFloat(context, buffer, size);
-
     }else{
-        int16_t buffer[size];
         result = rp_AcqGetDataPosRaw(channel, start, end, buffer, &size);
         
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:STA:END? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferInt16(context, buffer, size);
     }
 
+    resultData(context, buffer, size);
+
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA:STA:END? Successfully returned data to client.\n");
     return SCPI_RES_OK;
 }
@@ -688,31 +731,25 @@ scpi_result_t RP_AcqDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
-    uint32_t size_buff;
-    rp_AcqGetBufSize(&size_buff);
+    void *buffer = getDataBuffer(context);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size_buff - start];
         result = rp_AcqGetDataV(channel, start, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to get "
             "data in volts: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferFloat(context, buffer, size);
-
     }else{
-        int16_t buffer[size_buff - start];
         result = rp_AcqGetDataRaw(channel, start, &size, buffer);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:STA:N? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferInt16(context, buffer, size);
     }
 
+    resultData(context, buffer, size);
+
     RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DATA:STA:N? Successfully returned data.\n");
     return SCPI_RES_OK;
 }
@@ -729,28 +766,24 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t *context) {
     }
     
     rp_AcqGetBufSize(&size);
+    void *buffer = getDataBuffer(context);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to get data in volt: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferFloat(context, buffer, size);
-
     }else{
-        int16_t buffer[size];
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferInt16(context, buffer, size);
     }
 
+    resultData(context, buffer, size);
+
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA? Successfully returned data.\n");
     return SCPI_RES_OK;
 }
@@ -771,8 +804,8 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
+    void *buffer = getDataBuffer(context);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
         result = rp_AcqGetOldestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
@@ -781,20 +814,16 @@ scpi_result_t RP_AcqOldestDataQ(scpi_t *context) {
 
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferFloat(context, buffer, size);
-
     }else{
-        int16_t buffer[size];
         result = rp_AcqGetOldestDataRaw(channel, &size, buffer);
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR#:DATA:OLD:N? Failed to get raw data: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferInt16(context, buffer, size);
     }
 
+    resultData(context, buffer, size);
+
     RP_LOG(LOG_INFO, "*ACQ:SOUR#:DATA:OLD:N? Successfully returned data to client.");
     return SCPI_RES_OK;
 }
@@ -815,8 +844,8 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
         return SCPI_RES_ERR;
     }
 
+    void *buffer = getDataBuffer(context);
     if(unit == RP_SCPI_VOLTS){
-        float buffer[size];
         result = rp_AcqGetLatestDataV(channel, &size, buffer);
 
         if(result != RP_OK){
@@ -824,20 +853,18 @@ scpi_result_t RP_AcqLatestDataQ(scpi_t *context) {
                 " get data in volt: %s\n", rp_GetError(result));
             return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferFloat(context, buffer, size);
     }else{
-        int16_t buffer[size];
         result = rp_AcqGetLatestDataRaw(channel, &size, buffer);
 
         if(result != RP_OK){
             RP_LOG(LOG_ERR, "*ACQ:SOUR<n>:DATA:LAT:N? Failed to "
                 "get raw data: %s\n", rp_GetError(result));
+            return SCPI_RES_ERR;
         }
-
-        SCPI_ResultBufferInt16(context, buffer, size);
     }
 
+    resultData(context, buffer, size);
+
     RP_LOG(LOG_INFO, "*ACQ:SOUR<n>:DATA:LAT:N? Successfully returned data to client.\n");
     return SCPI_RES_OK;
 }
@@ -856,3 +883,164 @@ scpi_result_t RP_AcqBufferSizeQ(scpi_t *context) {
     RP_LOG(LOG_INFO, "*ACQ:BUF:SIZE?? Successfully returned buffer size.\n");
     return SCPI_RES_OK;
 }
+
+scpi_result_t RP_AcqStream(scpi_t *context) {
+
+    rp_channel_t channel;
+    scpi_bool_t value;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if (!SCPI_ParamBool(context, &value, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:STREAM is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqAxiEnable(channel, value);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:STREAM Failed to set streaming: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR#:STREAM Successfully set streaming.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqStreamQ(scpi_t *context) {
+
+    rp_channel_t channel;
+    bool value;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_AcqAxiIsEnabled(channel, &value);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:STREAM? Failed to get streaming: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, value ? "ON" : "OFF");
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR#:STREAM? Successfully returned streaming.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqPsdStart(scpi_t *context) {
+
+    rp_channel_t channel;
+    uint32_t segment_length, averages;
+    float overlap;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if (!SCPI_ParamUInt32(context, &segment_length, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:PSD:START is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamFloat(context, &overlap, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:PSD:START is missing second parameter.\n");
+        return SCPI_RES_ERR;
+    }
+    if (!SCPI_ParamUInt32(context, &averages, true)) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:PSD:START is missing third parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_PsdStart(channel, segment_length, overlap, averages);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:SOUR#:PSD:START Failed to start noise spectral density: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:SOUR#:PSD:START Successfully started noise spectral density.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqPsdStop(scpi_t *context) {
+    int result = rp_PsdStop();
+
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:PSD:STOP Failed to stop noise spectral density: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:PSD:STOP Successfully stopped noise spectral density.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqPsdStateQ(scpi_t *context) {
+    bool running;
+    int result = rp_PsdIsRunning(&running);
+
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:PSD:STAT? Failed to get noise spectral density state: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, running ? "ON" : "OFF");
+
+    RP_LOG(LOG_INFO, "*ACQ:PSD:STAT? Successfully returned noise spectral density state.\n");
+    return SCPI_RES_OK;
+}
+
+/*
+ * Returns the last averaged spectrum in V/sqrt(Hz), as a definite length block of
+ * little endian float32 values in binary format.
+ */
+scpi_result_t RP_AcqPsdDataQ(scpi_t *context) {
+    uint32_t size = PSD_MAX_BINS;
+    float *buffer = getDataBuffer(context);
+
+    int result = rp_PsdGetSpectrum(buffer, &size, NULL, NULL);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:PSD:DATA? Failed to get noise spectral density: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    if (context->binary_output) {
+        RP_ConnectionWriteBlock(context->user_context, buffer, size * sizeof(float));
+    } else {
+        SCPI_ResultBufferFloat(context, buffer, size);
+    }
+
+    RP_LOG(LOG_INFO, "*ACQ:PSD:DATA? Successfully returned noise spectral density.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqPsdBinWidthQ(scpi_t *context) {
+    uint32_t size = PSD_MAX_BINS;
+    float bin_width;
+
+    int result = rp_PsdGetSpectrum(getDataBuffer(context), &size, &bin_width, NULL);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:PSD:BINW? Failed to get bin width: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultFloat(context, bin_width);
+
+    RP_LOG(LOG_INFO, "*ACQ:PSD:BINW? Successfully returned bin width.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_AcqPsdCountQ(scpi_t *context) {
+    uint32_t size = PSD_MAX_BINS;
+    uint32_t count;
+
+    int result = rp_PsdGetSpectrum(getDataBuffer(context), &size, NULL, &count);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*ACQ:PSD:COUNT? Failed to get spectrum count: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultUInt32Base(context, count, 10);
+
+    RP_LOG(LOG_INFO, "*ACQ:PSD:COUNT? Successfully returned spectrum count.\n");
+    return SCPI_RES_OK;
+}
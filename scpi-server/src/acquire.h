@@ -36,6 +36,7 @@ scpi_result_t RP_AcqAveraging(scpi_t * context);
 scpi_result_t RP_AcqAveragingQ(scpi_t * context);
 scpi_result_t RP_AcqTriggerSrc(scpi_t * context);
 scpi_result_t RP_AcqTriggerSrcQ(scpi_t *context);
+scpi_result_t RP_AcqTriggerWaitQ(scpi_t *context);
 scpi_result_t RP_AcqTriggerDelay(scpi_t * context);
 scpi_result_t RP_AcqTriggerDelayQ(scpi_t * context);
 scpi_result_t RP_AcqTriggerDelayNs(scpi_t * context);
@@ -57,6 +58,14 @@ scpi_result_t RP_AcqDataOldestAllQ(scpi_t * context);
 scpi_result_t RP_AcqOldestDataQ(scpi_t *context);
 scpi_result_t RP_AcqLatestDataQ(scpi_t *context);
 scpi_result_t RP_AcqBufferSizeQ(scpi_t * context);
+scpi_result_t RP_AcqStream(scpi_t *context);
+scpi_result_t RP_AcqStreamQ(scpi_t *context);
+scpi_result_t RP_AcqPsdStart(scpi_t *context);
+scpi_result_t RP_AcqPsdStop(scpi_t *context);
+scpi_result_t RP_AcqPsdStateQ(scpi_t *context);
+scpi_result_t RP_AcqPsdDataQ(scpi_t *context);
+scpi_result_t RP_AcqPsdBinWidthQ(scpi_t *context);
+scpi_result_t RP_AcqPsdCountQ(scpi_t *context);
 
 scpi_result_t RP_AcqGetLatestData(rp_channel_t channel, scpi_t * context);
 
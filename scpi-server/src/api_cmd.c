@@ -25,14 +25,8 @@
 
 scpi_result_t RP_InitAll(scpi_t *context){
 
-    int result = rp_Init();
-
-    if(result != RP_OK){
-        RP_LOG(LOG_ERR, "*RP:INIT Failed to initialize Red "
-            "Pitaya modules: %s\n", rp_GetError(result));
-        return SCPI_RES_ERR;
-    }
-
+    // The library is initialized once by the server and shared by all
+    // connections; there is nothing left to do per client.
     RP_LOG(LOG_INFO, "*RP:INIT Successfully inizitalized Red Pitaya modules.\n");
     return SCPI_RES_OK;
 }
@@ -53,14 +47,8 @@ scpi_result_t RP_ResetAll(scpi_t *context){
 
 scpi_result_t RP_ReleaseAll(scpi_t *context){
 
-    int result = rp_Release();
-
-    if(result != RP_OK){
-        RP_LOG(LOG_ERR, "*RP:RELEASE Failed to release Red "
-            "Pitaya modules: %s\n", rp_GetError(result));
-        return SCPI_RES_ERR;
-    }
-
+    // Other connections still use the library, it is released when the
+    // server stops.
     RP_LOG(LOG_INFO, "*RP:RELEASE Successfully released Red Pitaya modules.\n");
     return SCPI_RES_OK;
 }
@@ -0,0 +1,129 @@
+/**
+ * @brief Red Pitaya transfer function analyzer SCPI commands implementation
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bode.h"
+#include "common.h"
+#include "connection.h"
+
+#include "scpi/parser.h"
+
+#include "redpitaya/lockbox.h"
+
+// Values returned by BODE:DATA? for each point
+#define BODE_VALUES     5
+
+scpi_result_t RP_BodeStart(scpi_t *context) {
+
+    rp_channel_t channel;
+    float amplitude, start_frequency, stop_frequency, settle_time;
+    uint32_t points, cycles;
+
+    if (RP_ParseChArgv(context, &channel) != RP_OK){
+        return SCPI_RES_ERR;
+    }
+
+    if (!SCPI_ParamFloat(context, &amplitude, true)
+            || !SCPI_ParamFloat(context, &start_frequency, true)
+            || !SCPI_ParamFloat(context, &stop_frequency, true)
+            || !SCPI_ParamUInt32(context, &points, true)
+            || !SCPI_ParamFloat(context, &settle_time, true)
+            || !SCPI_ParamUInt32(context, &cycles, true)) {
+        RP_LOG(LOG_ERR, "*SOUR#:BODE:START is missing parameters.\n");
+        return SCPI_RES_ERR;
+    }
+
+    int result = rp_BodeStart(channel, amplitude, start_frequency, stop_frequency, points, settle_time, cycles);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*SOUR#:BODE:START Failed to start transfer function measurement: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*SOUR#:BODE:START Successfully started transfer function measurement.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_BodeStop(scpi_t *context) {
+    int result = rp_BodeStop();
+
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*BODE:STOP Failed to stop transfer function measurement: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*BODE:STOP Successfully stopped transfer function measurement.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_BodeStateQ(scpi_t *context) {
+    bool running;
+    int result = rp_BodeIsRunning(&running);
+
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*BODE:STAT? Failed to get transfer function measurement state: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, running ? "ON" : "OFF");
+
+    RP_LOG(LOG_INFO, "*BODE:STAT? Successfully returned transfer function measurement state.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_BodeCountQ(scpi_t *context) {
+    rp_bode_point_t *points = ((connection_t *) context->user_context)->data;
+    uint32_t size = BODE_MAX_POINTS;
+
+    int result = rp_BodeGetData(points, &size);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*BODE:COUNT? Failed to get number of measured points: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultUInt32Base(context, size, 10);
+
+    RP_LOG(LOG_INFO, "*BODE:COUNT? Successfully returned number of measured points.\n");
+    return SCPI_RES_OK;
+}
+
+/*
+ * Returns frequency, amplitude of input A, amplitude of input B, magnitude and
+ * phase of each measured point. In binary format the values are sent as a
+ * definite length block of little endian float32.
+ */
+scpi_result_t RP_BodeDataQ(scpi_t *context) {
+    rp_bode_point_t *points = ((connection_t *) context->user_context)->data;
+    float *values = (float *) &points[BODE_MAX_POINTS];
+    uint32_t size = BODE_MAX_POINTS;
+
+    int result = rp_BodeGetData(points, &size);
+    if (RP_OK != result) {
+        RP_LOG(LOG_ERR, "*BODE:DATA? Failed to get transfer function: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    for (uint32_t i = 0; i < size; i++) {
+        values[BODE_VALUES * i + 0] = points[i].frequency;
+        values[BODE_VALUES * i + 1] = points[i].amplitude[RP_CH_1];
+        values[BODE_VALUES * i + 2] = points[i].amplitude[RP_CH_2];
+        values[BODE_VALUES * i + 3] = points[i].magnitude;
+        values[BODE_VALUES * i + 4] = points[i].phase;
+    }
+
+    if (context->binary_output) {
+        RP_ConnectionWriteBlock(context->user_context, values, BODE_VALUES * size * sizeof(float));
+    } else {
+        SCPI_ResultBufferFloat(context, values, BODE_VALUES * size);
+    }
+
+    RP_LOG(LOG_INFO, "*BODE:DATA? Successfully returned transfer function.\n");
+    return SCPI_RES_OK;
+}
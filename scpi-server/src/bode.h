@@ -0,0 +1,20 @@
+/**
+ * @brief Red Pitaya transfer function analyzer SCPI commands interface
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef BODE_H_
+#define BODE_H_
+
+#include "scpi/types.h"
+
+scpi_result_t RP_BodeStart(scpi_t *context);
+scpi_result_t RP_BodeStop(scpi_t *context);
+scpi_result_t RP_BodeStateQ(scpi_t *context);
+scpi_result_t RP_BodeCountQ(scpi_t *context);
+scpi_result_t RP_BodeDataQ(scpi_t *context);
+
+#endif /* BODE_H_ */
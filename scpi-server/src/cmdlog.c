@@ -0,0 +1,66 @@
+/**
+ * @brief Red Pitaya Scpi server command ring log implementation
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#include "cmdlog.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+
+typedef struct {
+    struct timespec time;
+    int fd;
+    char text[CMDLOG_TEXT_LEN];
+} cmdlog_entry_t;
+
+static cmdlog_entry_t cmdlog[CMDLOG_ENTRIES];
+static uint32_t cmdlog_next = 0;
+
+
+/**
+ * Records a command. Only the first CMDLOG_TEXT_LEN - 1 characters are kept
+ * and the delimiter is dropped.
+ * @param fd   Socket of the connection the command was received on
+ * @param cmd  Command text, not null terminated
+ * @param len  Length of the command text
+ */
+void RP_CmdLogAdd(int fd, const char *cmd, size_t len)
+{
+    cmdlog_entry_t *entry = &cmdlog[cmdlog_next++ % CMDLOG_ENTRIES];
+
+    while (len > 0 && (cmd[len - 1] == '\n' || cmd[len - 1] == '\r')) {
+        len--;
+    }
+    len = MIN(len, CMDLOG_TEXT_LEN - 1);
+
+    clock_gettime(CLOCK_REALTIME, &entry->time);
+    entry->fd = fd;
+    memcpy(entry->text, cmd, len);
+    entry->text[len] = '\0';
+}
+
+/**
+ * Writes the recorded commands to syslog, oldest first.
+ */
+void RP_CmdLogDump()
+{
+    uint32_t count = MIN(cmdlog_next, CMDLOG_ENTRIES);
+
+    syslog(LOG_INFO, "Last %u commands:", count);
+    for (uint32_t i = cmdlog_next - count; i != cmdlog_next; i++) {
+        cmdlog_entry_t *entry = &cmdlog[i % CMDLOG_ENTRIES];
+        struct tm tm;
+        char stamp[16];
+        localtime_r(&entry->time.tv_sec, &tm);
+        strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm);
+        syslog(LOG_INFO, "%s.%06ld fd %d: %s", stamp, entry->time.tv_nsec / 1000, entry->fd, entry->text);
+    }
+}
@@ -0,0 +1,23 @@
+/**
+ * @brief Red Pitaya Scpi server command ring log interface
+ *
+ * Keeps the most recent commands of all connections in memory instead of
+ * sending each one to syslog. The log is written to syslog on request.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef CMDLOG_H_
+#define CMDLOG_H_
+
+#include <stddef.h>
+
+#define CMDLOG_ENTRIES      256     // Number of commands kept, power of 2
+#define CMDLOG_TEXT_LEN     56      // Characters kept per command
+
+void RP_CmdLogAdd(int fd, const char *cmd, size_t len);
+void RP_CmdLogDump();
+
+#endif /* CMDLOG_H_ */
@@ -0,0 +1,246 @@
+/**
+ * @brief Red Pitaya Scpi server client connection implementation
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "connection.h"
+#include "scpi-commands.h"
+#include "common.h"
+#include "cmdlog.h"
+
+#include "scpi/parser.h"
+
+static char delimiter[] = "\r\n";
+
+
+/**
+ * Helper method which returns next command position from the buffer.
+ * @param buffer     Input buffer
+ * @param bufferLen  Input buffer length
+ * @param from       Number of bytes already known not to contain a delimiter
+ * @return Position of next command within buffer, or -1 if not found.
+ */
+static size_t getNextCommand(const char* buffer, size_t bufferLen, size_t from)
+{
+    // Delimiter is "\r\n": look for the last character and check the one before
+    const char *end = buffer + bufferLen;
+    const char *p = buffer + (from > 0 ? from - 1 : 0);
+
+    while (p < end && (p = memchr(p, delimiter[1], end - p)) != NULL) {
+        if (p > buffer && p[-1] == delimiter[0]) {
+            return p - buffer + 1; // Position of next command
+        }
+        p++;
+    }
+
+    // No match found
+    return -1;
+}
+
+/* Makes sure at least 'extra' bytes are free after 'len' */
+static int reserve(char **buffer, size_t *size, size_t len, size_t extra)
+{
+    if (len + extra <= *size) {
+        return 0;
+    }
+
+    size_t new_size = *size ? *size : CONNECTION_READ_SIZE;
+    while (len + extra > new_size) {
+        new_size *= 2;
+    }
+    char *new_buffer = realloc(*buffer, new_size);
+    if (new_buffer == NULL) {
+        return -1;
+    }
+    *buffer = new_buffer;
+    *size = new_size;
+    return 0;
+}
+
+connection_t *RP_ConnectionNew(int fd, const struct sockaddr_in *addr)
+{
+    connection_t *conn = calloc(1, sizeof(connection_t));
+    if (conn == NULL) {
+        return NULL;
+    }
+
+    if (posix_memalign(&conn->data, sysconf(_SC_PAGESIZE), CONNECTION_DATA_SIZE) != 0) {
+        free(conn);
+        return NULL;
+    }
+
+    conn->fd = fd;
+    inet_ntop(AF_INET, &addr->sin_addr, conn->address, sizeof(conn->address));
+
+    if (RP_ScpiContextInit(&conn->context, conn) != 0) {
+        free(conn->data);
+        free(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+void RP_ConnectionFree(connection_t *conn)
+{
+    RP_ScpiContextRelease(&conn->context);
+    free(conn->input);
+    free(conn->output);
+    free(conn->data);
+    free(conn);
+}
+
+/**
+ * Receives all available bytes and executes every complete command. The
+ * responses are only queued; the caller sends them together afterwards.
+ * @return 0 on success, -1 if the connection was closed or failed.
+ */
+int RP_ConnectionRead(connection_t *conn)
+{
+    size_t received = 0;
+
+    // Drain the socket, but leave other connections a chance after a large burst
+    while (received < CONNECTION_BATCH_SIZE) {
+        if (reserve(&conn->input, &conn->input_size, conn->input_len, CONNECTION_READ_SIZE) != 0) {
+            return -1;
+        }
+
+        ssize_t read_size = recv(conn->fd, conn->input + conn->input_len,
+                                 conn->input_size - conn->input_len, 0);
+        if (read_size == 0) {
+            RP_LOG(LOG_INFO, "Client is disconnected");
+            return -1;
+        }
+        if (read_size < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            RP_LOG(LOG_ERR, "Receive message failed (%s)", strerror(errno));
+            return -1;
+        }
+        conn->input_len += read_size;
+        received += read_size;
+    }
+
+    // Now parse each command out in one pass
+    char *m = conn->input;
+    size_t pos = -1;
+    while ((pos = getNextCommand(m, conn->input_len, conn->input_scanned)) != -1) {
+
+        RP_CmdLogAdd(conn->fd, m, pos);
+
+        //Parse the message and queue the response
+        SCPI_Input(&conn->context, m, pos);
+        m += pos;
+        conn->input_len -= pos;
+        conn->input_scanned = 0;
+    }
+    conn->input_scanned = conn->input_len;
+
+    // Move the rest of the message to the beginning of the buffer
+    if (conn->input != m && conn->input_len > 0) {
+        memmove(conn->input, m, conn->input_len);
+    }
+    return 0;
+}
+
+/**
+ * Sends as much of the queued output as the socket accepts.
+ * @return 0 on success, -1 if the connection failed.
+ */
+int RP_ConnectionFlush(connection_t *conn)
+{
+    while (conn->output_pos < conn->output_len) {
+        ssize_t sent = send(conn->fd, conn->output + conn->output_pos,
+                            conn->output_len - conn->output_pos, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            RP_LOG(LOG_ERR, "Failed to write into the socket (%s)", strerror(errno));
+            return -1;
+        }
+        conn->output_pos += sent;
+    }
+
+    conn->output_pos = conn->output_len = 0;
+    return 0;
+}
+
+bool RP_ConnectionPending(const connection_t *conn)
+{
+    return conn->output_pos < conn->output_len;
+}
+
+size_t RP_ConnectionWrite(connection_t *conn, const char *data, size_t len)
+{
+    if (reserve(&conn->output, &conn->output_size, conn->output_len, len) != 0) {
+        syslog(LOG_ERR, "Failed to queue %zu bytes of response", len);
+        return 0;
+    }
+    memcpy(conn->output + conn->output_len, data, len);
+    conn->output_len += len;
+    return len;
+}
+
+/**
+ * Writes an IEEE-488.2 definite length block (#<n><length><data>) followed by
+ * the response terminator. If nothing else is queued, the block is handed to
+ * the socket directly from 'data'; only what the socket does not accept is
+ * copied into the output queue.
+ * @return Number of bytes written or queued.
+ */
+size_t RP_ConnectionWriteBlock(connection_t *conn, const void *data, size_t len)
+{
+    char length[24];
+    char header[32];
+    snprintf(length, sizeof(length), "%zu", len);
+    int header_len = snprintf(header, sizeof(header), "#%zu%s", strlen(length), length);
+
+    struct iovec iov[3] = {
+        { .iov_base = header, .iov_len = header_len },
+        { .iov_base = (void *) data, .iov_len = len },
+        { .iov_base = delimiter, .iov_len = sizeof(delimiter) - 1 },
+    };
+    size_t total = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+
+    ssize_t sent = 0;
+    if (!RP_ConnectionPending(conn)) {
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 3 };
+        sent = sendmsg(conn->fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            // Errors are reported by the next flush
+            sent = 0;
+        }
+    }
+
+    // Queue the rest
+    for (int i = 0; i < 3; i++) {
+        if ((size_t) sent >= iov[i].iov_len) {
+            sent -= iov[i].iov_len;
+            continue;
+        }
+        if (RP_ConnectionWrite(conn, (char *) iov[i].iov_base + sent, iov[i].iov_len - sent) == 0) {
+            return 0;
+        }
+        sent = 0;
+    }
+    return total;
+}
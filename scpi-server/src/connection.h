@@ -0,0 +1,54 @@
+/**
+ * @brief Red Pitaya Scpi server client connection interface
+ *
+ * Every client connection has its own SCPI context, input buffer and output
+ * buffer. Responses are queued in the output buffer and sent by the event
+ * loop when the socket is writable, so a slow client never blocks the others.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef CONNECTION_H_
+#define CONNECTION_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+
+#include "scpi/types.h"
+#include "redpitaya/lockbox.h"
+
+#define CONNECTION_READ_SIZE    16384       // Minimum free space per recv()
+#define CONNECTION_BATCH_SIZE   (1024 * 1024) // Maximum bytes received per readiness event
+#define CONNECTION_DATA_SIZE    (ADC_BUFFER_SIZE * sizeof(float))
+
+typedef struct connection_s {
+    int fd;
+    char address[INET_ADDRSTRLEN];
+    scpi_t context;
+
+    char *input;                // Received bytes not yet parsed
+    size_t input_len;
+    size_t input_size;
+    size_t input_scanned;       // Bytes of input already searched for a delimiter
+
+    char *output;               // Queued response bytes
+    size_t output_pos;          // First byte not yet sent
+    size_t output_len;
+    size_t output_size;
+
+    void *data;                 // Page aligned scratch buffer for bulk query results
+} connection_t;
+
+connection_t *RP_ConnectionNew(int fd, const struct sockaddr_in *addr);
+void RP_ConnectionFree(connection_t *conn);
+
+int RP_ConnectionRead(connection_t *conn);
+int RP_ConnectionFlush(connection_t *conn);
+bool RP_ConnectionPending(const connection_t *conn);
+size_t RP_ConnectionWrite(connection_t *conn, const char *data, size_t len);
+size_t RP_ConnectionWriteBlock(connection_t *conn, const void *data, size_t len);
+
+#endif /* CONNECTION_H_ */
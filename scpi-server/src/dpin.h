@@ -16,6 +16,10 @@
 #ifndef DPIN_H_
 #define DPIN_H_
 
+#include "scpi/types.h"
+
+extern const scpi_choice_def_t scpi_RpDpin[];
+
 scpi_result_t RP_DigitalPinReset(scpi_t * context);
 scpi_result_t RP_DigitalPinStateQ(scpi_t * context);
 scpi_result_t RP_DigitalPinState(scpi_t * context);
@@ -18,6 +18,8 @@
 
 #include "scpi/types.h"
 
+extern const scpi_choice_def_t scpi_RpWForm[];
+
 scpi_result_t RP_GenState(scpi_t * context);
 scpi_result_t RP_GenStateQ(scpi_t * context);
 scpi_result_t RP_GenReset(scpi_t * context);
@@ -12,6 +12,8 @@
 #include <math.h>
 
 #include "pid.h"
+#include "dpin.h"
+#include "generate.h"
 #include "../../api/src/pid.h"
 
 #include "common.h"
@@ -36,6 +38,64 @@ scpi_result_t RP_LoadLockboxConfig(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+/* Parse preset name from SCPI command */
+static bool RP_ParsePresetName(scpi_t *context, char *name) {
+    const char *param;
+    size_t param_len;
+
+    if (!SCPI_ParamCharacters(context, &param, &param_len, true)) {
+        return false;
+    }
+    if (param_len >= PRESET_NAME_LEN) {
+        return false;
+    }
+    memcpy(name, param, param_len);
+    name[param_len] = '\0';
+    return true;
+}
+
+scpi_result_t RP_PresetStore(scpi_t *context) {
+    char name[PRESET_NAME_LEN];
+    if (!RP_ParsePresetName(context, name)) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:STORe is missing a valid preset name.\n");
+        return SCPI_RES_ERR;
+    }
+    int result = rp_PresetStore(name);
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:STORe Failed to store preset: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PresetApply(scpi_t *context) {
+    char name[PRESET_NAME_LEN];
+    if (!RP_ParsePresetName(context, name)) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:APPLy is missing a valid preset name.\n");
+        return SCPI_RES_ERR;
+    }
+    int result = rp_PresetApply(name);
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:APPLy Failed to apply preset: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PresetDelete(scpi_t *context) {
+    char name[PRESET_NAME_LEN];
+    if (!RP_ParsePresetName(context, name)) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:DELete is missing a valid preset name.\n");
+        return SCPI_RES_ERR;
+    }
+    int result = rp_PresetDelete(name);
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "*LOCKbox:PRESet:DELete Failed to delete preset: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
 /* Parse pid index from SCPI command */
 static int RP_ParsePIDArgv(scpi_t *context, rp_pid_t *pid) {
     int32_t inout[2]; // First int: input index (1-2), second int: output index (1-2)
@@ -373,6 +433,73 @@ scpi_result_t RP_PIDKdQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t RP_PIDParams(scpi_t *context) {
+    int result;
+    scpi_number_t values[6];
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:PARams Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* Parse parameters (setpoint, Kp, Ki, Kd, Kii, Kg) */
+    for(int i = 0; i < 6; i++) {
+        if(!SCPI_ParamNumber(context, scpi_special_numbers_def, &values[i], true)) {
+            RP_LOG(LOG_ERR, "*PID:IN#:OUT#:PARams Failed to parse parameter %d.\n", i + 1);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    rp_pid_params_t params = {
+        .setpoint = values[0].value,
+        .kp = values[1].value,
+        .ki = values[2].value,
+        .kd = values[3].value,
+        .kii = values[4].value,
+        .kg = values[5].value,
+    };
+    result = rp_PIDSetParams(pid, &params);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:PARams Failed to set parameters: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:PARams Successfully set parameters.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDParamsQ(scpi_t *context) {
+    int result;
+    rp_pid_params_t params;
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:PARams? Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetParams(pid, &params);
+    if(result != RP_OK){
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:PARams? Failed to get parameters: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, params.setpoint);
+    SCPI_ResultDouble(context, params.kp);
+    SCPI_ResultDouble(context, params.ki);
+    SCPI_ResultDouble(context, params.kd);
+    SCPI_ResultDouble(context, params.kii);
+    SCPI_ResultDouble(context, params.kg);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:PARams? Successfully returned parameters to client.\n");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_PIDIntReset(scpi_t *context) {
     int result;
     scpi_bool_t enable;
@@ -636,6 +763,61 @@ scpi_result_t RP_PIDRelockQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+/*
+ * Returns the lock status, number of unlocks, total unlocked time, longest
+ * outage and the timestamps of the last unlock, last relock and the reading.
+ */
+scpi_result_t RP_PIDLockStatsQ(scpi_t *context) {
+    int result;
+    rp_pid_lock_stats_t stats;
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:LOCK:STATistics? Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetLockStats(pid, &stats);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:LOCK:STATistics? Failed to get lock statistics: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, stats.locked);
+    SCPI_ResultUInt32Base(context, stats.unlock_count, 10);
+    SCPI_ResultDouble(context, stats.unlocked_time);
+    SCPI_ResultDouble(context, stats.longest_outage);
+    SCPI_ResultDouble(context, stats.last_unlock);
+    SCPI_ResultDouble(context, stats.last_relock);
+    SCPI_ResultDouble(context, stats.timestamp);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:LOCK:STATistics? Successfully returned lock statistics.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDLockStatsReset(scpi_t *context) {
+    int result;
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:LOCK:STATistics:RESet Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDResetLockStats(pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:LOCK:STATistics:RESet Failed to reset lock statistics: %s", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:LOCK:STATistics:RESet Successfully reset lock statistics.\n");
+    return SCPI_RES_OK;
+}
+
 scpi_result_t RP_PIDRelockStepsize(scpi_t *context) {
     int result;
     scpi_number_t stepsize;
@@ -859,3 +1041,396 @@ scpi_result_t RP_PIDRelockInputQ(scpi_t *context) {
     RP_LOG(LOG_INFO, "*PID:IN#:OUT#:RELock:INPut? Successfully returned input pin value to client.\n");
     return SCPI_RES_OK;
 }
+
+/* Error signal choice def */
+const scpi_choice_def_t scpi_RpPidInput[] = {
+    {"DIRECT", 0},  //!< Input of the PID
+    {"I",      1},  //!< In-phase output of the IQ demodulator
+    {"Q",      2},  //!< Quadrature output of the IQ demodulator
+    SCPI_CHOICE_LIST_END
+};
+
+/* IQ demodulator reference choice def */
+const scpi_choice_def_t scpi_RpIQRef[] = {
+    {"NCO",  0},  //!< Internal oscillator
+    {"GEN1", 1},  //!< Phase of signal generator A
+    {"GEN2", 2},  //!< Phase of signal generator B
+    SCPI_CHOICE_LIST_END
+};
+
+scpi_result_t RP_PIDInput(scpi_t *context) {
+    int result;
+    int32_t choice;
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:ERRor Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    /* Read first parameter - error signal */
+    if (!SCPI_ParamChoice(context, scpi_RpPidInput, &choice, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:ERRor is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetInput(pid, choice);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:ERRor Failed to set error signal: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:ERRor Successfully set error signal.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDInputQ(scpi_t *context) {
+    int result;
+    const char *input_name;
+    rp_pid_input_t input;
+    rp_pid_t pid;
+
+    /* Parse PID index */
+    result = RP_ParsePIDArgv(context, &pid);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:ERRor? Failed to parse input/output choice: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetInput(pid, &input);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:OUT#:ERRor? Failed to get error signal: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ChoiceToName(scpi_RpPidInput, input, &input_name)) {
+        RP_LOG(LOG_ERR,"*PID:IN#:OUT#:ERRor? Failed to get error signal name.\n");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, input_name);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:OUT#:ERRor? Successfully returned error signal to client.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQFrequency(scpi_t *context) {
+    int result;
+    scpi_number_t frequency;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:FREQuency Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* Parse first parameter (frequency) */
+    if(!SCPI_ParamNumber(context, scpi_special_numbers_def, &frequency, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:FREQuency Failed to parse first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetIQFrequency(channel, frequency.value);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:FREQuency Failed to set frequency: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:FREQuency Successfully set frequency.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQFrequencyQ(scpi_t *context) {
+    int result;
+    float frequency;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:FREQuency? Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetIQFrequency(channel, &frequency);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:FREQuency? Failed to get frequency: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, frequency);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:FREQuency? Successfully returned frequency value to client.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQPhase(scpi_t *context) {
+    int result;
+    scpi_number_t phase;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:PHASe Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* Parse first parameter (phase) */
+    if(!SCPI_ParamNumber(context, scpi_special_numbers_def, &phase, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:PHASe Failed to parse first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetIQPhase(channel, phase.value);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:PHASe Failed to set phase: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:PHASe Successfully set phase.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQPhaseQ(scpi_t *context) {
+    int result;
+    float phase;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:PHASe? Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetIQPhase(channel, &phase);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:PHASe? Failed to get phase: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, phase);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:PHASe? Successfully returned phase value to client.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQBandwidth(scpi_t *context) {
+    int result;
+    scpi_number_t bandwidth;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:BANDwidth Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* Parse first parameter (bandwidth) */
+    if(!SCPI_ParamNumber(context, scpi_special_numbers_def, &bandwidth, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:BANDwidth Failed to parse first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetIQBandwidth(channel, bandwidth.value);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:BANDwidth Failed to set bandwidth: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:BANDwidth Successfully set bandwidth.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQBandwidthQ(scpi_t *context) {
+    int result;
+    float bandwidth;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:BANDwidth? Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetIQBandwidth(channel, &bandwidth);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:BANDwidth? Failed to get bandwidth: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, bandwidth);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:BANDwidth? Successfully returned bandwidth value to client.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQGain(scpi_t *context) {
+    int result;
+    scpi_number_t gain;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:GAIN Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    /* Parse first parameter (gain) */
+    if(!SCPI_ParamNumber(context, scpi_special_numbers_def, &gain, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:GAIN Failed to parse first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetIQGain(channel, gain.value);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:GAIN Failed to set gain: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:GAIN Successfully set gain.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQGainQ(scpi_t *context) {
+    int result;
+    float gain;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:GAIN? Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetIQGain(channel, &gain);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:GAIN? Failed to get gain: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultDouble(context, gain);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:GAIN? Successfully returned gain value to client.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQReference(scpi_t *context) {
+    int result;
+    int32_t choice;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:REFerence Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+    /* Read first parameter - reference */
+    if (!SCPI_ParamChoice(context, scpi_RpIQRef, &choice, true)) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:REFerence is missing first parameter.\n");
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDSetIQReference(channel, choice);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:REFerence Failed to set reference: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:REFerence Successfully set reference.\n");
+    return SCPI_RES_OK;
+}
+
+scpi_result_t RP_PIDIQReferenceQ(scpi_t *context) {
+    int result;
+    const char *reference_name;
+    rp_iq_ref_t reference;
+    rp_channel_t channel;
+
+    result = RP_ParseChArgv(context, &channel);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:REFerence? Failed to parse input: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    result = rp_PIDGetIQReference(channel, &reference);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*PID:IN#:IQ:REFerence? Failed to get reference: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    if(!SCPI_ChoiceToName(scpi_RpIQRef, reference, &reference_name)) {
+        RP_LOG(LOG_ERR,"*PID:IN#:IQ:REFerence? Failed to get reference name.\n");
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultMnemonic(context, reference_name);
+
+    RP_LOG(LOG_INFO, "*PID:IN#:IQ:REFerence? Successfully returned reference to client.\n");
+    return SCPI_RES_OK;
+}
+
+/* Returns the name of an enum value, or the empty mnemonic if it has none */
+static void RP_ResultChoice(scpi_t *context, const scpi_choice_def_t *options, int32_t value) {
+    const char *name;
+    if(!SCPI_ChoiceToName(options, value, &name)) {
+        name = "";
+    }
+    SCPI_ResultMnemonic(context, name);
+}
+
+scpi_result_t RP_LockboxSnapshotQ(scpi_t *context) {
+    rp_lockbox_snapshot_t snapshot;
+
+    int result = rp_GetLockboxSnapshot(&snapshot);
+    if(result != RP_OK) {
+        RP_LOG(LOG_ERR, "*LOCKbox:SNAPshot? Failed to read snapshot: %s\n", rp_GetError(result));
+        return SCPI_RES_ERR;
+    }
+
+    const rp_lockbox_params_t *params = &snapshot.params;
+    for(int i = 0; i < 4; i++) {
+        SCPI_ResultFloat(context, params->pid_setpoint[i]);
+        SCPI_ResultFloat(context, params->pid_kp[i]);
+        SCPI_ResultFloat(context, params->pid_ki[i]);
+        SCPI_ResultFloat(context, params->pid_kd[i]);
+        SCPI_ResultFloat(context, params->pid_kii[i]);
+        SCPI_ResultFloat(context, params->pid_kg[i]);
+        SCPI_ResultBool(context, params->pid_int_reset[i]);
+        SCPI_ResultBool(context, params->pid_inverted[i]);
+        SCPI_ResultBool(context, params->pid_reset_when_railed[i]);
+        SCPI_ResultBool(context, params->pid_hold[i]);
+        SCPI_ResultBool(context, params->pid_relock_enabled[i]);
+        SCPI_ResultBool(context, params->pid_enabled[i]);
+        SCPI_ResultFloat(context, params->pid_relock_stepsize[i]);
+        SCPI_ResultFloat(context, params->pid_relock_minimum[i]);
+        SCPI_ResultFloat(context, params->pid_relock_maximum[i]);
+        RP_ResultChoice(context, scpi_RpAinput, params->pid_relock_input[i]);
+        SCPI_ResultBool(context, params->pid_lso_enabled[i]);
+        SCPI_ResultBool(context, params->pid_ext_reset_enabled[i]);
+        RP_ResultChoice(context, scpi_RpDpin, params->pid_ext_reset_input[i]);
+        SCPI_ResultBool(context, snapshot.pid_lock_status[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        SCPI_ResultFloat(context, params->limit_min[i]);
+        SCPI_ResultFloat(context, params->limit_max[i]);
+        SCPI_ResultBool(context, params->gen_enabled[i]);
+        SCPI_ResultBool(context, params->gen_poffset_enabled[i]);
+        SCPI_ResultFloat(context, params->gen_amp[i]);
+        SCPI_ResultFloat(context, params->gen_offset[i]);
+        SCPI_ResultFloat(context, params->gen_freq[i]);
+        RP_ResultChoice(context, scpi_RpWForm, params->gen_waveform[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        SCPI_ResultFloat(context, snapshot.in_voltage[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        SCPI_ResultFloat(context, snapshot.out_voltage[i]);
+    }
+    for(int i = 0; i < 4; i++) {
+        SCPI_ResultFloat(context, snapshot.ain_voltage[i]);
+    }
+
+    RP_LOG(LOG_INFO, "*LOCKbox:SNAPshot? Successfully returned snapshot to client.\n");
+    return SCPI_RES_OK;
+}
@@ -23,6 +23,8 @@ scpi_result_t RP_PIDKii(scpi_t *context);
 scpi_result_t RP_PIDKiiQ(scpi_t *context);
 scpi_result_t RP_PIDKd(scpi_t *context);
 scpi_result_t RP_PIDKdQ(scpi_t *context);
+scpi_result_t RP_PIDParams(scpi_t *context);
+scpi_result_t RP_PIDParamsQ(scpi_t *context);
 scpi_result_t RP_PIDIntReset(scpi_t *context);
 scpi_result_t RP_PIDIntResetQ(scpi_t *context);
 scpi_result_t RP_PIDInverted(scpi_t *context);
@@ -33,6 +35,8 @@ scpi_result_t RP_PIDResetWhenRailed(scpi_t *context);
 scpi_result_t RP_PIDResetWhenRailedQ(scpi_t *context);
 scpi_result_t RP_PIDRelock(scpi_t *context);
 scpi_result_t RP_PIDRelockQ(scpi_t *context);
+scpi_result_t RP_PIDLockStatsQ(scpi_t *context);
+scpi_result_t RP_PIDLockStatsReset(scpi_t *context);
 scpi_result_t RP_PIDRelockStepsize(scpi_t *context);
 scpi_result_t RP_PIDRelockStepsizeQ(scpi_t *context);
 scpi_result_t RP_PIDRelockMin(scpi_t *context);
@@ -41,6 +45,22 @@ scpi_result_t RP_PIDRelockMax(scpi_t *context);
 scpi_result_t RP_PIDRelockMaxQ(scpi_t *context);
 scpi_result_t RP_PIDRelockInput(scpi_t *context);
 scpi_result_t RP_PIDRelockInputQ(scpi_t *context);
+scpi_result_t RP_PIDInput(scpi_t *context);
+scpi_result_t RP_PIDInputQ(scpi_t *context);
+scpi_result_t RP_PIDIQFrequency(scpi_t *context);
+scpi_result_t RP_PIDIQFrequencyQ(scpi_t *context);
+scpi_result_t RP_PIDIQPhase(scpi_t *context);
+scpi_result_t RP_PIDIQPhaseQ(scpi_t *context);
+scpi_result_t RP_PIDIQBandwidth(scpi_t *context);
+scpi_result_t RP_PIDIQBandwidthQ(scpi_t *context);
+scpi_result_t RP_PIDIQGain(scpi_t *context);
+scpi_result_t RP_PIDIQGainQ(scpi_t *context);
+scpi_result_t RP_PIDIQReference(scpi_t *context);
+scpi_result_t RP_PIDIQReferenceQ(scpi_t *context);
 scpi_result_t RP_SaveLockboxConfig(scpi_t *context);
 scpi_result_t RP_LoadLockboxConfig(scpi_t *context);
+scpi_result_t RP_LockboxSnapshotQ(scpi_t *context);
+scpi_result_t RP_PresetStore(scpi_t *context);
+scpi_result_t RP_PresetApply(scpi_t *context);
+scpi_result_t RP_PresetDelete(scpi_t *context);
 #endif /* PID_H_ */
@@ -21,12 +21,14 @@
 
 #include "api_cmd.h"
 #include "common.h"
+#include "connection.h"
 #include "dpin.h"
 #include "apin.h"
 #include "acquire.h"
 #include "generate.h"
 #include "pid.h"
 #include "limit.h"
+#include "bode.h"
 #include "scpi/error.h"
 #include "scpi/ieee488.h"
 #include "scpi/minimal.h"
@@ -40,24 +42,11 @@ bool RST_executed = FALSE;
  */
 size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
 
-    size_t total = 0;
-
+    // Queued on the connection, sent by the event loop
     if (context->user_context != NULL) {
-        int fd = *(int *)(context->user_context);
-        while (len > 0) {
-            size_t written =  write(fd, data, len);
-            if (written < 0) {
-                syslog(LOG_ERR,
-                    "Failed to write into the socket. Should send %zu bytes. Could send only %zu bytes",
-                    len, written);
-                return total;
-            }
-            len -= written;
-            data += written;
-            total += written;
-        }
+        return RP_ConnectionWrite(context->user_context, data, len);
     }
-    return total;
+    return 0;
 }
 
 scpi_result_t SCPI_Flush(scpi_t * context) {
@@ -157,6 +146,7 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "ACQ:AVG?", .callback                   = RP_AcqAveragingQ,},
     {.pattern = "ACQ:TRIG", .callback                   = RP_AcqTriggerSrc,},
     {.pattern = "ACQ:TRIG:STAT?", .callback             = RP_AcqTriggerSrcQ,},
+    {.pattern = "ACQ:TRIG:WAIT?", .callback             = RP_AcqTriggerWaitQ,},
     {.pattern = "ACQ:TRIG:DLY", .callback               = RP_AcqTriggerDelay,},
     {.pattern = "ACQ:TRIG:DLY?", .callback              = RP_AcqTriggerDelayQ,},
     {.pattern = "ACQ:TRIG:DLY:NS", .callback            = RP_AcqTriggerDelayNs,},
@@ -178,6 +168,14 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "ACQ:SOUR#:DATA?", .callback            = RP_AcqDataOldestAllQ,},
     {.pattern = "ACQ:SOUR#:DATA:LAT:N?", .callback      = RP_AcqLatestDataQ,},
     {.pattern = "ACQ:BUF:SIZE?", .callback              = RP_AcqBufferSizeQ,},
+    {.pattern = "ACQ:SOUR#:STREAM", .callback           = RP_AcqStream,},
+    {.pattern = "ACQ:SOUR#:STREAM?", .callback          = RP_AcqStreamQ,},
+    {.pattern = "ACQ:SOUR#:PSD:START", .callback        = RP_AcqPsdStart,},
+    {.pattern = "ACQ:PSD:STOP", .callback               = RP_AcqPsdStop,},
+    {.pattern = "ACQ:PSD:STAT?", .callback              = RP_AcqPsdStateQ,},
+    {.pattern = "ACQ:PSD:DATA?", .callback              = RP_AcqPsdDataQ,},
+    {.pattern = "ACQ:PSD:BINW?", .callback              = RP_AcqPsdBinWidthQ,},
+    {.pattern = "ACQ:PSD:COUNT?", .callback             = RP_AcqPsdCountQ,},
 
     /* Generate */
     {.pattern = "GEN:RST", .callback                    = RP_GenReset,},
@@ -209,6 +207,13 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "SOUR#:TRIG:SOUR?", .callback           = RP_GenTriggerSourceQ,},
     {.pattern = "SOUR#:TRIG:IMM", .callback             = RP_GenTrigger,},
 
+    /* Transfer function analyzer */
+    {.pattern = "SOUR#:BODE:START", .callback           = RP_BodeStart,},
+    {.pattern = "BODE:STOP", .callback                  = RP_BodeStop,},
+    {.pattern = "BODE:STAT?", .callback                 = RP_BodeStateQ,},
+    {.pattern = "BODE:COUNT?", .callback                = RP_BodeCountQ,},
+    {.pattern = "BODE:DATA?", .callback                 = RP_BodeDataQ,},
+
     /* PID */
     {.pattern = "PID:IN#:OUT#:SETPoint", .callback              = RP_PIDSetpoint,},
     {.pattern = "PID:IN#:OUT#:SETPoint?", .callback             = RP_PIDSetpointQ,},
@@ -222,6 +227,8 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "PID:IN#:OUT#:KII?", .callback                  = RP_PIDKiiQ,},
     {.pattern = "PID:IN#:OUT#:KD", .callback                    = RP_PIDKd,},
     {.pattern = "PID:IN#:OUT#:KD?", .callback                   = RP_PIDKdQ,},
+    {.pattern = "PID:IN#:OUT#:PARams", .callback                = RP_PIDParams,},
+    {.pattern = "PID:IN#:OUT#:PARams?", .callback               = RP_PIDParamsQ,},
     {.pattern = "PID:IN#:OUT#:HOLD", .callback                  = RP_PIDHold,},
     {.pattern = "PID:IN#:OUT#:HOLD?", .callback                 = RP_PIDHoldQ,},
     {.pattern = "PID:IN#:OUT#:INTegrator:RESet", .callback      = RP_PIDIntReset,},
@@ -240,6 +247,20 @@ static const scpi_command_t scpi_commands[] = {
     {.pattern = "PID:IN#:OUT#:RELock:MAX?", .callback           = RP_PIDRelockMaxQ,},
     {.pattern = "PID:IN#:OUT#:RELock:INPut", .callback          = RP_PIDRelockInput,},
     {.pattern = "PID:IN#:OUT#:RELock:INPut?", .callback         = RP_PIDRelockInputQ,},
+    {.pattern = "PID:IN#:OUT#:LOCK:STATistics?", .callback      = RP_PIDLockStatsQ,},
+    {.pattern = "PID:IN#:OUT#:LOCK:STATistics:RESet", .callback = RP_PIDLockStatsReset,},
+    {.pattern = "PID:IN#:OUT#:ERRor", .callback                 = RP_PIDInput,},
+    {.pattern = "PID:IN#:OUT#:ERRor?", .callback                = RP_PIDInputQ,},
+    {.pattern = "PID:IN#:IQ:FREQuency", .callback               = RP_PIDIQFrequency,},
+    {.pattern = "PID:IN#:IQ:FREQuency?", .callback              = RP_PIDIQFrequencyQ,},
+    {.pattern = "PID:IN#:IQ:PHASe", .callback                   = RP_PIDIQPhase,},
+    {.pattern = "PID:IN#:IQ:PHASe?", .callback                  = RP_PIDIQPhaseQ,},
+    {.pattern = "PID:IN#:IQ:BANDwidth", .callback               = RP_PIDIQBandwidth,},
+    {.pattern = "PID:IN#:IQ:BANDwidth?", .callback              = RP_PIDIQBandwidthQ,},
+    {.pattern = "PID:IN#:IQ:GAIN", .callback                    = RP_PIDIQGain,},
+    {.pattern = "PID:IN#:IQ:GAIN?", .callback                   = RP_PIDIQGainQ,},
+    {.pattern = "PID:IN#:IQ:REFerence", .callback               = RP_PIDIQReference,},
+    {.pattern = "PID:IN#:IQ:REFerence?", .callback              = RP_PIDIQReferenceQ,},
 
     /* Output limiting */
     {.pattern = "OUTput#:LIMit:MIN", .callback  = RP_OutputLimitMin,},
@@ -250,6 +271,10 @@ static const scpi_command_t scpi_commands[] = {
     /* Saving and loading lockbox configuration*/
     {.pattern = "LOCKbox:CONFig:SAVE", .callback = RP_SaveLockboxConfig,},
     {.pattern = "LOCKbox:CONFig:LOAD", .callback = RP_LoadLockboxConfig,},
+    {.pattern = "LOCKbox:SNAPshot?", .callback = RP_LockboxSnapshotQ,},
+    {.pattern = "LOCKbox:PRESet:STORe", .callback = RP_PresetStore,},
+    {.pattern = "LOCKbox:PRESet:APPLy", .callback = RP_PresetApply,},
+    {.pattern = "LOCKbox:PRESet:DELete", .callback = RP_PresetDelete,},
 
     SCPI_CMD_LIST_END
 };
@@ -263,19 +288,44 @@ static scpi_interface_t scpi_interface = {
 };
 
 #define SCPI_INPUT_BUFFER_LENGTH 538688
-static char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
 
-static scpi_reg_val_t scpi_regs[SCPI_REG_COUNT];
 
+/**
+ * Initializes the SCPI context of one client connection.
+ * @param context       Context to initialize
+ * @param user_context  Connection the responses are queued on
+ * @return 0 on success, -1 if out of memory.
+ */
+int RP_ScpiContextInit(scpi_t *context, void *user_context) {
+
+    char *input_buffer = malloc(SCPI_INPUT_BUFFER_LENGTH);
+    scpi_reg_val_t *regs = calloc(SCPI_REG_COUNT, sizeof(scpi_reg_val_t));
+    if (input_buffer == NULL || regs == NULL) {
+        free(input_buffer);
+        free(regs);
+        return -1;
+    }
 
-scpi_t scpi_context = {
-    .cmdlist = scpi_commands,
-    .buffer = {
-        .length = SCPI_INPUT_BUFFER_LENGTH,
-        .data = scpi_input_buffer,
-    },
-    .interface = &scpi_interface,
-    .registers = scpi_regs,
-    .units = scpi_units_def,
-    .idn = {"REDPITAYA", "INSTR2014", NULL, "01-02"},
-};
+    *context = (scpi_t) {
+        .cmdlist = scpi_commands,
+        .buffer = {
+            .length = SCPI_INPUT_BUFFER_LENGTH,
+            .data = input_buffer,
+        },
+        .interface = &scpi_interface,
+        .registers = regs,
+        .units = scpi_units_def,
+        .idn = {"REDPITAYA", "INSTR2014", NULL, "01-02"},
+        .user_context = user_context,
+        .binary_output = false,
+    };
+    SCPI_Init(context);
+    return 0;
+}
+
+void RP_ScpiContextRelease(scpi_t *context) {
+    free(context->buffer.data);
+    free(context->registers);
+    context->buffer.data = NULL;
+    context->registers = NULL;
+}
@@ -19,7 +19,8 @@
 
 #include "scpi/scpi.h"
 
-extern scpi_t scpi_context;
+int RP_ScpiContextInit(scpi_t *context, void *user_context);
+void RP_ScpiContextRelease(scpi_t *context);
 
 
 #endif /* SCPI_COMMANDS_H_ */
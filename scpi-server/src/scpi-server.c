@@ -12,50 +12,48 @@
  * for more details on the language used herein.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 
 #include <netinet/in.h>
-#include <sys/prctl.h>
 #include <errno.h>
 #include <arpa/inet.h>
 #include <signal.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <syslog.h>
+#include <sys/epoll.h>
 
 #include "scpi-commands.h"
+#include "connection.h"
+#include "cmdlog.h"
 #include "common.h"
+#include "stream.h"
 
 #include "scpi/parser.h"
 #include "redpitaya/lockbox.h"
 
-#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
-#define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
-
 #define LISTEN_BACKLOG 50
 #define LISTEN_PORT 5000
-#define MAX_BUFF_SIZE 1024
+#define MAX_EVENTS 16
 
 static bool app_exit = false;
-static char delimiter[] = "\r\n";
+static volatile sig_atomic_t dump_log = 0;
 
 
-static void handleCloseChildEvents()
+static void termSignalHandler(int signum)
 {
-    struct sigaction sigchld_action = {
-            .sa_handler = SIG_DFL,
-            .sa_flags = SA_NOCLDWAIT
-    };
-    sigaction(SIGCHLD, &sigchld_action, NULL);
+    app_exit = true;
+    syslog (LOG_NOTICE, "Received terminate signal. Exiting...");
 }
 
 
-static void termSignalHandler(int signum)
+static void dumpLogSignalHandler(int signum)
 {
-    app_exit = true;
-    syslog (LOG_NOTICE, "Received terminate signal. Exiting...");
+    dump_log = 1;
 }
 
 
@@ -66,134 +64,91 @@ static void installTermSignalHandler()
     action.sa_handler = termSignalHandler;
     sigaction(SIGTERM, &action, NULL);
     sigaction(SIGINT, &action, NULL);
-}
-
-/**
- * Helper method which returns next command position from the buffer.
- * @param buffer     Input buffer
- * @param bufferLen  Input buffer length
- * @return Position of next command within buffer, or -1 if not found.
- */
-static size_t getNextCommand(const char* buffer, size_t bufferLen)
-{
-    size_t delimiterLen = sizeof(delimiter) - 1; // dont count last null char.
-    size_t i = 0;
-    for (i = 0; i < bufferLen; i++) {
-
-        // Find match for end of delimiter
-        if (buffer[i] == delimiter[delimiterLen - 1]) {
-
-            // Now go back checking if all delimiter character matches
-            size_t dist = 0;
-            while (i - dist >= 0 && delimiterLen - dist > 0) {
-                if (buffer[i - dist] != delimiter[delimiterLen - dist - 1]) {
-                    break;
-                }
-                if (delimiterLen - dist - 1 == 0) {
-                    return i + 1; // Position of next command
-                }
 
-                dist++;
-            }
-        }
-    }
-
-    // No match found
-    return -1;
+    // SIGUSR1 writes the recent commands to syslog
+    action.sa_handler = dumpLogSignalHandler;
+    sigaction(SIGUSR1, &action, NULL);
 }
 
-void LogMessage(char *m, size_t len) {
-    const size_t buff_len = 50;
-    char buff[buff_len];
-
-    len = MIN(len, buff_len);
-    strncpy(buff, m, len);
-    buff[len - 1] = '\0';
-
-    RP_LOG(LOG_INFO, "Processing command: %s\n", buff);
+static void closeConnection(int epollfd, connection_t *conn)
+{
+    RP_LOG(LOG_INFO, "Closing connection with client ip %s.", conn->address);
+    epoll_ctl(epollfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    RP_ConnectionFree(conn);
 }
 
 /**
- * This is main method of every child process. Here communication with client is handled.
- * @param connfd The communication port
- * @return
+ * Accepts all pending connections and registers them with the event loop.
+ * @return 0 on success, -1 if accepting failed.
  */
-static int handleConnection(int connfd) {
-    int read_size;
-
-    size_t message_len = MAX_BUFF_SIZE;
-    char *message_buff = malloc(message_len);
-    char buffer[MAX_BUFF_SIZE];
-    size_t msg_end = 0;
-
-    installTermSignalHandler();
-
-    prctl( 1, SIGTERM );
-
-    RP_LOG(LOG_INFO, "Waiting for first client request.");
-
-    //Receive a message from client
-    while( (read_size = recv(connfd , buffer , MAX_BUFF_SIZE , 0)) > 0 )
-    {
-        if (app_exit) {
-            break;
-        }
+static int acceptConnections(int epollfd, int listenfd)
+{
+    while (1) {
+        struct sockaddr_in cliaddr;
+        socklen_t clilen = sizeof(cliaddr);
 
-        // First make sure that message buffer is large enough
-        while (msg_end + read_size >= message_len) {
-            message_len *= 2;
-            message_buff = realloc(message_buff, message_len);
+        int connfd = accept4(listenfd, (struct sockaddr *)&cliaddr, &clilen, SOCK_NONBLOCK);
+        if (connfd == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED) {
+                return 0;
+            }
+            RP_LOG(LOG_ERR, "Failed to accept connection (%s)", strerror(errno));
+            perror("Failed to accept connection\n");
+            return -1;
         }
 
-        // Copy read buffer into message buffer
-        memcpy(message_buff + msg_end, buffer, read_size);
-        msg_end += read_size;
-
-        // Now try to parse each command out
-        char *m = message_buff;
-        size_t pos = -1;
-        while ((pos = getNextCommand(m, msg_end)) != -1) {
-
-            // Log out message
-            LogMessage(m, pos);
-
-            //Parse the message and return response
-            SCPI_Input(&scpi_context, m, pos);
-            m += pos;
-            msg_end -= pos;
+        connection_t *conn = RP_ConnectionNew(connfd, &cliaddr);
+        if (conn == NULL) {
+            RP_LOG(LOG_ERR, "Failed to allocate connection");
+            close(connfd);
+            continue;
         }
 
-        // Move the rest of the message to the beginning of the buffer
-        if (message_buff != m && msg_end > 0) {
-            memmove(message_buff, m, msg_end);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+        if (epoll_ctl(epollfd, EPOLL_CTL_ADD, connfd, &ev) == -1) {
+            RP_LOG(LOG_ERR, "Failed to watch connection (%s)", strerror(errno));
+            close(connfd);
+            RP_ConnectionFree(conn);
+            continue;
         }
 
-        RP_LOG(LOG_INFO, "Waiting for next client request.\n");
+        RP_LOG(LOG_INFO, "Connection with client ip %s established.", conn->address);
     }
+}
 
-    free(message_buff);
-
-    RP_LOG(LOG_INFO, "Closing client connection...");
+/**
+ * Handles readiness of a client socket. While a response is still queued,
+ * the connection is only watched for writability, so a client that does not
+ * read its responses cannot make the server buffer without bound.
+ * @return 0 on success, -1 if the connection must be closed.
+ */
+static int handleConnection(int epollfd, connection_t *conn, uint32_t events)
+{
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        return -1;
+    }
 
-    if(read_size == 0)
-    {
-        RP_LOG(LOG_INFO, "Client is disconnected");
-        return 0;
+    if ((events & EPOLLIN) && RP_ConnectionRead(conn) != 0) {
+        return -1;
     }
-    else if(read_size == -1)
-    {
-        RP_LOG(LOG_ERR, "Receive message failed (%s)", strerror(errno));
-        perror("Receive message failed");
-        return 1;
+
+    if (RP_ConnectionFlush(conn) != 0) {
+        return -1;
     }
-    return 0;
+
+    struct epoll_event ev = {
+        .events = RP_ConnectionPending(conn) ? EPOLLOUT : EPOLLIN,
+        .data.ptr = conn
+    };
+    return epoll_ctl(epollfd, EPOLL_CTL_MOD, conn->fd, &ev);
 }
 
 
 /**
  * Main daemon entrance point. Opens a socket and listens for any incoming connection.
- * When client connects, if forks the conversation into a new socket and the daemon (parent process)
- * waits for another connection. It can handle multiple connections simultaneously.
+ * All connections are served by a single event loop, each with its own SCPI context,
+ * so all clients see the same library state. It can handle multiple connections simultaneously.
  * @param argc  not used
  * @param argv  not used
  * @return
@@ -209,12 +164,17 @@ int main(int argc, char *argv[])
 
     installTermSignalHandler();
 
-    int listenfd = 0, connfd = 0;
-    struct sockaddr_in serv_addr;
-
-    // Handle close child events
-    handleCloseChildEvents();
+    // Signals are only delivered while the event loop waits, never to the
+    // threads of the library or the streaming server
+    sigset_t signals, wait_mask;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, &wait_mask);
 
+    int listenfd = 0, epollfd = 0;
+    struct sockaddr_in serv_addr;
 
     int result = rp_Init();
     if (result != RP_OK) {
@@ -233,13 +193,14 @@ int main(int argc, char *argv[])
     if (result != RP_OK)
         RP_LOG(LOG_ERR, "Failed to load lockbox config from file: %s", rp_GetError(result));
 
-    // user_context will be pointer to socket
-    scpi_context.user_context = NULL;
-    scpi_context.binary_output = false;
-    SCPI_Init(&scpi_context);
+    // Continuous acquisition data is served on a separate port
+    result = RP_StreamStart(STREAM_PORT);
+    if (result != RP_OK) {
+        RP_LOG(LOG_ERR, "Failed to start streaming on port %d", STREAM_PORT);
+    }
 
     // Create a socket
-    listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    listenfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (listenfd == -1)
     {
         RP_LOG(LOG_ERR, "Failed to create a socket (%s)", strerror(errno));
@@ -267,56 +228,59 @@ int main(int argc, char *argv[])
         return (EXIT_FAILURE);
     }
 
+    epollfd = epoll_create1(0);
+    struct epoll_event listen_ev = { .events = EPOLLIN, .data.ptr = NULL };
+    if (epollfd == -1 || epoll_ctl(epollfd, EPOLL_CTL_ADD, listenfd, &listen_ev) == -1)
+    {
+        RP_LOG(LOG_ERR, "Failed to create the event loop (%s)", strerror(errno));
+        perror("Failed to create the event loop");
+        return (EXIT_FAILURE);
+    }
+
     RP_LOG(LOG_INFO, "Server is listening on port %d\n", LISTEN_PORT);
 
-    // Socket is opened and listening on port. Now we can accept connections
-    while(1)
+    // Socket is opened and listening on port. Now we can serve connections
+    while(!app_exit)
     {
-        struct sockaddr_in cliaddr;
-        socklen_t clilen;
-        clilen = sizeof(cliaddr);
+        struct epoll_event events[MAX_EVENTS];
+        int n = epoll_pwait(epollfd, events, MAX_EVENTS, -1, &wait_mask);
 
-        connfd = accept(listenfd, (struct sockaddr *)&cliaddr, &clilen);
-
-        if (app_exit == true) {
-            break;
+        if (dump_log) {
+            dump_log = 0;
+            RP_CmdLogDump();
         }
 
-        if (connfd == -1) {
-            RP_LOG(LOG_ERR, "Failed to accept connection (%s)", strerror(errno));
-            perror("Failed to accept connection\n");
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RP_LOG(LOG_ERR, "Failed to wait for events (%s)", strerror(errno));
+            perror("Failed to wait for events");
             return (EXIT_FAILURE);
         }
 
-        // Fork a child process, which will talk to the client
-        if (!fork()) {
-
-            RP_LOG(LOG_INFO, "Connection with client ip %s established.", inet_ntoa(cliaddr.sin_addr));
-
-            // this is the child process
-            close(listenfd); // child doesn't need the listener
+        for (int i = 0; i < n; i++) {
+            connection_t *conn = events[i].data.ptr;
 
-            scpi_context.user_context = &connfd;
-
-            result = handleConnection(connfd);
-
-            close(connfd);
-
-            RP_LOG(LOG_INFO, "Closing connection with client ip %s.", inet_ntoa(cliaddr.sin_addr));
-
-            if (result == 0) {
-                return(EXIT_SUCCESS);
+            // The listening socket is registered without a connection
+            if (conn == NULL) {
+                if (acceptConnections(epollfd, listenfd) != 0) {
+                    return (EXIT_FAILURE);
+                }
+                continue;
             }
-            else {
-                return(EXIT_FAILURE);
+
+            if (handleConnection(epollfd, conn, events[i].events) != 0) {
+                closeConnection(epollfd, conn);
             }
         }
-
-        close(connfd);
     }
 
+    close(epollfd);
     close(listenfd);
 
+    RP_StreamStop();
+
     result = rp_Release();
     if (result != RP_OK) {
         RP_LOG(LOG_ERR, "Failed to release RP App library: %s", rp_GetError(result));
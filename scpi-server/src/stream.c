@@ -0,0 +1,247 @@
+/**
+ * @brief Red Pitaya Scpi server acquisition streaming implementation
+ *
+ * A single thread of the server process accepts streaming clients one at a
+ * time. While a client is connected, the new samples of every channel with
+ * streaming enabled are copied out of the DDR ring and sent as one block per
+ * poll. A block is only sent if the writer did not overtake the reader while
+ * copying, so every block that arrives is contiguous; lost data shows up as
+ * an increment of the overflow counter in the next header.
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "stream.h"
+#include "common.h"
+
+#include "redpitaya/lockbox.h"
+
+#define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
+
+_Static_assert(sizeof(stream_block_header_t) == 40, "stream header must not be padded");
+
+static pthread_t stream_thread;
+static volatile bool stream_running = false;
+static int stream_listenfd = -1;
+static int16_t stream_data[STREAM_BLOCK_SAMPLES];
+
+
+static int sendBlock(int fd, stream_block_header_t *header, const int16_t *data)
+{
+    struct iovec iov[2] = {
+        { .iov_base = header, .iov_len = sizeof(*header) },
+        { .iov_base = (void *) data, .iov_len = header->samples * sizeof(int16_t) },
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+    while (msg.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        // Skip what was sent
+        while (msg.msg_iovlen > 0 && (size_t) sent >= msg.msg_iov->iov_len) {
+            sent -= msg.msg_iov->iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov->iov_base = (char *) msg.msg_iov->iov_base + sent;
+            msg.msg_iov->iov_len -= sent;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Sends the new samples of one channel.
+ * @return Number of samples sent, or -1 if the client is gone.
+ */
+static int streamChannel(int fd, rp_channel_t channel, uint64_t *sequence)
+{
+    uint32_t pos, size, overflows;
+    if (rp_AcqAxiGetNewData(channel, &pos, &size, &overflows) != RP_OK || size == 0) {
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    size = MIN(size, STREAM_BLOCK_SAMPLES);
+    rp_AcqAxiGetDataRaw(channel, pos, &size, stream_data);
+
+    // Drop the copy if the writer reached it meanwhile; the overflow is
+    // reported with the next block.
+    uint32_t check_pos, check_size, check_overflows;
+    rp_AcqAxiGetNewData(channel, &check_pos, &check_size, &check_overflows);
+    if (check_overflows != overflows) {
+        return 0;
+    }
+    rp_AcqAxiConsume(channel, size);
+
+    uint32_t decimation = 1;
+    rp_AcqGetDecimationFactor(&decimation);
+
+    stream_block_header_t header = {
+        .magic = STREAM_MAGIC,
+        .version = STREAM_VERSION,
+        .channel = channel + 1,
+        .sequence = (*sequence)++,
+        .timestamp_ns = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec,
+        .samples = size,
+        .overflows = overflows,
+        .decimation = decimation,
+    };
+
+    if (sendBlock(fd, &header, stream_data) != 0) {
+        return -1;
+    }
+    return size;
+}
+
+static void handleStreamClient(int fd)
+{
+    bool enabled[2] = { false, false };
+    uint64_t sequence[2] = { 0, 0 };
+
+    while (stream_running) {
+        int sent = 0;
+
+        for (rp_channel_t ch = RP_CH_1; ch <= RP_CH_2; ch++) {
+            bool now_enabled = false;
+            rp_AcqAxiIsEnabled(ch, &now_enabled);
+            if (now_enabled && !enabled[ch]) {
+                // Streaming was enabled by a client;
+                // start reading at the current write position.
+                rp_AcqAxiEnable(ch, true);
+            }
+            enabled[ch] = now_enabled;
+            if (!enabled[ch]) {
+                continue;
+            }
+
+            int result = streamChannel(fd, ch, &sequence[ch]);
+            if (result < 0) {
+                RP_LOG(LOG_INFO, "Streaming client is disconnected (%s)", strerror(errno));
+                return;
+            }
+            sent += result;
+        }
+
+        if (sent == 0) {
+            // Wait for new data, but notice if the client closes the connection
+            struct pollfd pfd = { .fd = fd, .events = POLLIN };
+            if (poll(&pfd, 1, STREAM_POLL_MS) > 0) {
+                char discard[64];
+                if (recv(fd, discard, sizeof(discard), MSG_DONTWAIT) <= 0) {
+                    RP_LOG(LOG_INFO, "Streaming client is disconnected");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void *streamThread(void *arg)
+{
+    RP_LOG(LOG_INFO, "Streaming server is listening on port %d\n", *(int *) arg);
+
+    while (stream_running) {
+        int connfd = accept(stream_listenfd, NULL, NULL);
+        if (connfd == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+
+        int flag = 1;
+        setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        RP_LOG(LOG_INFO, "Streaming client connected.");
+        handleStreamClient(connfd);
+        close(connfd);
+    }
+    return NULL;
+}
+
+/**
+ * Opens the streaming port and starts the streaming thread.
+ * @param port TCP port to listen on
+ * @return RP_OK, or RP_EOOR if the socket could not be opened.
+ */
+int RP_StreamStart(int port)
+{
+    static int listen_port;
+    struct sockaddr_in serv_addr;
+
+    stream_listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (stream_listenfd == -1) {
+        RP_LOG(LOG_ERR, "Failed to create the streaming socket (%s)", strerror(errno));
+        return RP_EOOR;
+    }
+
+    int flag = 1;
+    setsockopt(stream_listenfd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+    memset(&serv_addr, 0, sizeof(serv_addr));
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    serv_addr.sin_port = htons(port);
+
+    if (bind(stream_listenfd, (struct sockaddr *) &serv_addr, sizeof(serv_addr)) == -1
+            || listen(stream_listenfd, 1) == -1) {
+        RP_LOG(LOG_ERR, "Failed to open the streaming port (%s)", strerror(errno));
+        close(stream_listenfd);
+        stream_listenfd = -1;
+        return RP_EOOR;
+    }
+
+    listen_port = port;
+    stream_running = true;
+
+    if (pthread_create(&stream_thread, NULL, streamThread, &listen_port) != 0) {
+        stream_running = false;
+        close(stream_listenfd);
+        stream_listenfd = -1;
+        return RP_EOOR;
+    }
+    return RP_OK;
+}
+
+/**
+ * Stops the streaming thread and closes the streaming port.
+ * @return RP_OK
+ */
+int RP_StreamStop()
+{
+    if (!stream_running) {
+        return RP_OK;
+    }
+    stream_running = false;
+    // Wakes up accept()
+    shutdown(stream_listenfd, SHUT_RDWR);
+    pthread_join(stream_thread, NULL);
+    close(stream_listenfd);
+    stream_listenfd = -1;
+    return RP_OK;
+}
@@ -0,0 +1,43 @@
+/**
+ * @brief Red Pitaya Scpi server acquisition streaming interface
+ *
+ * Serves the AXI (DDR) streaming acquisition of the lockbox library on a
+ * dedicated TCP port. Every connected client receives contiguous binary
+ * blocks of all channels with streaming enabled (ACQ:SOUR<n>:STREAM ON).
+ *
+ * This part of code is written in C programming language.
+ * Please visit http://en.wikipedia.org/wiki/C_(programming_language)
+ * for more details on the language used herein.
+ */
+
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include <stdint.h>
+
+#define STREAM_PORT             5001
+#define STREAM_MAGIC            0x5453424C  // "LBST" in little endian
+#define STREAM_VERSION          1
+#define STREAM_BLOCK_SAMPLES    65536       // Maximum samples per block
+#define STREAM_POLL_MS          1           // Poll interval when no new data is available
+
+/*
+ * Header sent in front of every block, followed by 'samples' signed 16-bit
+ * raw ADC counts. All fields are little endian.
+ */
+typedef struct {
+    uint32_t magic;         // STREAM_MAGIC
+    uint16_t version;       // STREAM_VERSION
+    uint16_t channel;       // 1 or 2
+    uint64_t sequence;      // Block counter of the channel, starts at 0 for every client
+    uint64_t timestamp_ns;  // CLOCK_REALTIME when the block was read from the ring
+    uint32_t samples;       // Number of samples following the header
+    uint32_t overflows;     // Number of times the client fell behind and data was lost
+    uint32_t decimation;    // Decimation factor, sample period is decimation * 8 ns
+    uint32_t reserved;
+} stream_block_header_t;
+
+int RP_StreamStart(int port);
+int RP_StreamStop();
+
+#endif /* STREAM_H_ */
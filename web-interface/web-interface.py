@@ -12,13 +12,27 @@ import sys
 import json
 import logging
 import math
-from bottle import route, run, request, static_file
+import queue
+import threading
+import time
+from socketserver import ThreadingMixIn
+from wsgiref.simple_server import WSGIServer
+from bottle import route, run, request, response, static_file, install
 
 logging.basicConfig()
 LOG = logging.getLogger(__name__)
 
 BASEDIR = os.path.dirname(__file__)
 
+# Interval in s at which the complete lockbox state is read and changes are sent to the clients
+SAMPLE_INTERVAL = 0.1
+# Interval in s at which the lock status is checked; changes are sent immediately
+LOCK_STATUS_INTERVAL = 0.01
+# Interval in s after which a comment is sent to idle event streams
+KEEPALIVE_INTERVAL = 15.
+# Maximum number of events queued for a client before it is sent the complete state instead
+CLIENT_QUEUE_SIZE = 64
+
 # Error codes returned by the API
 ERROR_CODES = {
     1: "RP_EOED. Failed to Open Memory Device.",
@@ -45,7 +59,9 @@ ERROR_CODES = {
     22: "RP_EFWB. Extension module not connected.",
     23: "RP_EMNC. Failed to open config file.",
     24: "RP_EOCF. Incompatible config file version.",
-    25: "RP_EICV. Failed to Open EEPROM Devic."}
+    25: "RP_EICV. Failed to Open EEPROM Devic.",
+    26: "RP_EPNF. Preset does not exist.",
+    27: "RP_ECCF. Config file is corrupted."}
 
 PID_ID = {
     "PID_11": 0, # Input 1 -> Output 1
@@ -59,6 +75,47 @@ AIN_ID = {
     2: "AIN2",
     3: "AIN3"}
 
+class LockboxParams(ctypes.Structure):
+    """Mirror of rp_lockbox_params_t in lockbox.h."""
+    _fields_ = [
+        ("config_version", ctypes.c_int),
+        ("pid_setpoint", ctypes.c_float*4),
+        ("pid_kp", ctypes.c_float*4),
+        ("pid_ki", ctypes.c_float*4),
+        ("pid_kd", ctypes.c_float*4),
+        ("pid_kii", ctypes.c_float*4),
+        ("pid_kg", ctypes.c_float*4),
+        ("pid_int_reset", ctypes.c_bool*4),
+        ("pid_inverted", ctypes.c_bool*4),
+        ("pid_reset_when_railed", ctypes.c_bool*4),
+        ("pid_hold", ctypes.c_bool*4),
+        ("pid_relock_enabled", ctypes.c_bool*4),
+        ("pid_enabled", ctypes.c_bool*4),
+        ("pid_relock_stepsize", ctypes.c_float*4),
+        ("pid_relock_minimum", ctypes.c_float*4),
+        ("pid_relock_maximum", ctypes.c_float*4),
+        ("pid_relock_input", ctypes.c_int*4),
+        ("pid_lso_enabled", ctypes.c_bool*4),
+        ("pid_ext_reset_enabled", ctypes.c_bool*4),
+        ("pid_ext_reset_input", ctypes.c_int*4),
+        ("limit_min", ctypes.c_float*2),
+        ("limit_max", ctypes.c_float*2),
+        ("gen_enabled", ctypes.c_bool*2),
+        ("gen_poffset_enabled", ctypes.c_bool*2),
+        ("gen_amp", ctypes.c_float*2),
+        ("gen_offset", ctypes.c_float*2),
+        ("gen_freq", ctypes.c_float*2),
+        ("gen_waveform", ctypes.c_int*2)]
+
+class LockboxSnapshot(ctypes.Structure):
+    """Mirror of rp_lockbox_snapshot_t in lockbox.h."""
+    _fields_ = [
+        ("params", LockboxParams),
+        ("pid_lock_status", ctypes.c_bool*4),
+        ("in_voltage", ctypes.c_float*2),
+        ("out_voltage", ctypes.c_float*2),
+        ("ain_voltage", ctypes.c_float*4)]
+
 def init_rp_library():
     """Initialize the Red Pitaya lockbox library. Exit the program on failure."""
     retval = RP_LIB.rp_Init()
@@ -520,359 +577,189 @@ def load_parameters():
     if retval != 0:
         LOG.error("Failed to load parameters. Error code: %s", ERROR_CODES[retval])
 
-@route("/_get_values")
-def get_values():
-    ain_voltage = [0., 0., 0., 0.]
-    for i in range(4, 8):
-        ain_voltage[i-4] = ctypes.c_float()
-        retval = RP_LIB.rp_ApinGetValue(i, ctypes.byref(ain_voltage[i-4]))
-        if retval != 0:
-            LOG.error("Failed to get analog input voltage. Error code: %s", ERROR_CODES[retval])
-
-    fast_input_voltage = [0., 0.]
+def get_snapshot():
+    """Read the configuration and the monitored values of the lockbox with a single library
+    call."""
+    snapshot = LockboxSnapshot()
+    with HW_LOCK:
+        retval = RP_LIB.rp_GetLockboxSnapshot(ctypes.byref(snapshot))
+    if retval != 0:
+        LOG.error("Failed to get lockbox snapshot. Error code: %s", ERROR_CODES[retval])
+    return snapshot
+
+def get_lock_status():
+    """Return the lock status of all PIDs as a dict keyed like the values."""
+    lock_status = {}
+    lock = ctypes.c_bool()
+    with HW_LOCK:
+        for pid_name, i in PID_ID.items():
+            retval = RP_LIB.rp_PIDGetLockStatus(i, ctypes.byref(lock))
+            if retval != 0:
+                LOG.error("Failed to get lock status of PID. Error code: %s", ERROR_CODES[retval])
+            lock_status[pid_name.lower() + "_lock_status"] = lock.value
+    return lock_status
+
+def snapshot_values(snapshot):
+    """Return the monitored values of a snapshot as a dict."""
+    values = {}
+    for i in range(4):
+        values["ain{:d}_voltage".format(i)] = snapshot.ain_voltage[i]
     for i in range(2):
-        fast_input_voltage[i] = ctypes.c_float()
-        retval = RP_LIB.rp_GetInVoltage(i, ctypes.byref(fast_input_voltage[i]))
-        if retval != 0:
-            LOG.error("Failed to get fast input voltage. Error code: %s", ERROR_CODES[retval])
-
-    fast_output_voltage = [0., 0.]
+        values["in_{:d}_voltage".format(i+1)] = snapshot.in_voltage[i]
+        values["out_{:d}_voltage".format(i+1)] = snapshot.out_voltage[i]
+    for pid_name, i in PID_ID.items():
+        values[pid_name.lower() + "_lock_status"] = snapshot.pid_lock_status[i]
+    return values
+
+def snapshot_parameters(snapshot):
+    """Return the configuration of a snapshot as a dict."""
+    params = snapshot.params
+
+    parameters = {}
+    for pid_name, i in PID_ID.items():
+        prefix = pid_name.lower() + "_"
+        parameters[prefix + "setpoint"] = params.pid_setpoint[i]
+        parameters[prefix + "kp"] = params.pid_kp[i]
+        parameters[prefix + "ki"] = params.pid_ki[i]
+        parameters[prefix + "kd"] = params.pid_kd[i]*1e9
+        parameters[prefix + "kii"] = params.pid_kii[i]
+        parameters[prefix + "kg"] = params.pid_kg[i]
+        parameters[prefix + "inverted"] = params.pid_inverted[i]
+        parameters[prefix + "hold"] = params.pid_hold[i]
+        parameters[prefix + "int_res"] = params.pid_int_reset[i]
+        parameters[prefix + "int_auto_reset"] = params.pid_reset_when_railed[i]
+        parameters[prefix + "enabled"] = params.pid_enabled[i]
+        parameters[prefix + "relock_min"] = params.pid_relock_minimum[i]
+        parameters[prefix + "relock_max"] = params.pid_relock_maximum[i]
+        parameters[prefix + "relock_slew_rate"] = params.pid_relock_stepsize[i]
+        parameters[prefix + "relock_enabled"] = params.pid_relock_enabled[i]
+        parameters[prefix + "relock_input"] = params.pid_relock_input[i]
+        parameters[prefix + "lso_enabled"] = params.pid_lso_enabled[i]
+        parameters[prefix + "ext_reset_enabled"] = params.pid_ext_reset_enabled[i]
+        parameters[prefix + "ext_reset_input"] = params.pid_ext_reset_input[i]
     for i in range(2):
-        fast_output_voltage[i] = ctypes.c_float()
-        retval = RP_LIB.rp_GetOutVoltage(i, ctypes.byref(fast_output_voltage[i]))
-        if retval != 0:
-            LOG.error("Failed to get fast output voltage. Error code: %s", ERROR_CODES[retval])
+        suffix = "_{:d}".format(i+1)
+        parameters["limit_min" + suffix] = params.limit_min[i]
+        parameters["limit_max" + suffix] = params.limit_max[i]
+        prefix = "sg" + suffix + "_"
+        parameters[prefix + "waveform"] = params.gen_waveform[i]
+        parameters[prefix + "enabled"] = params.gen_enabled[i]
+        parameters[prefix + "poffset_enabled"] = params.gen_poffset_enabled[i]
+        parameters[prefix + "amp"] = params.gen_amp[i]
+        parameters[prefix + "freq"] = params.gen_freq[i]
+        parameters[prefix + "offset"] = params.gen_offset[i]
+    return parameters
+
+class SnapshotCache():
+    """Last read lockbox state, shared by all clients.
+
+    The state consists of the dicts "parameters" and "values". Every client of the event
+    stream has a queue of (name, changes) events; a client that does not keep up is sent the
+    complete state instead of the events it missed."""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.state = {"parameters": {}, "values": {}}
+        self.clients = []
+
+    def get(self, name):
+        """Return a copy of one part of the state."""
+        with self.lock:
+            return dict(self.state[name])
+
+    def update(self, name, new_state):
+        """Merge new entries into one part of the state and send the changed entries to all
+        clients."""
+        with self.lock:
+            state = self.state[name]
+            changes = {key: value for key, value in new_state.items()
+                       if state.get(key) != value}
+            if not changes:
+                return
+            state.update(changes)
+            for client in self.clients:
+                try:
+                    client.put_nowait((name, changes))
+                except queue.Full:
+                    self._resync(client)
+
+    def subscribe(self):
+        """Return a new client queue, which starts with the complete state."""
+        client = queue.Queue(CLIENT_QUEUE_SIZE)
+        with self.lock:
+            self._resync(client)
+            self.clients.append(client)
+        return client
+
+    def unsubscribe(self, client):
+        with self.lock:
+            self.clients.remove(client)
+
+    def _resync(self, client):
+        while not client.empty():
+            client.get_nowait()
+        for name, state in self.state.items():
+            if state:
+                client.put_nowait((name, dict(state)))
+
+def sample():
+    """Read the lockbox state into the cache, forever. The lock status is checked more often
+    than the rest, so that lock losses are shown without delay."""
+    next_sample = time.monotonic()
+    while True:
+        now = time.monotonic()
+        if now >= next_sample:
+            snapshot = get_snapshot()
+            CACHE.update("parameters", snapshot_parameters(snapshot))
+            CACHE.update("values", snapshot_values(snapshot))
+            next_sample += SAMPLE_INTERVAL
+            if next_sample < now:
+                next_sample = now + SAMPLE_INTERVAL
+        else:
+            CACHE.update("values", get_lock_status())
+        time.sleep(LOCK_STATUS_INTERVAL)
 
-    lock_status = [False, False, False, False]
-    for i in range(4):
-        lock_status[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetLockStatus(i, ctypes.byref(lock_status[i]))
-        if retval != 0:
-            LOG.error("Failed to get lock status of PID. Error code: %s",
-                      ERROR_CODES[retval])
-
-    ain_voltage_values = {
-        "ain0_voltage": ain_voltage[0].value,
-        "ain1_voltage": ain_voltage[1].value,
-        "ain2_voltage": ain_voltage[2].value,
-        "ain3_voltage": ain_voltage[3].value,
-        "in_1_voltage": fast_input_voltage[0].value,
-        "in_2_voltage": fast_input_voltage[1].value,
-        "out_1_voltage": fast_output_voltage[0].value,
-        "out_2_voltage": fast_output_voltage[1].value,
-        "pid_11_lock_status": lock_status[0].value,
-        "pid_12_lock_status": lock_status[1].value,
-        "pid_21_lock_status": lock_status[2].value,
-        "pid_22_lock_status": lock_status[3].value
-    }
-    return json.dumps(ain_voltage_values)
+@route("/_get_values")
+def get_values():
+    return json.dumps(CACHE.get("values"))
 
 
 @route("/_get_parameters")
 def get_parameters():
     """Return a json string containing the current lockbox parameters."""
-
-    setpoint = [0., 0., 0., 0.]
-    kp_param = [0., .0, 0., 0.]
-    ki_param = [0., 0., 0., 0.]
-    kd_param = [0., 0., 0., 0.]
-    kii_param = [0., .0, 0., 0.]
-    kg_param = [0., 0., 0., 0.]
-    inverted = [False, False, False, False]
-    hold = [False, False, False, False]
-    int_reset = [False, False, False, False]
-    int_auto = [False, False, False, False]
-    enabled = [False, False, False, False]
-    relock_min = [0., 0., 0., 0.]
-    relock_max = [0., 0., 0., 0.]
-    relock_slew_rate = [0., 0., 0., 0.]
-    relock_enabled = [False, False, False, False]
-    relock_input = [0, 0, 0, 0]
-    lso_enabled = [False, False, False, False]
-    ext_reset_enabled = [False, False, False, False]
-    ext_reset_input = [0, 0, 0, 0]
-    for i in range(4):
-        setpoint[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetSetpoint(i, ctypes.byref(setpoint[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID setpoint. Error code: %s", ERROR_CODES[retval])
-
-        kp_param[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetKp(i, ctypes.byref(kp_param[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID Kp parameter. Error code: %s", ERROR_CODES[retval])
-
-        ki_param[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetKi(i, ctypes.byref(ki_param[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID Ki parameter. Error code: %s", ERROR_CODES[retval])
-
-        kd_param[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetKd(i, ctypes.byref(kd_param[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID Kd parameter. Error code: %s", ERROR_CODES[retval])
-        kd_param[i] = kd_param[i].value*1e9
-
-        kii_param[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetKii(i, ctypes.byref(kii_param[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID Kii parameter. Error code: %s", ERROR_CODES[retval])
-
-        kg_param[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetKg(i, ctypes.byref(kg_param[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID Kg parameter. Error code: %s", ERROR_CODES[retval])
-
-        inverted[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetInverted(i, ctypes.byref(inverted[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID feedback sign. Error code: %s", ERROR_CODES[retval])
-
-        hold[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetHold(i, ctypes.byref(hold[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID internal holding. Error code: %s",
-                      ERROR_CODES[retval])
-
-        int_reset[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetIntReset(i, ctypes.byref(int_reset[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID integrator reset. Error code: %s",
-                      ERROR_CODES[retval])
-
-        int_auto[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetResetWhenRailed(i, ctypes.byref(int_auto[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID automatical integrator reset. Error code: %s",
-                      ERROR_CODES[retval])
-
-        enabled[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetEnable(i, ctypes.byref(enabled[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID enable. Error code: %s",
-                      ERROR_CODES[retval])
-
-        relock_min[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetRelockMinimum(i, ctypes.byref(relock_min[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID minimum relock voltage. Error code: %s",
-                      ERROR_CODES[retval])
-
-        relock_max[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetRelockMaximum(i, ctypes.byref(relock_max[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID maximum relock voltage. Error code: %s",
-                      ERROR_CODES[retval])
-
-        relock_slew_rate[i] = ctypes.c_float()
-        retval = RP_LIB.rp_PIDGetRelockStepsize(i, ctypes.byref(relock_slew_rate[i]))
-        if retval != 0:
-            LOG.error("Failed to get PID relock slew rate. Error code: %s",
-                      ERROR_CODES[retval])
-
-        relock_enabled[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetRelock(i, ctypes.byref(relock_enabled[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID relock feature. Error code: %s",
-                      ERROR_CODES[retval])
-
-        relock_input[i] = ctypes.c_int()
-        retval = RP_LIB.rp_PIDGetRelockInput(i, ctypes.byref(relock_input[i]))
-        if retval != 0:
-            LOG.error("Failed to get analog input of PID relock. Error code: %s",
-                      ERROR_CODES[retval])
-
-        lso_enabled[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetLockStatusOutputEnable(i, ctypes.byref(lso_enabled[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID lock status output enable. Error code: %s",
-                      ERROR_CODES[retval])
-
-        ext_reset_enabled[i] = ctypes.c_bool()
-        retval = RP_LIB.rp_PIDGetExtResetEnable(i, ctypes.byref(ext_reset_enabled[i]))
-        if retval != 0:
-            LOG.error("Failed to get state of PID external reset enable. Error code: %s",
-                      ERROR_CODES[retval])
-
-        ext_reset_input[i] = ctypes.c_int()
-        retval = RP_LIB.rp_PIDGetExtResetInput(i, ctypes.byref(ext_reset_input[i]))
-        if retval != 0:
-            LOG.error("Failed to get digital input of PID reset. Error code: %s",
-                      ERROR_CODES[retval])
-
-    limit_min_1 = ctypes.c_float()
-    retval = RP_LIB.rp_LimitGetMin(0, ctypes.byref(limit_min_1))
-    if retval != 0:
-        LOG.error("Failed to get minimum output limit. Error code: %s", ERROR_CODES[retval])
-    limit_min_2 = ctypes.c_float()
-    retval = RP_LIB.rp_LimitGetMin(1, ctypes.byref(limit_min_2))
-    if retval != 0:
-        LOG.error("Failed to get minimum output limit. Error code: %s", ERROR_CODES[retval])
-
-    limit_max_1 = ctypes.c_float()
-    retval = RP_LIB.rp_LimitGetMax(0, ctypes.byref(limit_max_1))
-    if retval != 0:
-        LOG.error("Failed to get maximum output limit. Error code: %s", ERROR_CODES[retval])
-    limit_max_2 = ctypes.c_float()
-    retval = RP_LIB.rp_LimitGetMax(1, ctypes.byref(limit_max_2))
-    if retval != 0:
-        LOG.error("Failed to get maximum output limit. Error code: %s", ERROR_CODES[retval])
-
-    sg_1_amp = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetAmp(0, ctypes.byref(sg_1_amp))
-    if retval != 0:
-        LOG.error("Failed to get signal generator amplitude. Error code: %s", ERROR_CODES[retval])
-    sg_2_amp = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetAmp(1, ctypes.byref(sg_2_amp))
-    if retval != 0:
-        LOG.error("Failed to get signal generator amplitude. Error code: %s", ERROR_CODES[retval])
-
-    sg_1_freq = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetFreq(0, ctypes.byref(sg_1_freq))
-    if retval != 0:
-        LOG.error("Failed to get signal generator frequency. Error code: %s", ERROR_CODES[retval])
-    sg_2_freq = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetFreq(1, ctypes.byref(sg_2_freq))
-    if retval != 0:
-        LOG.error("Failed to get signal generator frequency. Error code: %s", ERROR_CODES[retval])
-
-    sg_1_offset = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetOffset(0, ctypes.byref(sg_1_offset))
-    if retval != 0:
-        LOG.error("Failed to get signal generator offset. Error code: %s", ERROR_CODES[retval])
-    sg_2_offset = ctypes.c_float()
-    retval = RP_LIB.rp_GenGetOffset(1, ctypes.byref(sg_2_offset))
-    if retval != 0:
-        LOG.error("Failed to get signal generator offset. Error code: %s", ERROR_CODES[retval])
-
-    sg_1_waveform = ctypes.c_int()
-    retval = RP_LIB.rp_GenGetWaveform(0, ctypes.byref(sg_1_waveform))
-    if retval != 0:
-        LOG.error("Failed to get the waveform of the signal generator. Error code: %s",
-                  ERROR_CODES[retval])
-    sg_2_waveform = ctypes.c_int()
-    retval = RP_LIB.rp_GenGetWaveform(1, ctypes.byref(sg_2_waveform))
-    if retval != 0:
-        LOG.error("Failed to get the waveform of the signal generator. Error code: %s",
-                  ERROR_CODES[retval])
-
-    sg_1_enabled = ctypes.c_bool()
-    retval = RP_LIB.rp_GenOutIsEnabled(0, ctypes.byref(sg_1_enabled))
-    if retval != 0:
-        LOG.error("Failed to get if signal generator is enabled. Error code: %s",
-                  ERROR_CODES[retval])
-    sg_2_enabled = ctypes.c_bool()
-    retval = RP_LIB.rp_GenOutIsEnabled(1, ctypes.byref(sg_2_enabled))
-    if retval != 0:
-        LOG.error("Failed to get if signal generator is enabled. Error code: %s",
-                  ERROR_CODES[retval])
-
-    sg_1_poffset_enabled = ctypes.c_bool()
-    retval = RP_LIB.rp_GenPOffsetIsEnabled(0, ctypes.byref(sg_1_poffset_enabled))
-    if retval != 0:
-        LOG.error("Failed to get if signal generator permanent offset is enabled. Error code: %s",
-                  ERROR_CODES[retval])
-    sg_2_poffset_enabled = ctypes.c_bool()
-    retval = RP_LIB.rp_GenPOffsetIsEnabled(1, ctypes.byref(sg_2_poffset_enabled))
-    if retval != 0:
-        LOG.error("Failed to get if signal generator permanent offset is enabled. Error code: %s",
-                  ERROR_CODES[retval])
-
-    parameters = {
-        "pid_11_setpoint": setpoint[0].value,
-        "pid_12_setpoint": setpoint[1].value,
-        "pid_21_setpoint": setpoint[2].value,
-        "pid_22_setpoint": setpoint[3].value,
-        "pid_11_kp": kp_param[0].value,
-        "pid_12_kp": kp_param[1].value,
-        "pid_21_kp": kp_param[2].value,
-        "pid_22_kp": kp_param[3].value,
-        "pid_11_ki": ki_param[0].value,
-        "pid_12_ki": ki_param[1].value,
-        "pid_21_ki": ki_param[2].value,
-        "pid_22_ki": ki_param[3].value,
-        "pid_11_kd": kd_param[0],
-        "pid_12_kd": kd_param[1],
-        "pid_21_kd": kd_param[2],
-        "pid_22_kd": kd_param[3],
-        "pid_11_kii": kii_param[0].value,
-        "pid_12_kii": kii_param[1].value,
-        "pid_21_kii": kii_param[2].value,
-        "pid_22_kii": kii_param[3].value,
-        "pid_11_kg": kg_param[0].value,
-        "pid_12_kg": kg_param[1].value,
-        "pid_21_kg": kg_param[2].value,
-        "pid_22_kg": kg_param[3].value,
-        "pid_11_inverted": inverted[0].value,
-        "pid_12_inverted": inverted[1].value,
-        "pid_21_inverted": inverted[2].value,
-        "pid_22_inverted": inverted[3].value,
-        "pid_11_hold": hold[0].value,
-        "pid_12_hold": hold[1].value,
-        "pid_21_hold": hold[2].value,
-        "pid_22_hold": hold[3].value,
-        "pid_11_int_res": int_reset[0].value,
-        "pid_12_int_res": int_reset[1].value,
-        "pid_21_int_res": int_reset[2].value,
-        "pid_22_int_res": int_reset[3].value,
-        "pid_11_int_auto_reset": int_auto[0].value,
-        "pid_12_int_auto_reset": int_auto[1].value,
-        "pid_21_int_auto_reset": int_auto[2].value,
-        "pid_22_int_auto_reset": int_auto[3].value,
-        "pid_11_enabled": enabled[0].value,
-        "pid_12_enabled": enabled[1].value,
-        "pid_21_enabled": enabled[2].value,
-        "pid_22_enabled": enabled[3].value,
-        "pid_11_relock_min": relock_min[0].value,
-        "pid_12_relock_min": relock_min[1].value,
-        "pid_21_relock_min": relock_min[2].value,
-        "pid_22_relock_min": relock_min[3].value,
-        "pid_11_relock_max": relock_max[0].value,
-        "pid_12_relock_max": relock_max[1].value,
-        "pid_21_relock_max": relock_max[2].value,
-        "pid_22_relock_max": relock_max[3].value,
-        "pid_11_relock_slew_rate": relock_slew_rate[0].value,
-        "pid_12_relock_slew_rate": relock_slew_rate[1].value,
-        "pid_21_relock_slew_rate": relock_slew_rate[2].value,
-        "pid_22_relock_slew_rate": relock_slew_rate[3].value,
-        "pid_11_relock_enabled": relock_enabled[0].value,
-        "pid_12_relock_enabled": relock_enabled[1].value,
-        "pid_21_relock_enabled": relock_enabled[2].value,
-        "pid_22_relock_enabled": relock_enabled[3].value,
-        "pid_11_relock_input": relock_input[0].value,
-        "pid_12_relock_input": relock_input[1].value,
-        "pid_21_relock_input": relock_input[2].value,
-        "pid_22_relock_input": relock_input[3].value,
-        "pid_11_lso_enabled": lso_enabled[0].value,
-        "pid_12_lso_enabled": lso_enabled[1].value,
-        "pid_21_lso_enabled": lso_enabled[2].value,
-        "pid_22_lso_enabled": lso_enabled[3].value,
-        "pid_11_ext_reset_enabled": ext_reset_enabled[0].value,
-        "pid_12_ext_reset_enabled": ext_reset_enabled[1].value,
-        "pid_21_ext_reset_enabled": ext_reset_enabled[2].value,
-        "pid_22_ext_reset_enabled": ext_reset_enabled[3].value,
-        "pid_11_ext_reset_input": ext_reset_input[0].value,
-        "pid_12_ext_reset_input": ext_reset_input[1].value,
-        "pid_21_ext_reset_input": ext_reset_input[2].value,
-        "pid_22_ext_reset_input": ext_reset_input[3].value,
-        "limit_min_1": limit_min_1.value,
-        "limit_min_2": limit_min_2.value,
-        "limit_max_1": limit_max_1.value,
-        "limit_max_2": limit_max_2.value,
-        "sg_1_waveform": sg_1_waveform.value,
-        "sg_2_waveform": sg_2_waveform.value,
-        "sg_1_enabled": sg_1_enabled.value,
-        "sg_2_enabled": sg_2_enabled.value,
-        "sg_1_poffset_enabled": sg_1_poffset_enabled.value,
-        "sg_2_poffset_enabled": sg_2_poffset_enabled.value,
-        "sg_1_amp": sg_1_amp.value,
-        "sg_2_amp": sg_2_amp.value,
-        "sg_1_freq": sg_1_freq.value,
-        "sg_2_freq": sg_2_freq.value,
-        "sg_1_offset": sg_1_offset.value,
-        "sg_2_offset": sg_2_offset.value
-    }
-    return json.dumps(parameters)
+    return json.dumps(CACHE.get("parameters"))
+
+@route("/_events")
+def events():
+    """Stream the lockbox state as server-sent events. The first "parameters" and "values"
+    events contain the complete state, the following ones only the changed entries."""
+    response.content_type = "text/event-stream"
+    response.set_header("Cache-Control", "no-cache")
+    return stream_events(CACHE.subscribe())
+
+def stream_events(client):
+    try:
+        while True:
+            try:
+                name, changes = client.get(timeout=KEEPALIVE_INTERVAL)
+            except queue.Empty:
+                yield ": keepalive\n\n"
+                continue
+            yield "event: {}\ndata: {}\n\n".format(name, json.dumps(changes))
+    finally:
+        CACHE.unsubscribe(client)
+
+def hardware_lock(callback):
+    """Plugin that serializes the library calls of the request handlers."""
+    def wrapper(*args, **kwargs):
+        with HW_LOCK:
+            return callback(*args, **kwargs)
+    return wrapper
+
+class ThreadingWSGIServer(ThreadingMixIn, WSGIServer):
+    """WSGI server that handles every request in its own thread, so that open event streams
+    do not block other requests."""
+    daemon_threads = True
 
 class MockRPLib():
     """Class that simulates the Red Pitaya lockbox library."""
@@ -973,119 +860,37 @@ class MockRPLib():
         LOG.debug("Lockbox configuration loaded")
         return 0
 
-    def rp_PIDGetSetpoint(self, pid, setpoint):
-        LOG.debug("rp_PIDGetSetpoint called")
-        setpoint._obj.value = 1.0
-        return 0
-
-    def rp_PIDGetKp(self, pid, kp):
-        LOG.debug("rp_PIDGetKp called")
-        kp._obj.value = 0.1
-        return 0
-
-    def rp_PIDGetKi(self, pid, ki):
-        LOG.debug("rp_PIDGetKi called")
-        ki._obj.value = 10.0
-        return 0
-
-    def rp_PIDGetKd(self, pid, kd):
-        LOG.debug("rp_PIDGetKd called")
-        kd._obj.value = 1
-        return 0
-
-    def rp_PIDGetInverted(self, pid, inverted):
-        LOG.debug("rp_PIDGetInverted called")
-        inverted._obj.value = True
-        return 0
-
-    def rp_PIDGetHold(self, pid, hold):
-        LOG.debug("rp_PIDGetHold called")
-        hold._obj.value = True
-        return 0
-
-    def rp_PIDGetIntReset(self, pid, int_reset):
-        LOG.debug("rp_PIDGetIntReset called")
-        int_reset._obj.value = True
-        return 0
-
-    def rp_PIDGetResetWhenRailed(self, pid, int_auto):
-        LOG.debug("rp_PIDGetResetWhenRailed called")
-        int_auto._obj.value = True
-        return 0
-
-    def rp_PIDGetRelockMinimum(self, pid, relock_min):
-        LOG.debug("rp_PIDGetRelockMinimum called")
-        relock_min._obj.value = 0.0
-        return 0
-
-    def rp_PIDGetRelockMaximum(self, pid, relock_max):
-        LOG.debug("rp_PIDGetRelockMaximum called")
-        relock_max._obj.value = 7.0
-        return 0
-
-    def rp_PIDGetRelockStepsize(self, pid, relock_slew_rate):
-        LOG.debug("rp_PIDGetRelockStepsize called")
-        relock_slew_rate._obj.value = 500.0
-        return 0
-
-    def rp_PIDGetRelock(self, pid, relock_enabled):
-        LOG.debug("rp_PIDGetRelock called")
-        relock_enabled._obj.value = True
-        return 0
-
-    def rp_PIDGetRelockInput(self, pid, relock_input):
-        LOG.debug("rp_PIDGetRelockInput called")
-        relock_input._obj.value = 5
-        return 0
-
-    def rp_LimitGetMin(self, pid, limit_min):
-        LOG.debug("rp_LimitGetMin called")
-        limit_min._obj.value = -1.0
-        return 0
-
-    def rp_LimitGetMax(self, pid, limit_max):
-        LOG.debug("rp_LimitGetMax called")
-        limit_max._obj.value = 1.0
-        return 0
-
-    def rp_GenGetAmp(self, pid, amp):
-        LOG.debug("rp_GenGetAmp called")
-        amp._obj.value = 1.0
-        return 0
-
-    def rp_GenGetFreq(self, pid, freq):
-        LOG.debug("rp_GenGetFreq called")
-        freq._obj.value = 1000.0
-        return 0
-
-    def rp_GenGetOffset(self, pid, offset):
-        LOG.debug("rp_GenGetOffset called")
-        offset._obj.value = 0.0
-        return 0
-
-    def rp_GenGetWaveform(self, pid, waveform):
-        LOG.debug("rp_GenGetWaveform called")
-        waveform._obj.value = 0
-        return 0
-
-    def rp_GenOutIsEnabled(self, pid, sg_enabled):
-        LOG.debug("rp_GenOutIsEnabled called")
-        sg_enabled._obj.value = True
-        return 0
-
-    def rp_ApinGetValue(self, ain, ain_voltage):
-        LOG.debug("rp_ApinGetValue called")
-        ain_voltage._obj.value = 1.3
-        return 0
-
-    def rp_GetInVoltage(self, input, fast_input_voltage):
-        LOG.debug("rp_GetInVoltage called")
-        fast_input_voltage._obj.value = 0.9
-        return 0
-
-    def rp_GetOutVoltage(self, input, fast_output_voltage):
-        LOG.debug("rp_GetOutVoltage called")
-        fast_output_voltage._obj.value = 0.8
+    def rp_PIDGetLockStatus(self, pid, lock_status):
+        LOG.debug("rp_PIDGetLockStatus called")
+        lock_status._obj.value = False
+        return 0
+
+    def rp_GetLockboxSnapshot(self, snapshot):
+        LOG.debug("rp_GetLockboxSnapshot called")
+        snapshot = snapshot._obj
+        params = snapshot.params
+        for i in range(4):
+            params.pid_setpoint[i] = 1.0
+            params.pid_kp[i] = 0.1
+            params.pid_ki[i] = 10.0
+            params.pid_kd[i] = 1e-9
+            params.pid_inverted[i] = True
+            params.pid_hold[i] = True
+            params.pid_int_reset[i] = True
+            params.pid_reset_when_railed[i] = True
+            params.pid_relock_maximum[i] = 7.0
+            params.pid_relock_stepsize[i] = 500.0
+            params.pid_relock_enabled[i] = True
+            params.pid_relock_input[i] = 5
+            snapshot.ain_voltage[i] = 1.3
+        for i in range(2):
+            params.limit_min[i] = -1.0
+            params.limit_max[i] = 1.0
+            params.gen_amp[i] = 1.0
+            params.gen_freq[i] = 1000.0
+            params.gen_enabled[i] = True
+            snapshot.in_voltage[i] = 0.9
+            snapshot.out_voltage[i] = 0.8
         return 0
 
 try:
@@ -1097,4 +902,9 @@ except OSError as err:
 else:
     init_rp_library()
 
-run(host="0.0.0.0", port=80, quiet=True)
+HW_LOCK = threading.Lock()
+CACHE = SnapshotCache()
+threading.Thread(target=sample, daemon=True).start()
+
+install(hardware_lock)
+run(host="0.0.0.0", port=80, quiet=True, server_class=ThreadingWSGIServer)